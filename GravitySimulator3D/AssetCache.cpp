@@ -0,0 +1,175 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "AssetCache.h"
+#include "TextureArray.h"
+#include "TextureResidency.h"
+#include "TextureStream.h"
+#include <cstdio>
+
+AssetTable<Mesh*>   AssetCache::meshes;
+AssetTable<GLuint>  AssetCache::textures;
+AssetTable<Shader*> AssetCache::shaders;
+
+/******************************************************************************
+*                                                                             *
+*               AssetCache::acquireMesh / acquireTexture / acquireShader      *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param objFile / imageFile / vertexFile, fragmentFile                      *
+*           Files the asset is loaded from, which are also its key.           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The asset, or nullptr (0 for textures) if it could not be loaded. Assets   *
+*  which fail to load are not cached, and need not be released.               *
+*                                                                             *
+*******************************************************************************/
+Mesh* AssetCache::acquireMesh(const std::string& objFile)
+{
+	Mesh* mesh = meshes.find(objFile);
+	if(mesh != nullptr)
+		return mesh;
+
+	mesh = Geometry::loadObj(objFile.c_str());
+	addMesh(objFile, mesh);
+	return mesh;
+}
+GLuint AssetCache::acquireTexture(const std::string& imageFile)
+{
+	GLuint texture = textures.find(imageFile);
+	if(texture != 0)
+		return texture;
+
+	GLuint64 bytes = 0;
+	texture = Geometry::loadTexture(imageFile.c_str(), &bytes);
+	addTexture(imageFile, texture, bytes);
+	return texture;
+}
+Shader* AssetCache::acquireShader(const std::string& vertexFile,
+                                  const std::string& fragmentFile)
+{
+	std::string key    = vertexFile + "|" + fragmentFile;
+	Shader*     shader = shaders.find(key);
+	if(shader != nullptr)
+		return shader;
+
+	shader = new Shader(vertexFile, fragmentFile);
+	shaders.insert(key, shader, 0);
+	return shader;
+}
+
+/******************************************************************************
+*                                                                             *
+*                     AssetCache::addMesh / addTexture                        *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param objFile / imageFile                                                 *
+*           Files the asset was loaded from.                                  *
+*  @param mesh / texture                                                      *
+*           Asset, which the cache takes over (ignored if it failed to load). *
+*  @param bytes                                                               *
+*           Size of the texture on the graphics hardware.                     *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetCache::addMesh(const std::string& objFile, Mesh* mesh)
+{
+	if(mesh != nullptr)
+		meshes.insert(objFile, mesh, mesh->vertexBufferSize() + mesh->indexBufferSize());
+}
+void AssetCache::addTexture(const std::string& imageFile, GLuint texture,
+                            GLuint64 bytes)
+{
+	if(texture != 0)
+		textures.insert(imageFile, texture, bytes);
+}
+
+/******************************************************************************
+*                                                                             *
+*               AssetCache::releaseMesh / releaseTexture / releaseShader      *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param mesh / texture / shader                                             *
+*           Asset a reference was taken to.                                   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetCache::releaseMesh(Mesh* mesh)
+{
+	if(mesh != nullptr && meshes.release(mesh))
+	{
+		mesh->cleanUp();
+		delete mesh;
+	}
+}
+void AssetCache::releaseTexture(GLuint texture)
+{
+	if(texture != 0 && textures.release(texture))
+	{
+		TextureResidency::remove(texture);
+		TextureStream::cancel(texture);
+		TextureArray::remove(texture);
+	}
+}
+void AssetCache::releaseShader(Shader* shader)
+{
+	if(shader != nullptr && shaders.release(shader))
+	{
+		glDeleteProgram(shader->getProgram());
+		delete shader;
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                            AssetCache::printStats                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetCache::printStats()
+{
+	fprintf(stdout, "Assets: %u meshes (%u loads, %u shared, %.1f KB), "
+		"%u textures (%u loads, %u shared, %.1f KB), %u shaders\n",
+		meshes.getNumLive(), meshes.getNumLoads(), meshes.getNumHits(),
+		meshes.getLiveBytes() / 1024.0,
+		textures.getNumLive(), textures.getNumLoads(), textures.getNumHits(),
+		textures.getLiveBytes() / 1024.0,
+		shaders.getNumLive());
+	fprintf(stdout, "Textures: %u layers in %u arrays (%.1f KB with free layers)\n",
+		TextureArray::getNumLayers(), TextureArray::getNumArrays(),
+		TextureArray::getNumBytes() / 1024.0);
+	fprintf(stdout, "Texture stream: %u finished, %u queued, %.1f KB in %llu bands "
+		"(%s pixel buffer, %llu stalls)\n",
+		TextureStream::getNumFinished(), TextureStream::getNumQueued(),
+		TextureStream::getNumBytes() / 1024.0,
+		(unsigned long long) TextureStream::getNumBands(),
+		TextureStream::getBuffer().isPersistent() ? "persistent-mapped" : "orphaned",
+		(unsigned long long) TextureStream::getBuffer().getNumStalls());
+	fprintf(stdout, "Texture residency: %.1f of %.1f KB resident, %.2f misses per "
+		"frame (%u last frame), %u promoted, %u evicted\n",
+		TextureResidency::getResidentBytes() / 1024.0,
+		TextureResidency::getBudget() / 1024.0,
+		TextureResidency::getNumFrames() > 0 ?
+			(GLdouble) TextureResidency::getTotalMisses() / TextureResidency::getNumFrames() : 0.0,
+		TextureResidency::getNumMisses(), TextureResidency::getNumPromotions(),
+		TextureResidency::getNumEvictions());
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <string>
+#include <unordered_map>
+#include "Geometry.h"
+#include "Shader.h"
+
+/******************************************************************************
+*                                                                             *
+*                            AssetTable   (class)                             *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  entries                                                                    *
+*          Loaded assets by key, with their reference counts and sizes.       *
+*  keys                                                                       *
+*          Key of every loaded asset, so it can be released by value.         *
+*  numLoads / numHits                                                         *
+*          Assets loaded, and acquisitions served without loading.            *
+*  liveBytes                                                                  *
+*          Size of the assets currently loaded.                               *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Reference counts for one kind of asset. The table never creates or         *
+*  destroys assets itself: find() and insert() hand out references, and      *
+*  release() says when the last one is gone so the caller can destroy it.     *
+*                                                                             *
+*******************************************************************************/
+template<typename T>
+class AssetTable
+{
+public:
+	/* Constructor. */
+	               AssetTable() : numLoads(0), numHits(0), liveBytes(0) {}
+
+	/* Take a reference to the asset loaded under key (T() if none). */
+	T              find(const std::string& key)
+	{
+		typename std::unordered_map<std::string, Entry>::iterator it = entries.find(key);
+		if(it == entries.end())
+			return T();
+		it->second.refs++;
+		numHits++;
+		return it->second.asset;
+	}
+
+	/* Add an asset just loaded under key, with one reference. */
+	void           insert(const std::string& key, T asset, GLuint64 bytes)
+	{
+		Entry entry = { asset, 1, bytes };
+		entries[key] = entry;
+		keys[asset]  = key;
+		numLoads++;
+		liveBytes   += bytes;
+	}
+
+	/* Take another reference to an asset (false if it is not in the table). */
+	bool           retain(T asset)
+	{
+		typename std::unordered_map<T, std::string>::iterator it = keys.find(asset);
+		if(it == keys.end())
+			return false;
+		entries[it->second].refs++;
+		return true;
+	}
+
+	/* Drop a reference; true if it was the last one and asset must go. */
+	bool           release(T asset)
+	{
+		typename std::unordered_map<T, std::string>::iterator it = keys.find(asset);
+		if(it == keys.end())
+			return false;
+		typename std::unordered_map<std::string, Entry>::iterator entry =
+			entries.find(it->second);
+		if(--entry->second.refs > 0)
+			return false;
+		liveBytes -= entry->second.bytes;
+		entries.erase(entry);
+		keys.erase(it);
+		return true;
+	}
+
+	/* Getters. */
+	GLuint         getNumLive()          const   {  return entries.size(); }
+	GLuint         getNumLoads()         const   {  return numLoads;       }
+	GLuint         getNumHits()          const   {  return numHits;        }
+	GLuint64       getLiveBytes()        const   {  return liveBytes;      }
+
+private:
+	struct Entry
+	{
+		T          asset;
+		GLuint     refs;
+		GLuint64   bytes;
+	};
+
+	std::unordered_map<std::string, Entry> entries;
+	std::unordered_map<T, std::string>     keys;
+	GLuint                   numLoads;
+	GLuint                   numHits;
+	GLuint64                 liveBytes;
+};
+
+/******************************************************************************
+*                                                                             *
+*                             AssetCache   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  meshes / textures / shaders                                                *
+*          Reference counted meshes (keyed by OBJ file), textures (keyed by   *
+*          image file, each a layer of a TextureArray), and shader programs   *
+*          (keyed by both source files).                                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Loads every mesh, texture, and shader once, however many bodies use it.    *
+*  Each acquire must be matched by a release (retain adds a reference to an   *
+*  asset already held, such as when a body is copied); the GPU buffers,       *
+*  texture, or program go when the last reference does. Assets loaded         *
+*  elsewhere (see AssetLoader) are handed over with addMesh / addTexture.     *
+*  All calls must be made on the thread owning the GL context.                *
+*                                                                             *
+*******************************************************************************/
+class AssetCache
+{
+public:
+	/* Take a reference to an asset, loading it if it is not cached. */
+	static Mesh*   acquireMesh(const std::string& objFile);
+	static GLuint  acquireTexture(const std::string& imageFile);
+	static Shader* acquireShader(const std::string& vertexFile,
+	                             const std::string& fragmentFile);
+
+	/* Take a reference to a cached asset (nullptr / 0 if not cached). */
+	static Mesh*   findMesh(const std::string& objFile)
+	                                             {  return meshes.find(objFile);     }
+	static GLuint  findTexture(const std::string& imageFile)
+	                                             {  return textures.find(imageFile); }
+
+	/* Cache an asset loaded elsewhere, with one reference to it. */
+	static void    addMesh(const std::string& objFile, Mesh* mesh);
+	static void    addTexture(const std::string& imageFile, GLuint texture,
+	                          GLuint64 bytes);
+
+	/* Take another reference to an asset already held. */
+	static void    retainMesh(Mesh* mesh)        {  meshes.retain(mesh);      }
+	static void    retainTexture(GLuint texture) {  textures.retain(texture); }
+
+	/* Drop a reference, freeing the asset with the last one. */
+	static void    releaseMesh(Mesh* mesh);
+	static void    releaseTexture(GLuint texture);
+	static void    releaseShader(Shader* shader);
+
+	/* Print the number and size of the loaded assets to stdout. */
+	static void    printStats();
+
+private:
+	static AssetTable<Mesh*>   meshes;
+	static AssetTable<GLuint>  textures;
+	static AssetTable<Shader*> shaders;
+};
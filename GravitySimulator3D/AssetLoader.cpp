@@ -0,0 +1,300 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "AssetLoader.h"
+#include "AssetCache.h"
+#include "AssetPack.h"
+#include "TextureResidency.h"
+#include <SDL\SDL_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/******************************************************************************
+*                                                                             *
+*                      AssetLoader::AssetLoader (Constructor)                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param progress                                                            *
+*           Called on the GL thread while loading (may be nullptr).           *
+*  @param context                                                             *
+*           Passed to progress.                                               *
+*  @param numThreads                                                          *
+*           Most decoder threads to run at once.                              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+AssetLoader::AssetLoader(Progress progress, void* context, GLuint numThreads) :
+	progress(progress),
+	context(context),
+	numThreads(std::max(1u, std::min(numThreads, (GLuint) ASSET_LOADER_MAX_THREADS))),
+	nextRequest(0),
+	numAssets(0),
+	seconds(0)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                 AssetLoader::requestMesh / requestTexture                   *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param objFile / imageFile                                                 *
+*           File to be loaded.                                                *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Every file is requested once. One already in the cache is only retained,   *
+*  so it is not decoded again, and one in the asset pack needs no decoding.   *
+*                                                                             *
+*******************************************************************************/
+void AssetLoader::requestMesh(const char* objFile)
+{
+	if(!meshFiles.insert(objFile).second)
+		return;
+	numAssets++;
+
+	Mesh* cached = AssetCache::findMesh(objFile);
+	if(cached != nullptr)
+	{
+		meshes.push_back(cached);
+		return;
+	}
+	Request request;
+	request.path  = objFile;
+	request.mesh   = true;
+	request.texture.numLevels = 0;
+	request.packed = AssetPack::find(PACK_MESH, objFile);
+	requests.push_back(request);
+}
+void AssetLoader::requestTexture(const char* imageFile)
+{
+	if(!imageFiles.insert(imageFile).second)
+		return;
+	numAssets++;
+
+	GLuint cached = AssetCache::findTexture(imageFile);
+	if(cached != 0)
+	{
+		textures.push_back(cached);
+		return;
+	}
+	Request request;
+	request.path  = imageFile;
+	request.mesh   = false;
+	request.texture.numLevels = 0;
+	request.packed = AssetPack::find(PACK_TEXTURE, imageFile);
+	requests.push_back(request);
+}
+
+/******************************************************************************
+*                                                                             *
+*                               AssetLoader::load                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Starts the decoders, then uploads each asset as soon as it is decoded.     *
+*  The upload of one asset overlaps the decoding of the others, so loading    *
+*  takes about as long as the slowest file rather than the sum of them all.   *
+*                                                                             *
+*******************************************************************************/
+void AssetLoader::load()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point frame = start;
+	const GLuint total  = requests.size();
+	const GLuint cached = numAssets - total;
+
+	/* The image libraries load lazily, which is not safe from many threads. */
+	IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG);
+
+	/* Start the decoders. */
+	std::vector<std::thread> threads;
+	nextRequest = 0;
+	for(GLuint i = 0; i < std::min(numThreads, total); i++)
+		threads.push_back(std::thread(&AssetLoader::decodeLoop, this));
+
+	/* Upload the results as they come in, drawing progress in between. */
+	std::vector<GLuint> batch;
+	GLuint uploaded = 0;
+	if(progress != nullptr)
+		progress(context, cached, numAssets);
+	while(uploaded < total)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait_for(lock, std::chrono::milliseconds(LOADING_FRAME_MS),
+				[this] { return !decoded.empty(); });
+			batch.swap(decoded);
+		}
+		for(GLuint i : batch)
+			upload(requests[i]);
+		uploaded += batch.size();
+		batch.clear();
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(progress != nullptr && (uploaded == total ||
+			now - frame >= std::chrono::milliseconds(LOADING_FRAME_MS)))
+		{
+			progress(context, cached + uploaded, numAssets);
+			frame = now;
+		}
+	}
+	for(std::thread& thread : threads)
+		thread.join();
+	requests.clear();
+
+	seconds = std::chrono::duration<GLdouble>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "Loaded %u assets (%u cached) on %u threads in %.2f ms\n",
+		numAssets, cached, (GLuint) threads.size(), 1000.0 * seconds);
+}
+
+/******************************************************************************
+*                                                                             *
+*                            AssetLoader::decodeLoop                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetLoader::decodeLoop()
+{
+	for(;;)
+	{
+		GLuint i = nextRequest.fetch_add(1);
+		if(i >= requests.size())
+			return;
+
+		/* Packed assets are only read in, so their uploads do not stall. */
+		Request& request = requests[i];
+		if(request.packed != nullptr)
+			AssetPack::touch(request.packed);
+		else if(request.mesh)
+			Geometry::parseObj(request.path.c_str(), &request.vertices,
+				&request.indices, &request.levels);
+		else
+			Geometry::decodeTexture(request.path.c_str(), &request.texture,
+				&request.texels);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		decoded.push_back(i);
+		ready.notify_one();
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                              AssetLoader::upload                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param request                                                             *
+*           Request whose decoder has finished.                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Files which failed to load are left out of the cache; the bodies using     *
+*  them will try (and report) them again, as they did before.                 *
+*                                                                             *
+*******************************************************************************/
+void AssetLoader::upload(Request& request)
+{
+	if(request.mesh)
+	{
+		if(request.packed == nullptr && request.vertices.empty())
+			return;
+		Mesh* mesh = request.packed != nullptr ?
+			AssetPack::createMesh(request.packed) :
+			Geometry::createMesh(&request.vertices, &request.indices, &request.levels);
+		AssetCache::addMesh(request.path, mesh);
+		meshes.push_back(mesh);
+		std::vector<Vertex>().swap(request.vertices);
+		std::vector<GLuint>().swap(request.indices);
+		std::vector<MeshLevel>().swap(request.levels);
+	}
+	else
+	{
+		/* Stream the texels up over the next frames, as far as the bodies  *
+		 * need them (see TextureResidency): straight from the pack, or     *
+		 * from the decoded copy, which is kept to stream finer levels.     */
+		GLuint64 bytes   = 0;
+		GLuint   texture = request.packed != nullptr ?
+			TextureResidency::add(request.packed, AssetPack::getTexels(request.packed),
+				NULL, &bytes) :
+			TextureResidency::add(&request.texture, nullptr, &request.texels, &bytes);
+		std::vector<unsigned char>().swap(request.texels);
+		AssetCache::addTexture(request.path, texture, bytes);
+		if(texture != 0)
+			textures.push_back(texture);
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                             AssetLoader::release                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetLoader::release()
+{
+	for(Mesh* mesh : meshes)
+		AssetCache::releaseMesh(mesh);
+	for(GLuint texture : textures)
+		AssetCache::releaseTexture(texture);
+	meshes.clear();
+	textures.clear();
+}
+
+/******************************************************************************
+*                                                                             *
+*                      AssetLoader::~AssetLoader (Destructor)                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+AssetLoader::~AssetLoader()
+{
+	release();
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <SDL\SDL.h>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "Geometry.h"
+#include "AssetPack.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+#define  ASSET_LOADER_MAX_THREADS                                          16
+#define  DEFAULT_LOADER_THREADS     (std::thread::hardware_concurrency())
+/* Milliseconds between two calls of the progress callback. */
+#define  LOADING_FRAME_MS                                                  16
+/* Image and shaders of the loading screen. */
+#define  LOADING_SCREEN_IMAGE                     "res/img/loadingScreen.jpg"
+#define  LOADING_VERTEX_SHADER                       "res/shaders/loading.vs"
+#define  LOADING_FRAGMENT_SHADER                     "res/shaders/loading.fs"
+
+/******************************************************************************
+*                                                                             *
+*                             AssetLoader   (class)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  requests                                                                   *
+*          Every asset requested and not already cached, each with the CPU    *
+*          data its decoder produced (or its entry in the asset pack). The    *
+*          list does not change while the decoders run, and each request is  *
+*          written by one decoder only.                                       *
+*  nextRequest                                                                *
+*          Index of the next request a decoder will take.                     *
+*  decoded                                                                    *
+*          Requests decoded and waiting for their upload (guarded by mutex).  *
+*  meshes / textures                                                          *
+*          References the loader holds to the assets, which keep them in the  *
+*          cache until release().                                             *
+*  progress / context                                                         *
+*          Called on the GL thread with the number of assets loaded so far,   *
+*          at most every LOADING_FRAME_MS, so a loading screen can be drawn.  *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Loads the assets of a system before its bodies are created. The OBJ files  *
+*  are parsed, and the images decoded and given their mip chains, on         *
+*  numThreads threads at once, and each result is queued back to the GL       *
+*  thread, which uploads it and adds it to the AssetCache while the rest are  *
+*  still being decoded. Once load() has returned, every acquire of a          *
+*  requested asset is a cache hit. Textures are only queued for upload, and  *
+*  fill in over the first frames as far as the bodies need (see               *
+*  TextureResidency).                                                         *
+*                                                                             *
+*******************************************************************************/
+class AssetLoader
+{
+public:
+	/* Signature of a progress callback: (context, loaded, total). */
+	typedef void (*Progress)(void* context, GLuint loaded, GLuint total);
+
+	/* Constructor. */
+	               AssetLoader(Progress progress = nullptr,
+	                           void* context = nullptr,
+	                           GLuint numThreads = DEFAULT_LOADER_THREADS);
+
+	/* Ask for an asset to be loaded (requests for the same file are merged). */
+	void           requestMesh(const char* objFile);
+	void           requestTexture(const char* imageFile);
+
+	/* Load everything requested, returning once it is all resident. */
+	void           load();
+	/* Drop the loader's references (after the bodies have taken theirs). */
+	void           release();
+
+	/* Getters. */
+	GLuint         getNumAssets()        const   {  return numAssets;      }
+	GLdouble       getSeconds()          const   {  return seconds;        }
+
+	/* Destructor. */
+	              ~AssetLoader();
+
+private:
+	struct Request
+	{
+		std::string              path;
+		bool                     mesh;
+		std::vector<Vertex>      vertices;
+		std::vector<GLuint>      indices;
+		std::vector<MeshLevel>   levels;
+		PackEntry                texture;
+		std::vector<unsigned char> texels;
+		const PackEntry*         packed;
+	};
+
+	/* Not copyable (owns references). */
+	               AssetLoader(const AssetLoader& rhs);
+	AssetLoader&   operator=(const AssetLoader& rhs);
+
+	/* Loop executed by each of the decoder threads. */
+	void           decodeLoop();
+	/* Upload a decoded request and hand it over to the cache. */
+	void           upload(Request& request);
+
+	Progress                 progress;
+	void*                    context;
+	GLuint                   numThreads;
+	std::vector<Request>     requests;
+	std::unordered_set<std::string> meshFiles;
+	std::unordered_set<std::string> imageFiles;
+	std::atomic<GLuint>      nextRequest;
+	std::mutex               mutex;
+	std::condition_variable  ready;
+	std::vector<GLuint>      decoded;
+	std::vector<Mesh*>       meshes;
+	std::vector<GLuint>      textures;
+	GLuint                   numAssets;
+	GLdouble                 seconds;
+};
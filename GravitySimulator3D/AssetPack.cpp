@@ -0,0 +1,687 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "Display.h"
+#include "Icosphere.h"
+#include "SceneFile.h"
+#include "SystemFile.h"
+#include "TextureArray.h"
+#include "Trail.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_set>
+
+MappedFile        AssetPack::file;
+const PackHeader* AssetPack::header  = nullptr;
+const PackEntry*  AssetPack::entries = nullptr;
+
+/* Round up to the alignment of the blobs of a pack. */
+GLuint64 AssetPack::alignPack(GLuint64 offset)
+{
+	return (offset + PACK_ALIGNMENT - 1) & ~(GLuint64) (PACK_ALIGNMENT - 1);
+}
+
+/* Bytes of one mip level of a packed texture. */
+GLuint64 AssetPack::levelBytes(GLenum format, GLuint width, GLuint height)
+{
+	if(format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+		return (GLuint64) ((width + 3) / 4) * ((height + 3) / 4) * 8;
+	return (GLuint64) width * height * 3;
+}
+
+/* Size of the next mip level down. */
+GLuint AssetPack::nextLevel(GLuint size)
+{
+	return size > 1 ? size / 2 : 1;
+}
+
+/* Whether a path ends in the given extension. */
+static bool hasExtension(const std::string& path, const char* extension)
+{
+	size_t n = strlen(extension);
+	return path.size() >= n && path.compare(path.size() - n, n, extension) == 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              Texture Compression                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  BC1 (DXT1) packs each 4x4 block into two RGB565 end points and a 2-bit     *
+*  index per pixel, choosing between the end points and the two colours a     *
+*  third and two thirds of the way between them. The end points are the       *
+*  corners of the block's colour bounding box, pulled in by a sixteenth of    *
+*  its size, on the diagonal which follows how red and blue vary with green.  *
+*                                                                             *
+*******************************************************************************/
+static GLushort packRgb565(const GLint* c)
+{
+	return (GLushort) ((((c[0] * 31 + 127) / 255) << 11) |
+	                   (((c[1] * 63 + 127) / 255) << 5) |
+	                    ((c[2] * 31 + 127) / 255));
+}
+static void unpackRgb565(GLushort v, GLint* c)
+{
+	c[0] = ((v >> 11) & 31) * 255 / 31;
+	c[1] = ((v >> 5)  & 63) * 255 / 63;
+	c[2] = ( v        & 31) * 255 / 31;
+}
+static void compressBlock(const unsigned char* pixels, GLuint width,
+                          GLuint height, GLuint bx, GLuint by,
+                          unsigned char* out)
+{
+	/* Gather the block, repeating the last row and column at the edges. */
+	GLint block[16][3];
+	for(GLuint i = 0; i < 16; i++)
+	{
+		GLuint x = std::min(bx + i % 4, width - 1);
+		GLuint y = std::min(by + i / 4, height - 1);
+		const unsigned char* p = pixels + ((size_t) y * width + x) * 3;
+		block[i][0] = p[0];
+		block[i][1] = p[1];
+		block[i][2] = p[2];
+	}
+
+	/* Bounding box, and the sign of red and blue against green. */
+	GLint lo[3] = { 255, 255, 255 };
+	GLint hi[3] = { 0, 0, 0 };
+	GLint mean[3] = { 0, 0, 0 };
+	for(GLuint i = 0; i < 16; i++)
+		for(GLuint c = 0; c < 3; c++)
+		{
+			lo[c]    = std::min(lo[c], block[i][c]);
+			hi[c]    = std::max(hi[c], block[i][c]);
+			mean[c] += block[i][c];
+		}
+	GLint covariance[3] = { 0, 0, 0 };
+	for(GLuint i = 0; i < 16; i++)
+		for(GLuint c = 0; c < 3; c += 2)
+			covariance[c] += (16 * block[i][c] - mean[c]) * (16 * block[i][1] - mean[1]);
+	GLint e0[3], e1[3];
+	for(GLuint c = 0; c < 3; c++)
+	{
+		GLint inset = (hi[c] - lo[c]) / 16;
+		bool  flip  = c != 1 && covariance[c] < 0;
+		e0[c] = flip ? lo[c] + inset : hi[c] - inset;
+		e1[c] = flip ? hi[c] - inset : lo[c] + inset;
+	}
+
+	/* The first end point must be the larger for four-colour blocks. */
+	GLushort c0 = packRgb565(e0);
+	GLushort c1 = packRgb565(e1);
+	if(c0 < c1)
+		std::swap(c0, c1);
+
+	GLint palette[4][3];
+	unpackRgb565(c0, palette[0]);
+	unpackRgb565(c1, palette[1]);
+	for(GLuint c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	/* Nearest palette entry for each pixel (all the first if c0 == c1). */
+	GLuint indices = 0;
+	for(GLuint i = 0; i < 16 && c0 != c1; i++)
+	{
+		GLuint best = 0;
+		GLint  bestError = INT_MAX;
+		for(GLuint j = 0; j < 4; j++)
+		{
+			GLint dr = block[i][0] - palette[j][0];
+			GLint dg = block[i][1] - palette[j][1];
+			GLint db = block[i][2] - palette[j][2];
+			GLint error = dr * dr + dg * dg + db * db;
+			if(error < bestError)
+			{
+				best      = j;
+				bestError = error;
+			}
+		}
+		indices |= best << (2 * i);
+	}
+
+	out[0] = (unsigned char) (c0 & 0xff);
+	out[1] = (unsigned char) (c0 >> 8);
+	out[2] = (unsigned char) (c1 & 0xff);
+	out[3] = (unsigned char) (c1 >> 8);
+	out[4] = (unsigned char) (indices & 0xff);
+	out[5] = (unsigned char) ((indices >> 8) & 0xff);
+	out[6] = (unsigned char) ((indices >> 16) & 0xff);
+	out[7] = (unsigned char) (indices >> 24);
+}
+
+/******************************************************************************
+*                                                                             *
+*                            AssetPack::encodeTexture                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param image                                                               *
+*           Image from Geometry::decodeImage (may be NULL). It is freed.      *
+*  @param path                                                                *
+*           Path the image was decoded from.                                  *
+*  @param compress                                                            *
+*           Whether to store the levels as BC1.                               *
+*  @param entry / blob                                                        *
+*           Filled with the texture's entry and its mip levels.               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the image was decoded.                                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Converts the image to RGB (so bitmaps, which SDL reads as BGR, need no     *
+*  special case) and halves it with a 2x2 box filter down to 1x1. Safe from   *
+*  any thread, so images loaded from their files are encoded by the loader's *
+*  decoders the same way before going into a TextureArray.                    *
+*                                                                             *
+*******************************************************************************/
+bool AssetPack::encodeTexture(SDL_Surface* image, const std::string& path,
+                              bool compress, PackEntry* entry,
+                              std::vector<unsigned char>* blob)
+{
+	if(image == NULL)
+		return false;
+	SDL_Surface* rgb = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGB24, 0);
+	SDL_FreeSurface(image);
+	if(rgb == NULL)
+	{
+		std::cerr << "AssetPack: could not convert " << path << std::endl;
+		return false;
+	}
+
+	/* Top level, without the padding at the end of each row. */
+	GLuint width  = rgb->w;
+	GLuint height = rgb->h;
+	std::vector<unsigned char> level((size_t) width * height * 3);
+	for(GLuint y = 0; y < height; y++)
+		memcpy(&level[(size_t) y * width * 3],
+		       (const unsigned char*) rgb->pixels + (size_t) y * rgb->pitch,
+		       width * 3);
+	SDL_FreeSurface(rgb);
+
+	entry->format    = compress ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB;
+	entry->width     = width;
+	entry->height    = height;
+	entry->numLevels = 0;
+	blob->clear();
+	for(;;)
+	{
+		/* Store this level. */
+		size_t start = blob->size();
+		blob->resize((size_t) alignPack(start + levelBytes(entry->format, width, height)), 0);
+		if(compress)
+		{
+			unsigned char* out = &(*blob)[start];
+			for(GLuint by = 0; by < height; by += 4)
+				for(GLuint bx = 0; bx < width; bx += 4, out += 8)
+					compressBlock(level.data(), width, height, bx, by, out);
+		}
+		else
+			memcpy(&(*blob)[start], level.data(), level.size());
+		entry->numLevels++;
+		if(width == 1 && height == 1)
+			break;
+
+		/* Halve it for the next. */
+		GLuint w = nextLevel(width);
+		GLuint h = nextLevel(height);
+		std::vector<unsigned char> next((size_t) w * h * 3);
+		for(GLuint y = 0; y < h; y++)
+			for(GLuint x = 0; x < w; x++)
+			{
+				GLuint x0 = std::min(2 * x, width - 1),  x1 = std::min(2 * x + 1, width - 1);
+				GLuint y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+				for(GLuint c = 0; c < 3; c++)
+					next[((size_t) y * w + x) * 3 + c] = (unsigned char) ((
+						level[((size_t) y0 * width + x0) * 3 + c] +
+						level[((size_t) y0 * width + x1) * 3 + c] +
+						level[((size_t) y1 * width + x0) * 3 + c] +
+						level[((size_t) y1 * width + x1) * 3 + c] + 2) / 4);
+			}
+		level.swap(next);
+		width  = w;
+		height = h;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             readMesh / readShader                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           OBJ file or shader source to be packed.                           *
+*  @param entry / blob                                                        *
+*           Filled with the asset's entry and its data.                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file was read.                                                 *
+*                                                                             *
+*******************************************************************************/
+static bool readMesh(const std::string& path, PackEntry* entry,
+                     std::vector<unsigned char>* blob)
+{
+	std::vector<Vertex>    vertices;
+	std::vector<GLuint>    indices;
+	std::vector<MeshLevel> levels;
+	if(!Geometry::parseObj(path.c_str(), &vertices, &indices, &levels))
+		return false;
+
+	/* Indices are stored in the type the mesh is drawn with. */
+	GLenum indexType  = Mesh::chooseIndexType(vertices.size());
+	size_t indexSize  = indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+	size_t indexStart = (size_t) AssetPack::alignPack(vertices.size() * sizeof(Vertex));
+	size_t levelStart = (size_t) AssetPack::alignPack(indexStart + indices.size() * indexSize);
+	blob->assign(levelStart + levels.size() * sizeof(MeshLevel), 0);
+	memcpy(blob->data() + levelStart, levels.data(), levels.size() * sizeof(MeshLevel));
+	if(!vertices.empty())
+		memcpy(blob->data(), vertices.data(), vertices.size() * sizeof(Vertex));
+	if(indexType == GL_UNSIGNED_INT && !indices.empty())
+		memcpy(blob->data() + indexStart, indices.data(), indices.size() * sizeof(GLuint));
+	else
+		for(size_t i = 0; i < indices.size(); i++)
+			((GLushort*) (blob->data() + indexStart))[i] = (GLushort) indices[i];
+	entry->format      = indexType;
+	entry->numLevels   = levels.size();
+	entry->numVertices = vertices.size();
+	entry->numIndices  = indices.size();
+	entry->indexOffset = indexStart;
+	entry->levelOffset = levelStart;
+	return true;
+}
+static bool readShader(const std::string& path, std::vector<unsigned char>* blob)
+{
+	std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+	if(!in)
+	{
+		std::cerr << "AssetPack: could not open " << path << std::endl;
+		return false;
+	}
+	blob->assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	blob->push_back('\0');
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                AssetPack::write                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Pack file to be written.                                          *
+*  @param files                                                               *
+*           Assets to be packed: .obj meshes (or procedural spheres),         *
+*           .vs/.fs shaders, and images.                                      *
+*  @param compress                                                            *
+*           Whether to store the textures as BC1.                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the pack was written. Files which cannot be read are reported and  *
+*  left out, so they are loaded from disk (and reported again) at startup.    *
+*                                                                             *
+*******************************************************************************/
+bool AssetPack::write(const char* path, const std::vector<std::string>& files,
+                      bool compress)
+{
+	std::vector<PackEntry>                  packed;
+	std::vector<std::vector<unsigned char> > blobs;
+	std::vector<char>                       strings;
+	std::unordered_set<std::string>         seen;
+	for(const std::string& name : files)
+	{
+		if(name.empty() || !seen.insert(name).second)
+			continue;
+
+		PackEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		std::vector<unsigned char> blob;
+		bool read;
+		if(hasExtension(name, ".obj") || Icosphere::parseName(name.c_str(), NULL))
+		{
+			entry.type = PACK_MESH;
+			read = readMesh(name, &entry, &blob);
+		}
+		else if(hasExtension(name, ".vs") || hasExtension(name, ".fs"))
+		{
+			entry.type = PACK_SHADER;
+			read = readShader(name, &blob);
+		}
+		else
+		{
+			entry.type = PACK_TEXTURE;
+			read = encodeTexture(Geometry::decodeImage(name.c_str()), name,
+				compress, &entry, &blob);
+		}
+		if(!read)
+		{
+			std::cerr << "AssetPack: leaving out " << name << std::endl;
+			continue;
+		}
+
+		entry.name  = strings.size();
+		entry.bytes = blob.size();
+		strings.insert(strings.end(), name.begin(), name.end());
+		strings.push_back('\0');
+		packed.push_back(entry);
+		blobs.push_back(std::vector<unsigned char>());
+		blobs.back().swap(blob);
+	}
+
+	/* Sort the entries so they can be binary searched. */
+	std::vector<GLuint> order(packed.size());
+	for(GLuint i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b)
+	{
+		if(packed[a].type != packed[b].type)
+			return packed[a].type < packed[b].type;
+		return strcmp(&strings[packed[a].name], &strings[packed[b].name]) < 0;
+	});
+
+	/* Lay out the file: header, entries, blobs, strings. */
+	PackHeader h;
+	memset(&h, 0, sizeof(h));
+	h.magic         = PACK_MAGIC;
+	h.version       = PACK_VERSION;
+	h.numEntries    = packed.size();
+	h.entriesOffset = alignPack(sizeof(PackHeader));
+	GLuint64 offset = alignPack(h.entriesOffset + packed.size() * sizeof(PackEntry));
+	std::vector<PackEntry> sorted;
+	for(GLuint i : order)
+	{
+		PackEntry entry    = packed[i];
+		entry.offset       = offset;
+		entry.indexOffset += offset;
+		entry.levelOffset += offset;
+		offset             = alignPack(offset + entry.bytes);
+		sorted.push_back(entry);
+	}
+	h.stringsOffset = offset;
+	h.stringsBytes  = strings.size();
+	h.fileBytes     = h.stringsOffset + h.stringsBytes;
+
+	std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	std::vector<char> padding(PACK_ALIGNMENT, 0);
+	GLuint64 written = 0;
+	auto put = [&](const void* data, GLuint64 bytes)
+	{
+		out.write((const char*) data, bytes);
+		written += bytes;
+		out.write(padding.data(), alignPack(written) - written);
+		written = alignPack(written);
+	};
+	put(&h, sizeof(h));
+	if(!sorted.empty())
+		put(sorted.data(), sorted.size() * sizeof(PackEntry));
+	GLuint64 packedBytes = 0;
+	for(GLuint i : order)
+	{
+		put(blobs[i].data(), blobs[i].size());
+		packedBytes += blobs[i].size();
+	}
+	out.write(strings.data(), strings.size());
+	out.close();
+	if(!out)
+	{
+		std::cerr << "AssetPack: could not write " << path << std::endl;
+		return false;
+	}
+	fprintf(stdout, "Packed %u assets (%.1f MB) into %s\n", h.numEntries,
+		packedBytes / (1024.0 * 1024.0), path);
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                AssetPack::build                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param output                                                              *
+*           Pack file to be written.                                          *
+*  @param systemFile                                                          *
+*           System file or scene whose meshes and textures are packed.        *
+*  @param compress                                                            *
+*           Whether to store the textures as BC1.                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the pack was written.                                              *
+*                                                                             *
+*******************************************************************************/
+bool AssetPack::build(const char* output, const char* systemFile, bool compress)
+{
+	std::vector<std::string> files;
+	files.push_back(DEFAULT_VERTEX_SHADER);
+	files.push_back(DEFAULT_FRAGMENT_SHADER);
+	files.push_back(TRAIL_VERTEX_SHADER);
+	files.push_back(TRAIL_FRAGMENT_SHADER);
+	files.push_back(PARTICLE_VERTEX_SHADER);
+	files.push_back(PARTICLE_FRAGMENT_SHADER);
+	files.push_back(LOADING_VERTEX_SHADER);
+	files.push_back(LOADING_FRAGMENT_SHADER);
+	files.push_back(LOADING_SCREEN_IMAGE);
+
+	if(SceneFile::isSceneFile(systemFile))
+	{
+		SceneFile scene;
+		if(!scene.open(systemFile))
+			return false;
+		files.push_back(scene.getString(scene.getHeader()->starsMeshFile));
+		files.push_back(scene.getString(scene.getHeader()->starsTextureFile));
+		for(GLuint i = 0; i < scene.getNumBodies(); i++)
+		{
+			files.push_back(scene.getString(scene.getMeshFiles()[i]));
+			files.push_back(scene.getString(scene.getTextureFiles()[i]));
+		}
+	}
+	else
+	{
+		SystemDescription system;
+		if(!SystemFile::parse(systemFile, &system))
+			return false;
+		files.push_back(system.getString(system.starsMeshFile));
+		files.push_back(system.getString(system.starsTextureFile));
+		for(const BodyDescription& body : system.bodies)
+		{
+			files.push_back(system.getString(body.meshFile));
+			files.push_back(system.getString(body.textureFile));
+		}
+	}
+	return write(output, files, compress);
+}
+
+/******************************************************************************
+*                                                                             *
+*                            AssetPack::open / close                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Pack file to be mapped.                                           *
+*  @param required                                                            *
+*           Whether a missing file is an error.                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the pack is mapped and every entry lies inside it.                 *
+*                                                                             *
+*******************************************************************************/
+bool AssetPack::open(const char* path, bool required)
+{
+	close();
+	if(!file.open(path))
+	{
+		if(required)
+			std::cerr << "AssetPack: could not open " << path << std::endl;
+		return false;
+	}
+
+	const unsigned char* data = file.getData();
+	const GLuint64       size = file.getSize();
+	const PackHeader*    h    = (const PackHeader*) data;
+	bool valid = size >= sizeof(PackHeader) && h->magic == PACK_MAGIC &&
+		h->version == PACK_VERSION && h->fileBytes == size &&
+		h->entriesOffset + (GLuint64) h->numEntries * sizeof(PackEntry) <= size &&
+		h->stringsOffset + h->stringsBytes == size && h->stringsBytes > 0 &&
+		data[size - 1] == '\0';
+	for(GLuint i = 0; valid && i < h->numEntries; i++)
+	{
+		const PackEntry& e = ((const PackEntry*) (data + h->entriesOffset))[i];
+		valid = e.name < h->stringsBytes && e.offset + e.bytes <= size;
+		if(valid && e.type == PACK_MESH)
+		{
+			valid = e.offset + (GLuint64) e.numVertices * sizeof(Vertex) <= e.indexOffset &&
+				(e.format == GL_UNSIGNED_SHORT || e.format == GL_UNSIGNED_INT) &&
+				e.indexOffset + (GLuint64) e.numIndices *
+					(e.format == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort)) <= e.levelOffset &&
+				e.levelOffset + (GLuint64) e.numLevels * sizeof(MeshLevel) <= e.offset + e.bytes;
+			const MeshLevel* levels = (const MeshLevel*) (data + e.levelOffset);
+			for(GLuint level = 0; valid && level < e.numLevels; level++)
+				valid = levels[level].firstIndex <= e.numIndices &&
+					levels[level].numIndices <= e.numIndices - levels[level].firstIndex;
+		}
+		else if(valid && e.type == PACK_TEXTURE)
+		{
+			GLuint64 bytes = 0;
+			GLuint   width  = e.width;
+			GLuint   height = e.height;
+			for(GLuint level = 0; level < e.numLevels && level < 32; level++)
+			{
+				bytes += alignPack(levelBytes(e.format, width, height));
+				width  = nextLevel(width);
+				height = nextLevel(height);
+			}
+			valid = e.numLevels > 0 && e.numLevels <= 32 && bytes <= e.bytes;
+		}
+		else if(valid && e.type == PACK_SHADER)
+			valid = e.bytes > 0 && data[e.offset + e.bytes - 1] == '\0';
+	}
+	if(!valid)
+	{
+		std::cerr << "AssetPack: " << path << " is not a valid pack" << std::endl;
+		file.close();
+		return false;
+	}
+
+	header  = h;
+	entries = (const PackEntry*) (data + h->entriesOffset);
+	fprintf(stdout, "Mapped %u packed assets from %s\n", h->numEntries, path);
+	return true;
+}
+void AssetPack::close()
+{
+	file.close();
+	header  = nullptr;
+	entries = nullptr;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                AssetPack::find                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param type                                                                *
+*           PACK_MESH, PACK_TEXTURE, or PACK_SHADER.                          *
+*  @param name                                                                *
+*           Path the asset would otherwise be loaded from.                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The entry, or nullptr if the asset must be loaded from its file.           *
+*                                                                             *
+*******************************************************************************/
+const PackEntry* AssetPack::find(GLuint type, const char* name)
+{
+	if(header == nullptr || name == nullptr)
+		return nullptr;
+
+	const char*      strings = (const char*) file.getData() + header->stringsOffset;
+	const PackEntry* end     = entries + header->numEntries;
+	const PackEntry* entry   = std::lower_bound(entries, end, type,
+		[&](const PackEntry& e, GLuint) -> bool
+	{
+		return e.type != type ? e.type < type : strcmp(strings + e.name, name) < 0;
+	});
+	if(entry == end || entry->type != type || strcmp(strings + entry->name, name) != 0)
+		return nullptr;
+
+	/* Compressed textures need the extension. */
+	if(type == PACK_TEXTURE && entry->format != GL_RGB &&
+		!(entry->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT && GLEW_EXT_texture_compression_s3tc))
+		return nullptr;
+	return entry;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                AssetPack::touch                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry                                                               *
+*           Entry about to be uploaded.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void AssetPack::touch(const PackEntry* entry)
+{
+	const volatile unsigned char* data = file.getData() + entry->offset;
+	unsigned char sum = 0;
+	for(GLuint64 i = 0; i < entry->bytes; i += PACK_PAGE_SIZE)
+		sum += data[i];
+	(void) sum;
+}
+
+/******************************************************************************
+*                                                                             *
+*                       AssetPack::createMesh / createTexture                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry                                                               *
+*           Entry returned by find().                                         *
+*  @param bytes                                                               *
+*           Set to the size of the texture on the graphics hardware.         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The new Mesh, or texture handle (see TextureArray), made straight from the *
+*  mapped pack.                                                               *
+*                                                                             *
+*******************************************************************************/
+Mesh* AssetPack::createMesh(const PackEntry* entry)
+{
+	const unsigned char* data = file.getData();
+	return Geometry::createMesh(entry->numVertices,
+		(const Vertex*) (data + entry->offset), entry->numIndices,
+		entry->format, data + entry->indexOffset, entry->numLevels,
+		(const MeshLevel*) (data + entry->levelOffset));
+}
+GLuint AssetPack::createTexture(const PackEntry* entry, GLuint64* bytes)
+{
+	return TextureArray::add(entry, file.getData() + entry->offset, bytes);
+}
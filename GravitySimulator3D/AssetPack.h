@@ -0,0 +1,159 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <string>
+#include <vector>
+#include "Geometry.h"
+#include "MappedFile.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+#define  PACK_MAGIC                                                0x4b505347
+#define  PACK_VERSION                                                       3
+/* Alignment of every blob of the file. */
+#define  PACK_ALIGNMENT                                                    16
+/* Pack read at startup when no other is given. */
+#define  DEFAULT_ASSET_PACK                               "res/assets.pack"
+/* Kinds of entry. */
+#define  PACK_MESH                                                          0
+#define  PACK_TEXTURE                                                       1
+#define  PACK_SHADER                                                        2
+/* Bytes between two reads of a blob faulted in ahead of its upload. */
+#define  PACK_PAGE_SIZE                                                  4096
+
+/******************************************************************************
+*                                                                             *
+*                        PackHeader / PackEntry   (structs)                   *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Start of an asset pack, followed by numEntries entries sorted by type and  *
+*  then by name, the blobs they point to, and the string table of names (the  *
+*  paths the assets were packed from, which are also their cache keys).       *
+*                                                                             *
+*  A mesh blob is numVertices Vertex records followed, at indexOffset, by     *
+*  numIndices indices of the type in format (GL_UNSIGNED_SHORT unless the     *
+*  mesh needs GL_UNSIGNED_INT), and at levelOffset by its numLevels levels   *
+*  of detail (see MeshLod.h). A texture blob is numLevels mip levels,         *
+*  largest first, each starting on a PACK_ALIGNMENT boundary: tightly packed  *
+*  RGB rows in the order glTexImage2D takes them, or BC1 blocks if format is  *
+*  GL_COMPRESSED_RGB_S3TC_DXT1_EXT, which is also the layout a TextureArray   *
+*  is filled from. A shader blob is its NUL-terminated source.                *
+*                                                                             *
+*******************************************************************************/
+struct PackHeader
+{
+	GLuint                   magic;
+	GLuint                   version;
+	GLuint64                 fileBytes;
+	GLuint                   numEntries;
+	GLuint                   reserved;
+	GLuint64                 entriesOffset;
+	GLuint64                 stringsOffset;
+	GLuint64                 stringsBytes;
+};
+struct PackEntry
+{
+	GLuint                   type;
+	GLuint                   name;
+	/* Textures (and the index type and levels of detail of meshes). */
+	GLuint                   format;
+	GLuint                   numLevels;
+	GLuint                   width;
+	GLuint                   height;
+	/* Meshes. */
+	GLuint                   numVertices;
+	GLuint                   numIndices;
+	GLuint64                 indexOffset;
+	GLuint64                 levelOffset;
+	/* Every entry. */
+	GLuint64                 offset;
+	GLuint64                 bytes;
+};
+
+/******************************************************************************
+*                                                                             *
+*                              AssetPack   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  file                                                                       *
+*          Mapping of the pack, open for the life of the program. Meshes and  *
+*          textures are uploaded straight from it, and entries point into it. *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Single file holding every asset of a system already in the form the        *
+*  graphics hardware takes: meshes parsed and indexed, textures decoded,      *
+*  converted to RGB, and given their mip chains (optionally compressed to     *
+*  BC1), and the shader sources. build() writes one offline; at startup the   *
+*  pack is mapped, and Geometry and Shader look every file up in it before    *
+*  going to the file itself, so loading a packed asset is a binary search     *
+*  and a glBufferData or glTexImage2D from the mapping.                       *
+*                                                                             *
+*  Files missing from the pack, or textures in a format the hardware cannot   *
+*  read, are still loaded from their own files.                               *
+*                                                                             *
+*******************************************************************************/
+class AssetPack
+{
+public:
+	/* Pack every asset a system uses, plus the program's own shaders and   *
+	 * images, compressing the textures if compress is set.                 */
+	static bool    build(const char* output, const char* systemFile,
+	                     bool compress);
+	/* Pack a list of files (the kind of each is told by its extension). */
+	static bool    write(const char* path, const std::vector<std::string>& files,
+	                     bool compress);
+
+	/* Map a pack (quietly doing nothing if it is missing and not required). */
+	static bool    open(const char* path, bool required = true);
+	/* Unmap the pack. */
+	static void    close();
+	static bool    isOpen()                      {  return header != nullptr; }
+
+	/* Entry for a file (nullptr if it is not packed, or is a texture the   *
+	 * hardware cannot read).                                               */
+	static const PackEntry* find(GLuint type, const char* name);
+	/* Read every page of an entry, so its upload does not wait on the disk *
+	 * (safe from any thread).                                              */
+	static void    touch(const PackEntry* entry);
+
+	/* Decode-side half of packing an image: convert it to RGB and give it  *
+	 * its mip chain, as BC1 if compress is set (safe from any thread).     */
+	static bool    encodeTexture(SDL_Surface* image, const std::string& path,
+	                             bool compress, PackEntry* entry,
+	                             std::vector<unsigned char>* blob);
+	/* Bytes of a mip level, the size of the next level down, and an offset *
+	 * rounded up to where the next level or blob starts.                   */
+	static GLuint64 levelBytes(GLenum format, GLuint width, GLuint height);
+	static GLuint  nextLevel(GLuint size);
+	static GLuint64 alignPack(GLuint64 offset);
+
+	/* Upload a packed mesh or texture (GL thread). */
+	static Mesh*   createMesh(const PackEntry* entry);
+	static GLuint  createTexture(const PackEntry* entry, GLuint64* bytes = NULL);
+	/* Source of a packed shader. */
+	static const char* getSource(const PackEntry* entry)
+	{
+		return (const char*) file.getData() + entry->offset;
+	}
+	/* Mip levels of a packed texture, mapped while the pack is open. */
+	static const unsigned char* getTexels(const PackEntry* entry)
+	{
+		return file.getData() + entry->offset;
+	}
+
+private:
+	static MappedFile        file;
+	static const PackHeader* header;
+	static const PackEntry*  entries;
+};
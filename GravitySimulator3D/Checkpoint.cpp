@@ -0,0 +1,187 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Checkpoint.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#ifdef _WIN32
+#define  WIN32_LEAN_AND_MEAN
+#define  NOMINMAX
+#include <windows.h>
+#endif
+
+/******************************************************************************
+*                                                                             *
+*                     CheckpointWriter::CheckpointWriter                      *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Starts the writer thread, which sleeps until a snapshot is submitted.      *
+*                                                                             *
+*******************************************************************************/
+CheckpointWriter::CheckpointWriter() :
+	busy(false), pending(false), quit(false), numWritten(0), numSkipped(0)
+{
+	writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+/******************************************************************************
+*                                                                             *
+*               CheckpointWriter::acquire / submit / wait                     *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Checkpoint file to be replaced (submit only).                     *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The staging buffer, or nullptr if the previous snapshot is still being     *
+*  written, in which case this one is counted as skipped (acquire only).      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A successful acquire() must be followed by submit(); the buffer belongs to *
+*  the writer until the snapshot is on disk.                                  *
+*                                                                             *
+*******************************************************************************/
+std::vector<unsigned char>* CheckpointWriter::acquire()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(busy)
+	{
+		numSkipped++;
+		return nullptr;
+	}
+	busy = true;
+	return &staging;
+}
+void CheckpointWriter::submit(const char* path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->path = path;
+	pending    = true;
+	wake.notify_one();
+}
+void CheckpointWriter::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return !busy; });
+}
+
+/******************************************************************************
+*                                                                             *
+*                        CheckpointWriter::writerLoop                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void CheckpointWriter::writerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for(;;)
+	{
+		wake.wait(lock, [this] { return pending || quit; });
+		if(!pending)
+			break;
+		pending = false;
+
+		/* The buffer and path are left alone while busy. */
+		lock.unlock();
+		bool ok = write();
+		lock.lock();
+
+		if(ok)
+			numWritten++;
+		busy = false;
+		done.notify_all();
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                          CheckpointWriter::write                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the checkpoint was replaced.                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes the staging buffer to a temporary file next to the checkpoint and   *
+*  renames it over the checkpoint in one step (MoveFileEx on Windows, rename  *
+*  elsewhere), so readers only ever see a complete file.                      *
+*                                                                             *
+*******************************************************************************/
+bool CheckpointWriter::write()
+{
+	std::string temp = path + CHECKPOINT_TEMP_SUFFIX;
+
+	std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!staging.empty())
+		out.write((const char*) staging.data(), staging.size());
+	out.close();
+	if(!out)
+	{
+		std::cerr << "Checkpoint: could not write " << temp << std::endl;
+		return false;
+	}
+
+#ifdef _WIN32
+	bool renamed = MoveFileExA(temp.c_str(), path.c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	bool renamed = std::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+	if(!renamed)
+		std::cerr << "Checkpoint: could not replace " << path << std::endl;
+	return renamed;
+}
+
+/******************************************************************************
+*                                                                             *
+*                     CheckpointWriter::~CheckpointWriter                     *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Finishes a submitted snapshot, then stops the writer thread.               *
+*                                                                             *
+*******************************************************************************/
+CheckpointWriter::~CheckpointWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		wake.notify_one();
+	}
+	writer.join();
+}
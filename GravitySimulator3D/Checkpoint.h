@@ -0,0 +1,153 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "OrbitalBody.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+#define  CHECKPOINT_MAGIC                                          0x4b435347
+#define  CHECKPOINT_VERSION                                                 1
+/* Alignment of every section of the file. */
+#define  CHECKPOINT_ALIGNMENT                                              16
+/* Suffix of the file a snapshot is written to before it is renamed. */
+#define  CHECKPOINT_TEMP_SUFFIX                                        ".tmp"
+
+/******************************************************************************
+*                                                                             *
+*                      Checkpoint file layout   (structs)                     *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A checkpoint is a CheckpointHeader, followed by numBodies CheckpointBody   *
+*  records (in the order the system keeps its bodies), the generation of      *
+*  every handle slot, and a table of NUL-terminated strings which the         *
+*  records point into. Every section starts on a CHECKPOINT_ALIGNMENT         *
+*  boundary and holds plain values only, so a restore reads the records       *
+*  straight out of the mapped file. Fields are stored bit for bit, which is   *
+*  what makes a restored run continue exactly as the original would have.    *
+*                                                                             *
+*******************************************************************************/
+struct CheckpointHeader
+{
+	GLuint                   magic;
+	GLuint                   version;
+	GLuint64                 fileBytes;
+	/* Random number generator state (reserved; the system has none yet). */
+	GLuint64                 rngState;
+	/* System. */
+	GLfloat                  clock;
+	GLfloat                  G;
+	GLfloat                  scale;
+	GLuint                   reductionMode;
+	glm::mat4                starsMatrix;
+	GLuint                   starsMeshFile;
+	GLuint                   starsTextureFile;
+	/* Integrator and re-sort schedule. */
+	GLuint                   sortInterval;
+	GLuint                   stepsSinceSort;
+	/* Handles. */
+	GLuint                   numBodies;
+	GLuint                   numSlots;
+	GLuint                   freeSlot;
+	GLuint                   reserved;
+	/* Offsets of the sections. */
+	GLuint64                 bodiesOffset;
+	GLuint64                 slotsOffset;
+	GLuint64                 stringsOffset;
+	GLuint64                 stringsBytes;
+};
+struct CheckpointBody
+{
+	BodyState                state;
+	GLuint                   slot;
+	GLuint                   generation;
+	GLuint                   name;
+	GLuint                   meshFile;
+	GLuint                   textureFile;
+	GLuint                   reserved[3];
+};
+struct CheckpointSlot
+{
+	GLuint                   index;
+	GLuint                   generation;
+};
+
+/******************************************************************************
+*                                                                             *
+*                          CheckpointWriter   (class)                         *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  staging                                                                    *
+*          Buffer the system copies its state into. Owned by the writer       *
+*          thread from submit() until the file has been renamed into place.   *
+*  busy                                                                       *
+*          Whether a snapshot is being written.                               *
+*  numWritten / numSkipped                                                    *
+*          Snapshots written, and snapshots skipped because the previous one  *
+*          was still being written.                                           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes snapshots in the background. The simulation only pays for copying   *
+*  its state into the staging buffer; the writer thread writes it to a        *
+*  temporary file and renames that over the checkpoint, so a crash at any     *
+*  moment leaves either the old checkpoint or the new one, never a mix.       *
+*                                                                             *
+*******************************************************************************/
+class CheckpointWriter
+{
+public:
+	/* Constructor. */
+	               CheckpointWriter();
+
+	/* Buffer to copy a snapshot into (nullptr if the writer is busy). */
+	std::vector<unsigned char>* acquire();
+	/* Write the acquired buffer to path in the background. */
+	void           submit(const char* path);
+	/* Wait for the snapshot being written, if any. */
+	void           wait();
+
+	/* Getters. */
+	GLuint         getNumWritten()       const   {  return numWritten;     }
+	GLuint         getNumSkipped()       const   {  return numSkipped;     }
+
+	/* Destructor. */
+	              ~CheckpointWriter();
+
+private:
+	/* Not copyable (owns a thread). */
+	               CheckpointWriter(const CheckpointWriter& rhs);
+	CheckpointWriter& operator=(const CheckpointWriter& rhs);
+
+	/* Loop executed by the writer thread. */
+	void           writerLoop();
+	/* Write the staging buffer and rename it into place. */
+	bool           write();
+
+	std::vector<unsigned char> staging;
+	std::string              path;
+	std::thread              writer;
+	std::mutex               mutex;
+	std::condition_variable  wake;
+	std::condition_variable  done;
+	bool                     busy;
+	bool                     pending;
+	bool                     quit;
+	GLuint                   numWritten;
+	GLuint                   numSkipped;
+};
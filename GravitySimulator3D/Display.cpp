@@ -9,7 +9,14 @@
 #include <glm\gtx\transform.hpp>
 #include <SDL\SDL_video.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
 #include "Display.h"
+#include "TextureArray.h"
+#include "TextureResidency.h"
 #include "Geometry.h"
 
 /******************************************************************************
@@ -37,7 +44,13 @@
 *  to the hardware-specific implementation (OpenGL acts as an Adapter Class)  *
 *                                                                             *
 *******************************************************************************/
-Display::Display(std::string title, GLushort width, GLushort height) 
+Display::Display(std::string title, GLushort width, GLushort height) :
+	program(0), trailProgram(0), particleProgram(0), particleArray(0),
+	loadingQuad(nullptr), loadingProgram(0), loadingTexture(0),
+	lodPixelScale(1.0f), numFrames(0), trianglesDrawn(0), trianglesFull(0),
+	drawCalls(0), bodiesDrawn(0), bodiesCulled(0), instanced(false),
+	boundProgram(BIND_UNKNOWN), boundArray(BIND_UNKNOWN), boundTexture(BIND_UNKNOWN),
+	bindsIssued(0), bindsSkipped(0)
 {
 
 	/* Create the SDL window. */
@@ -64,6 +77,11 @@ Display::Display(std::string title, GLushort width, GLushort height)
 
 	/* Show the version of GLEW currently being used. */
 	fprintf(stdout, "Stats: Using GLEW %s\n", glewGetString(GLEW_VERSION));
+
+	/* Whether the model matrices the bodies are instanced with are read   *
+	 * per instance (they are streamed either way, see StreamBuffer).      */
+	instanced = GLEW_VERSION_3_3 ||
+		(GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced);
 	
 	/* Update the viewport. */
 	updateViewport();
@@ -155,6 +173,7 @@ void Display::updateViewport()
 
 	/* Update the GLviewport. */
 	glViewport(0, 0, width, height);
+	lodPixelScale = height / (2.0f * (GLfloat) tan(DEFAULT_FOV / 2.0));
 
 	/* Calculate the View-To-Projection matrix. */
 	viewToProjectionMatrix = glm::perspectiveFov((GLfloat) DEFAULT_FOV, 
@@ -168,14 +187,10 @@ void Display::updateViewport()
 *                                                                             *
 *******************************************************************************
 * PARAMETERS                                                                  *
-*  @param red                                                                 *
-*           The amount of red to be painted on the color buffer (0.0 - 1.0)   *
-*  @param green                                                               *
-*           The amount of green to be painted on the color buffer (0.0 - 1.0) *
-*  @param blue                                                                *
-*           The amount of blue to be painted on the color buffer (0.0 - 1.0)  *
-*  @param alpha                                                               *
-*           The opaqueness of the color buffer.                               *
+*  @param list                                                                *
+*           Meshes, textures, matrices and levels of detail of the bodies,    *
+*           their trails, and their particles if they are drawn as such. The  *
+*           levels picked are written back to it.                             *
 *                                                                             *
 *******************************************************************************
 * RETURNS                                                                     *
@@ -183,57 +198,216 @@ void Display::updateViewport()
 *                                                                             *
 *******************************************************************************
 * DESCRIPTION                                                                 *
-*  Function which clears the window by changing all of the pixels to the      *
-*  specified color and opacity.                                               *
+*  Clears the window and draws a frame: the meshes in the view frustum at     *
+*  their levels of detail, then the particles, then the trails, and swaps     *
+*  the double buffer.                                                         *
 *                                                                             *
 *******************************************************************************/
-void Display::repaint(std::vector<Mesh*> meshes,
-                      std::vector<glm::mat4*> modelToWorldMatrices)
+void Display::repaint(const RenderList& list)
 {
+	const Span<Mesh* const>&      meshes               = list.meshes;
+	const Span<const GLuint>&     textures             = list.textures;
+	const Span<glm::mat4* const>& modelToWorldMatrices = list.modelToWorldMatrices;
+	const Span<GLuint>&           lodLevels            = list.lodLevels;
+
 	/* Tell OpenGL to clear the color buffer and depth buffer. */
 	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);	
 
-	/* Get the window dimensions and update the viewport. */
-	updateViewport();
-
 	glEnable(GL_DEPTH_TEST);
 
-	/* Draw 3-D space. */
-	for (GLuint i = 0; i < meshes.size(); i++)
+	/* Other code binds between frames, so start from nothing known. */
+	resetBinds();
+	useProgram(program);
+
+	/* The World -> Proj. transformation is the same for every body. */
+	const glm::mat4 worldToViewMatrix = camera.getWorldToViewMatrix();
+	const glm::mat4 worldToProjectionMatrix =
+		viewToProjectionMatrix *           // View  -> Proj.
+		worldToViewMatrix;                 // World -> View
+	glUniformMatrix4fv(worldToProjectionUniformLocation, 1, GL_FALSE,
+		&worldToProjectionMatrix[0][0]);
+
+	/* Bodies given as particles are drawn as such, after the meshes. */
+	const bool   particles = particleProgram != 0 && !list.particles.empty();
+	const GLuint numMeshes = meshes.size - (particles ? list.particles.size : 0);
+
+	/* Cull the bounding spheres of the meshes against the view frustum.   */
+	frustum.extract(worldToProjectionMatrix);
+	spheres.resize(numMeshes);
+	visible.resize(numMeshes);
+	for(GLuint i = 0; i < numMeshes; i++)
 	{
-		/* Generate the Model -> Proj. transformation. */
-		modelToProjectionMatrix = 
-			viewToProjectionMatrix *           // View  -> Proj.
-            camera.getWorldToViewMatrix() *	   // World -> View 
-            *(modelToWorldMatrices.at(i));     // Model -> World
-
-		/* Bind the appropriate Vertex Array. */
-		glBindVertexArray(meshes.at(i)->getVertexArrayID());
-
-		/* Bind the appropriate Index Array. */
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshes.at(i)->getBufferIDs()[1]);
-
-		/* If a texture has been generated, bind the Texture ID. */
-		if (meshes.at(i)->getTextureID() != -1)
-			glBindTexture(GL_TEXTURE_2D, meshes.at(i)->getTextureID());
+		const glm::mat4& m = *modelToWorldMatrices[i];
+		GLfloat scale = std::max(glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+			std::max(glm::dot(glm::vec3(m[1]), glm::vec3(m[1])),
+			         glm::dot(glm::vec3(m[2]), glm::vec3(m[2]))));
+		spheres[i] = glm::vec4(glm::vec3(m[3]), meshes[i]->getRadius() * sqrt(scale));
+	}
+	const GLuint numDrawn = frustum.cull(spheres.data(), numMeshes, visible.data());
+	bodiesDrawn += numDrawn;
+	bodiesCulled += numMeshes - numDrawn;
+
+	/* Pick the level of detail for the size of each mesh on screen, and    *
+	 * find the texture array it is drawn from.                             */
+	drawOrder.clear();
+	textureArrays.resize(numMeshes);
+	for(GLuint i = 0; i < numMeshes; i++)
+	{
+		if(!visible[i])
+			continue;
+		lodLevels[i] = selectLevel(meshes[i], *modelToWorldMatrices[i], lodLevels[i]);
+		textureArrays[i] = TextureArray::getArrayID(textures[i]);
+
+		/* Ask for the texture level the body needs: its texture wraps once *
+		 * around it, so the width would cover its circumference on screen. */
+		if(textures[i] != 0)
+			TextureResidency::request(textures[i], (GLfloat) (2.0 * M_PI) *
+				meshes[i]->getRadius() * pixelsPerUnit(*modelToWorldMatrices[i]));
+		trianglesDrawn += meshes[i]->getLevel(lodLevels[i]).numIndices / 3;
+		trianglesFull  += meshes[i]->getLevel(0).numIndices / 3;
+		drawOrder.push_back(i);
+	}
 
-		/* Set the active Texture. */
-		glActiveTexture(GL_TEXTURE0);
-		glUniform1i(textureUniformLocation, 0);
+	/* Bring together the bodies drawn alike, texture array first as it is  *
+	 * the dearest to change, then vertex array, then level. The layers of  *
+	 * an array are told apart per instance, so they share a run.           */
+	std::sort(drawOrder.begin(), drawOrder.end(), [&](GLuint a, GLuint b)
+	{
+		if(textureArrays[a] != textureArrays[b])
+			return textureArrays[a] < textureArrays[b];
+		if(meshes[a] != meshes[b])
+			return meshes[a] < meshes[b];
+		return lodLevels[a] < lodLevels[b];
+	});
+
+	/* Write the matrices and texture layers in draw order straight into  *
+	 * this frame's region.                                                 */
+	GLintptr instanceOffset = 0;
+	if(instanced && numDrawn > 0)
+	{
+		Instance* instanceData = (Instance*) instances.begin(numDrawn * sizeof(Instance));
+		for(GLuint k = 0; k < numDrawn; k++)
+		{
+			instanceData[k].modelToWorld = *modelToWorldMatrices[drawOrder[k]];
+			instanceData[k].layer        = TextureArray::getLayer(textures[drawOrder[k]]);
+			instanceData[k].minLevel     = TextureArray::getMinLevel(textures[drawOrder[k]]);
+		}
+		instanceOffset = instances.end();
+	}
 
-		/* Send the transformation data down to the buffer. */
-		glUniformMatrix4fv(modelToWorldUniformLocation, 1, GL_FALSE, 
-			 &(*(modelToWorldMatrices.at(i)))[0][0]);
-		glUniformMatrix4fv(modelToProjectionUniformLocation, 1, GL_FALSE,
-			&modelToProjectionMatrix[0][0]);
+	/* Draw 3-D space, one run of alike bodies at a time. */
+	for(GLuint first = 0, last; first < numDrawn; first = last)
+	{
+		const GLuint i    = drawOrder[first];
+		Mesh*        mesh = meshes[i];
+		for(last = first + 1; last < numDrawn; last++)
+		{
+			GLuint j = drawOrder[last];
+			if(meshes[j] != mesh || lodLevels[j] != lodLevels[i] ||
+			   textureArrays[j] != textureArrays[i])
+				break;
+		}
+
+		/* Bind the appropriate Vertex Array (and with it the indices). */
+		const bool newArray = bindVertexArray(mesh->getVertexArrayID());
+
+		/* If the mesh is textured, bind its Texture Array. */
+		if (textureArrays[i] != 0)
+			bindTexture(textureArrays[i]);
+
+		const MeshLevel& level  = mesh->getLevel(lodLevels[i]);
+		const GLvoid*    offset = (GLvoid*) ((size_t) level.firstIndex * mesh->getIndexSize());
+		if(instanced)
+		{
+			/* Point the matrix columns and the layer at this run's         *
+			 * instances (the divisors stay with the vertex array, so they  *
+			 * are set once per array).                                     */
+			const GLintptr runOffset = instanceOffset + first * sizeof(Instance);
+			for(GLuint c = 0; c < 4; c++)
+			{
+				if(newArray)
+				{
+					glEnableVertexAttribArray(MODEL_TO_WORLD_ATTRIBUTE + c);
+					glVertexAttribDivisor(MODEL_TO_WORLD_ATTRIBUTE + c, 1);
+				}
+				glVertexAttribPointer(MODEL_TO_WORLD_ATTRIBUTE + c, 4, GL_FLOAT, GL_FALSE,
+					sizeof(Instance), (GLvoid*) (runOffset + c * sizeof(glm::vec4)));
+			}
+			if(newArray)
+			{
+				glEnableVertexAttribArray(TEXTURE_LAYER_ATTRIBUTE);
+				glVertexAttribDivisor(TEXTURE_LAYER_ATTRIBUTE, 1);
+			}
+			glVertexAttribPointer(TEXTURE_LAYER_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE,
+				sizeof(Instance), (GLvoid*) (runOffset + offsetof(Instance, layer)));
+
+			/* Draw the elements of every instance to the window. */
+			glDrawElementsInstanced(mesh->getDrawMode(), level.numIndices,
+				mesh->getIndexType(), offset, last - first);
+			drawCalls++;
+			continue;
+		}
+		for(GLuint k = first; k < last; k++)
+		{
+			for(GLuint c = 0; c < 4; c++)
+				glVertexAttrib4fv(MODEL_TO_WORLD_ATTRIBUTE + c,
+					&(*modelToWorldMatrices[drawOrder[k]])[c][0]);
+			glVertexAttrib2f(TEXTURE_LAYER_ATTRIBUTE,
+				TextureArray::getLayer(textures[drawOrder[k]]),
+				TextureArray::getMinLevel(textures[drawOrder[k]]));
+
+			/* Draw the elements to the window. */
+			glDrawElements(mesh->getDrawMode(), level.numIndices,
+				mesh->getIndexType(), offset);
+			drawCalls++;
+		}
+	}
+	if(instanced && numDrawn > 0)
+		instances.fence();
+	numFrames++;
 
+	/* Draw the particles, streamed in one buffer and drawn in one call. */
+	if(particles)
+	{
+		glm::vec3 lightSource = glm::vec3(worldToViewMatrix * glm::vec4(LIGHT_SOURCE, 1.0f));
+
+		useProgram(particleProgram);
+		glUniformMatrix4fv(particleToViewUniformLocation, 1, GL_FALSE,
+			&worldToViewMatrix[0][0]);
+		glUniformMatrix4fv(particleToProjectionUniformLocation, 1, GL_FALSE,
+			&viewToProjectionMatrix[0][0]);
+		glUniform1f(particlePixelScaleUniformLocation, lodPixelScale);
+		glUniform3fv(particleLightUniformLocation, 1, &lightSource[0]);
+
+		const GLsizeiptr bytes = list.particles.size * sizeof(glm::vec4);
+		memcpy(particleStream.begin(bytes), list.particles.data, bytes);
+		GLintptr particleOffset = particleStream.end();
+		bindVertexArray(particleArray);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4),
+			(GLvoid*) particleOffset);
+		glDrawArrays(GL_POINTS, 0, list.particles.size);
+		particleStream.fence();
+		drawCalls++;
+	}
 
-		/* Draw the elements to the window. */
-		glDrawElements(meshes.at(i)->getDrawMode(),      // Draw mode.
-                       meshes.at(i)->getNumIndices(),    // Number of indices
-					   GL_UNSIGNED_SHORT,                // Data type of index
-                       0);                               // Index offset
+	/* Draw the orbit trails, which are already in world space. */
+	if(trailProgram != 0 && !list.trails.empty())
+	{
+		glm::vec4 trailColor = TRAIL_COLOR;
+
+		useProgram(trailProgram);
+		glUniformMatrix4fv(trailToProjectionUniformLocation, 1, GL_FALSE,
+			&worldToProjectionMatrix[0][0]);
+		glUniform4fv(trailColorUniformLocation, 1, &trailColor[0]);
+
+		for(Trail* trail : list.trails)
+		{
+			trail->upload();
+			trail->draw();
+		}
+		boundArray = BIND_UNKNOWN;
 	}
+	useProgram(program);
 
 	/* Swap the double buffer. */
 	SDL_GL_SwapWindow(window);
@@ -262,17 +436,19 @@ void Display::setShader(Shader shader)
 {
 	/* Tell OpenGL to use this shader. */
 	shader.use();
+	program = shader.getProgram();
 
-	/* Get the location of the fullTransformMatrix uniform variable. */
-	modelToProjectionUniformLocation = glGetUniformLocation(
-		shader.getProgram(), "modelToProjectionMatrix");
-
-	modelToWorldUniformLocation = glGetUniformLocation(
-		shader.getProgram(), "modelToWorldMatrix");
+	/* Get the location of the worldToProjectionMatrix uniform variable. */
+	worldToProjectionUniformLocation = glGetUniformLocation(
+		shader.getProgram(), "worldToProjectionMatrix");
 
 	/* Get the location of the texture sampler uniform variable. */
 	textureUniformLocation = glGetUniformLocation(
-		shader.getProgram(), "texture");
+		shader.getProgram(), "textures");
+
+	/* The sampler reads texture unit 0, the only one used. */
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(textureUniformLocation, 0);
 
 	lightSourceUniformLocation = glGetUniformLocation(
 		shader.getProgram(), "lightSource");
@@ -281,15 +457,340 @@ void Display::setShader(Shader shader)
 	ambientLightUniformLocation = glGetUniformLocation(
 		shader.getProgram(), "ambientLight");
 
-	float brightness = 0.5f;
-	glm::vec4 ambientLight(brightness, brightness, brightness, 1.0f);
+	glm::vec4 ambientLight = AMBIENT_LIGHT;
 	glUniform4fv(ambientLightUniformLocation, 1, &ambientLight[0]);
 
-	glm::vec3 lightSource(0.0f, 2500.0f, 100000.0f);
+	glm::vec3 lightSource = LIGHT_SOURCE;
 	glUniform3fv(lightSourceUniformLocation, 1, &lightSource[0]);
 
 }
 
+/******************************************************************************
+*                                                                             *
+*                           Display::setTrailShader                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param shader                                                              *
+*        The shader object to be used for rendering the orbit trails.         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Keeps the program the trails are drawn with and the location IDs of its   *
+*  uniform variables. Without a trail shader, trails are not drawn.           *
+*                                                                             *
+*******************************************************************************/
+void Display::setTrailShader(Shader shader)
+{
+	trailProgram = shader.getProgram();
+
+	trailToProjectionUniformLocation = glGetUniformLocation(
+		trailProgram, "worldToProjectionMatrix");
+	trailColorUniformLocation = glGetUniformLocation(
+		trailProgram, "trailColor");
+
+	/* Go back to the body shader if there is one. */
+	if(program != 0)
+		glUseProgram(program);
+}
+
+/******************************************************************************
+*                                                                             *
+*                          Display::setParticleShader                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param shader                                                              *
+*        The shader object to be used for drawing the bodies as particles.    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Keeps the program the particles are drawn with and the location IDs of its *
+*  uniform variables, sets the ones which never change, and makes the buffer  *
+*  the particles are streamed to. Without a particle shader, repaint() draws  *
+*  every body as a mesh.                                                      *
+*                                                                             *
+*******************************************************************************/
+void Display::setParticleShader(Shader shader)
+{
+	particleProgram = shader.getProgram();
+	glUseProgram(particleProgram);
+
+	particleToViewUniformLocation = glGetUniformLocation(
+		particleProgram, "worldToViewMatrix");
+	particleToProjectionUniformLocation = glGetUniformLocation(
+		particleProgram, "viewToProjectionMatrix");
+	particlePixelScaleUniformLocation = glGetUniformLocation(
+		particleProgram, "pixelScale");
+	particleLightUniformLocation = glGetUniformLocation(
+		particleProgram, "lightSource");
+
+	glm::vec4 ambientLight  = AMBIENT_LIGHT;
+	glm::vec4 particleColor = PARTICLE_COLOR;
+	glUniform4fv(glGetUniformLocation(particleProgram, "ambientLight"), 1, &ambientLight[0]);
+	glUniform4fv(glGetUniformLocation(particleProgram, "particleColor"), 1, &particleColor[0]);
+	glUniform1f(glGetUniformLocation(particleProgram, "minPointSize"), PARTICLE_MIN_SIZE);
+	glUniform1f(glGetUniformLocation(particleProgram, "impostorSize"), PARTICLE_IMPOSTOR_SIZE);
+
+	/* One vec4 per body: its position, and its radius in w. */
+	if(particleArray == 0)
+	{
+		/* The buffer is pointed at each frame, at that frame's region. */
+		glGenVertexArrays(1, &particleArray);
+		glBindVertexArray(particleArray);
+		glEnableVertexAttribArray(0);
+		glBindVertexArray(0);
+	}
+
+	/* Sprites are sized by the vertex shader, and textured by position. */
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	glEnable(GL_POINT_SPRITE);
+
+	/* Go back to the body shader if there is one. */
+	if(program != 0)
+		glUseProgram(program);
+}
+
+/******************************************************************************
+*                                                                             *
+*                          Display::setLoadingScreen                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param shader                                                              *
+*        The shader object the loading screen is drawn with.                  *
+*  @param texture                                                             *
+*        The image shown on the loading screen.                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Builds a quad covering the window, in clip space, for the image to be      *
+*  drawn on.                                                                  *
+*                                                                             *
+*******************************************************************************/
+void Display::setLoadingScreen(Shader shader, GLuint texture)
+{
+	clearLoadingScreen();
+	loadingProgram = shader.getProgram();
+	loadingTexture = texture;
+
+	/* The image's first row is at t = 0, so it goes at the top. */
+	glm::vec3 normal(0.0f, 0.0f, 1.0f);
+	std::vector<Vertex> vertices;
+	vertices.push_back({ { -1.0f, -1.0f, 0.0f }, DEFAULT_VERTEX_COLOR, normal, { 0.0f, 1.0f } });
+	vertices.push_back({ { +1.0f, -1.0f, 0.0f }, DEFAULT_VERTEX_COLOR, normal, { 1.0f, 1.0f } });
+	vertices.push_back({ { +1.0f, +1.0f, 0.0f }, DEFAULT_VERTEX_COLOR, normal, { 1.0f, 0.0f } });
+	vertices.push_back({ { -1.0f, +1.0f, 0.0f }, DEFAULT_VERTEX_COLOR, normal, { 0.0f, 0.0f } });
+	GLuint quad[] = { 0, 1, 2, 0, 2, 3 };
+	std::vector<GLuint> indices(quad, quad + 6);
+	loadingQuad = Geometry::createMesh(&vertices, &indices);
+}
+
+/******************************************************************************
+*                                                                             *
+*                         Display::clearLoadingScreen                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void Display::clearLoadingScreen()
+{
+	if(loadingQuad != nullptr)
+	{
+		loadingQuad->cleanUp();
+		delete loadingQuad;
+	}
+	loadingQuad    = nullptr;
+	loadingProgram = 0;
+	loadingTexture = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           Display::repaintLoading                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param progress                                                            *
+*        Fraction of the assets which have been loaded (0.0 - 1.0).           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Draws the loading image over the whole window and a progress bar along    *
+*  its bottom edge. The bar is a scissored clear, so it needs no geometry.    *
+*                                                                             *
+*******************************************************************************/
+void Display::repaintLoading(GLfloat progress)
+{
+	/* Keep the window responsive while loading. */
+	SDL_PumpEvents();
+
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	updateViewport();
+
+	/* Draw the image. */
+	if(loadingQuad != nullptr && loadingProgram != 0)
+	{
+		glDisable(GL_DEPTH_TEST);
+		glUseProgram(loadingProgram);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, TextureArray::getArrayID(loadingTexture));
+		glUniform1i(glGetUniformLocation(loadingProgram, "textures"), 0);
+		glUniform1f(glGetUniformLocation(loadingProgram, "textureLayer"),
+			TextureArray::getLayer(loadingTexture));
+		glBindVertexArray(loadingQuad->getVertexArrayID());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, loadingQuad->getBufferIDs()[1]);
+		glDrawElements(loadingQuad->getDrawMode(), loadingQuad->getNumIndices(),
+			loadingQuad->getIndexType(), 0);
+		if(program != 0)
+			glUseProgram(program);
+	}
+
+	/* Draw the bar, then put the clear color back. */
+	GLint width, height;
+	SDL_GetWindowSize(window, &width, &height);
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glm::vec4 barColor = LOADING_BAR_COLOR;
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, (GLsizei) (glm::clamp(progress, 0.0f, 1.0f) * width),
+		(GLsizei) (LOADING_BAR_HEIGHT * height) + 1);
+	glClearColor(barColor.r, barColor.g, barColor.b, barColor.a);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+	/* Swap the double buffer. */
+	SDL_GL_SwapWindow(window);
+}
+
+/******************************************************************************
+*                                                                             *
+*                             Display::selectLevel                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param mesh                                                                *
+*           Mesh about to be drawn.                                           *
+*  @param modelToWorld                                                        *
+*           Its transformation, whose scale and translation give its size     *
+*           and position in the world.                                        *
+*  @param current                                                             *
+*           Level it was drawn at in the last frame.                          *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Level to draw it at in this frame.                                         *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  The error of each level is projected to pixels at the distance of the      *
+*  mesh. The level is refined as soon as its error exceeds LOD_PIXEL_ERROR,   *
+*  but only coarsened once the next level's error is under LOD_HYSTERESIS of *
+*  that, so a body on the boundary does not flicker between two levels.       *
+*                                                                             *
+*******************************************************************************/
+GLuint Display::selectLevel(const Mesh* mesh, const glm::mat4& modelToWorld,
+                            GLuint current)
+{
+	const GLuint numLevels = mesh->getNumLevels();
+	if(numLevels <= 1)
+		return 0;
+
+	GLfloat pixels = pixelsPerUnit(modelToWorld);
+	if(pixels <= 0.0f)
+		return 0;
+
+	GLuint level = std::min(current, numLevels - 1);
+	while(level > 0 && mesh->getLevel(level).error * pixels > LOD_PIXEL_ERROR)
+		level--;
+	if(level == std::min(current, numLevels - 1))
+		while(level + 1 < numLevels &&
+			mesh->getLevel(level + 1).error * pixels <= LOD_PIXEL_ERROR * LOD_HYSTERESIS)
+			level++;
+	return level;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             Display::pixelsPerUnit                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param modelToWorld                                                        *
+*           Transformation of a body, whose largest scale is taken.           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Pixels covered by one model unit at the distance of the body, or 0 if it   *
+*  is at the camera.                                                          *
+*                                                                             *
+*******************************************************************************/
+GLfloat Display::pixelsPerUnit(const glm::mat4& modelToWorld)
+{
+	GLfloat scale = std::max(glm::length(glm::vec3(modelToWorld[0])),
+		std::max(glm::length(glm::vec3(modelToWorld[1])),
+		         glm::length(glm::vec3(modelToWorld[2]))));
+	GLfloat distance = glm::distance(glm::vec3(modelToWorld[3]), *camera.getPosition());
+	if(distance <= 0.0f)
+		return 0.0f;
+	return lodPixelScale * scale / distance;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              Display::printStats                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void Display::printStats() const
+{
+	if(numFrames == 0)
+		return;
+	fprintf(stdout, "Drew %.0f triangles per frame (%.0f at full detail, %.1f%%)\n",
+		(GLdouble) trianglesDrawn / numFrames, (GLdouble) trianglesFull / numFrames,
+		trianglesFull > 0 ? 100.0 * trianglesDrawn / trianglesFull : 100.0);
+	fprintf(stdout, "Drew the bodies in %.1f %s calls per frame\n",
+		(GLdouble) drawCalls / numFrames, instanced ? "instanced draw" : "draw");
+	fprintf(stdout, "Drew %.1f meshes per frame, and culled %.1f outside the view\n",
+		(GLdouble) bodiesDrawn / numFrames, (GLdouble) bodiesCulled / numFrames);
+	fprintf(stdout, "Streamed %llu frames of instances through %s buffers, %llu stalled\n",
+		(unsigned long long) instances.getNumFrames(),
+		instances.isPersistent() ? "persistent-mapped" : "orphaned",
+		(unsigned long long) (instances.getNumStalls() + particleStream.getNumStalls()));
+	fprintf(stdout, "Bound %.1f objects per frame, skipping %.1f already bound\n",
+		(GLdouble) bindsIssued / numFrames, (GLdouble) bindsSkipped / numFrames);
+}
+
 /******************************************************************************
 *                                                                             *
 *                           Display::~Display (Destructor)                    *
@@ -312,6 +813,12 @@ void Display::setShader(Shader shader)
 *******************************************************************************/
 Display::~Display()
 {
+	/* Delete the buffers while the context is still there. */
+	instances.cleanUp();
+	particleStream.cleanUp();
+	if(particleArray != 0)
+		glDeleteVertexArrays(1, &particleArray);
+
 	/* Delete the GL context. */
 	SDL_GL_DeleteContext(context);
 
@@ -11,8 +11,12 @@
 #include <string>
 #include <vector>
 #include "Camera.h"
+#include "Frustum.h"
 #include "Geometry.h"
+#include "RenderList.h"
 #include "Shader.h"
+#include "StreamBuffer.h"
+#include "Trail.h"
 
 /******************************************************************************
  *                                                                            *
@@ -26,9 +30,31 @@
 #define  DEFAULT_NEAR_PLANE       1.0f
 /* Far clipping plane parameter. */
 #define  DEFAULT_FAR_PLANE        1500000.0f
+/* Color of the orbit trails. */
+#define  TRAIL_COLOR              glm::vec4(0.4f, 0.6f, 1.0f, 1.0f)
+/* Color and height (as a fraction of the window) of the loading bar. */
+#define  LOADING_BAR_COLOR        glm::vec4(0.4f, 0.6f, 1.0f, 1.0f)
+#define  LOADING_BAR_HEIGHT       0.02f
+/* Most pixels a level of detail may be off by, and the share of that the  *
+ * next coarser level must be under before it replaces the current one.    */
+#define  LOD_PIXEL_ERROR          1.0f
+#define  LOD_HYSTERESIS           0.5f
 /* Default vertex and fragment shader source files. */
 #define  DEFAULT_VERTEX_SHADER    "res/shaders/shader.vs"
 #define  DEFAULT_FRAGMENT_SHADER  "res/shaders/shader.fs"
+/* Shaders the bodies are drawn with as particles. */
+#define  PARTICLE_VERTEX_SHADER   "res/shaders/particle.vs"
+#define  PARTICLE_FRAGMENT_SHADER "res/shaders/particle.fs"
+/* Color of the particles, the smallest they are drawn (in pixels), and the *
+ * size from which they are shaded as spheres rather than flat dots.        */
+#define  PARTICLE_COLOR           glm::vec4(1.0f, 0.9f, 0.7f, 1.0f)
+#define  PARTICLE_MIN_SIZE        2.0f
+#define  PARTICLE_IMPOSTOR_SIZE   6.0f
+/* World position of the light, and the ambient light. */
+#define  LIGHT_SOURCE             glm::vec3(0.0f, 2500.0f, 100000.0f)
+#define  AMBIENT_LIGHT            glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)
+/* Object ID never returned by OpenGL, for a bind that is not known. */
+#define  BIND_UNKNOWN             0xffffffff
 
 /******************************************************************************
  *																			  *
@@ -54,6 +80,31 @@ enum class Dimension
 	DEPTH,
 };
 
+/******************************************************************************
+ *                                                                            *
+ *                             Instance   (struct)                            *
+ *                                                                            *
+ ******************************************************************************
+ *  modelToWorld                                                              *
+ *       Model matrix of a body.                                              *
+ *  layer / minLevel                                                          *
+ *       Layer of its texture array, and the finest level of it uploaded so   *
+ *       far (see TextureArray and TextureStream).                            *
+ *                                                                            *
+ ******************************************************************************
+ * DESCRIPTION                                                                *
+ *  What each instance of a body's mesh is given, padded to a multiple of 16  *
+ *  bytes.                                                                    *
+ *                                                                            *
+ ******************************************************************************/
+struct Instance
+{
+	glm::mat4      modelToWorld;
+	GLfloat        layer;
+	GLfloat        minLevel;
+	GLfloat        padding[2];
+};
+
 /******************************************************************************
  *																			  *
  *	                             Display Class                                *
@@ -68,21 +119,78 @@ enum class Dimension
  *          drawn.                                                            *
  *  camera                                                                    *
  *          Camera instance whose perspective this display shows.             *
- *  modelToProjectionMatrix                                                   *
- *          4-D matrix representing the total transformation to the display.  *
  *  viewToProjectionMatrix                                                    *
  *          4-D matrix representing the transformation from the view to the   *
  *          projection (camera view).                                         *
- *  modelToProjectionUniformLocation                                          *
- *          ID  of the location for the modelToProjectionMatrix in the shader *
- *          program.                                                          *
+ *  worldToProjectionUniformLocation                                          *
+ *          ID  of the location for the worldToProjectionMatrix in the shader *
+ *          program, set once per frame.                                      *
  *  textureUniformLocation                                                    *
  *          ID  of the location for the texture sampler in the shader program *
+ *  trailProgram                                                              *
+ *          Shader program the orbit trails are drawn with (0 for none).      *
+ *  particleProgram / particleArray / particleStream                          *
+ *          Shader program, vertex array and streamed buffer the bodies are   *
+ *          drawn with as particles (0 for none).                             *
+ *  loadingQuad / loadingProgram / loadingTexture                             *
+ *          Full-window quad, program, and image of the loading screen, set   *
+ *          while the assets of a system load (see AssetLoader).              *
+ *  lodPixelScale                                                             *
+ *          Pixels covered by one world unit at a distance of one unit, from  *
+ *          the height of the viewport and the field of view.                 *
+ *  instanced                                                                 *
+ *          Whether the hardware draws instances, with a divisor per          *
+ *          attribute (OpenGL 3.3 or ARB_instanced_arrays).                   *
+ *  instances                                                                 *
+ *          Model matrices and texture layers of the bodies in the order they *
+ *          are drawn, written each frame into a persistent-mapped ring of    *
+ *          buffers.                                                          *
+ *  drawOrder / textureArrays                                                 *
+ *          Body indices sorted by texture array, then mesh and level of      *
+ *          detail, so the bodies drawn alike are next to each other and      *
+ *          drawn together, and each array is bound once a frame; and the     *
+ *          array of each body (see TextureArray).                            *
+ *  boundProgram / boundArray / boundTexture                                  *
+ *          Program, vertex array and texture last bound by repaint(), which  *
+ *          are not bound again (forgotten at the start of every frame, as    *
+ *          other code binds them too).                                       *
+ *  bindsIssued / bindsSkipped                                                *
+ *          Binds made, and those skipped for binding what was bound already. *
+ *  numFrames / trianglesDrawn / trianglesFull / drawCalls                    *
+ *          Frames repainted, and the triangles drawn in them against those   *
+ *          the full meshes would have taken, in so many draw calls.          *
+ *  bodiesDrawn / bodiesCulled                                                *
+ *          Meshes drawn, and left out for being outside the view frustum.    *
+ *  frustum / spheres / visible                                               *
+ *          View frustum of the frame, and the world bounding sphere of each  *
+ *          mesh tested against it (its radius scaled by the largest axis of  *
+ *          its model matrix), with whether it may be seen.                   *
  *                                                                            *
  ******************************************************************************
  * DESCRIPTION                                                                *
  *  Class representing the window in which the OpenGL context may render.     *
  *                                                                            *
+ *  Only meshes whose bounding spheres touch the view frustum are drawn,      *
+ *  tested in one batch each frame (see Frustum.h). They are drawn            *
+ *  instanced: each run of bodies with the same mesh, level of detail and     *
+ *  texture array is one glDrawElementsInstanced, its model matrices and      *
+ *  texture layers read per instance from the instance buffer, and the world  *
+ *  to projection matrix is the one uniform set per frame. Without           *
+ *  instancing, each body is drawn on its own with its matrix and layer as    *
+ *  constant attributes.                                                      *
+ *                                                                            *
+ *  repaint() is handed a RenderList of views of the system's own arrays, and *
+ *  keeps every scratch array between frames, so a frame allocates nothing.   *
+ *  The projection matrix only changes in updateViewport(), which is called   *
+ *  when the window is resized.                                               *
+ *                                                                            *
+ *  For systems too large to draw a mesh per body, repaint() may be given     *
+ *  the position and radius of every body instead. They are uploaded in one   *
+ *  buffer and drawn in one call as point sprites sized by their radius and   *
+ *  distance: flat dots while they are small, and once they cover             *
+ *  PARTICLE_IMPOSTOR_SIZE pixels, spheres ray cast in the fragment shader,   *
+ *  lit and with their true depth.                                            *
+ *                                                                            *
  ******************************************************************************/
 class Display
 {
@@ -97,21 +205,30 @@ public:
 	/* Calculate the width and height of the screen dimensions. */
 	GLushort getScreenDimension(Dimension d);
 
-	/* Update the size of the viewport on window resize. */
+	/* Update the size of the viewport (on window resize). */
 	void     updateViewport();
 
 	/* Maximnize the display on the current screen. */
 	void     maximize();
 
 	/* Repaint the graphics. */
-	void     repaint(std::vector<Mesh*>      meshes,
-                     std::vector<glm::mat4*> modelToWorldMatrices);
+	void     repaint(const RenderList& list);
+	/* Repaint the loading screen, with a bar filled to progress (0 - 1). */
+	void     repaintLoading(GLfloat progress);
+	/* Print the triangles drawn per frame. */
+	void     printStats() const;
 	
 	/* Getters. */
 	Camera*  getCamera()               {  return &camera;            }
 
 	/* Setters. */     
 	void    setShader(Shader shader);
+	void    setTrailShader(Shader shader);
+	void    setParticleShader(Shader shader);
+	void    setLoadingScreen(Shader shader, 
+	                         GLuint texture);
+	/* Free the loading screen's quad (the program and image are not owned). */
+	void    clearLoadingScreen();
 	void    setClearColor(GLclampf r, 
                           GLclampf b,
                           GLclampf g, 
@@ -131,19 +248,90 @@ private:
 	SDL_GLContext  context;
 	/* Camera for looking at the world. */
 	Camera         camera;
-	/* Model to Projection (complete) matrix. */
-	glm::mat4      modelToProjectionMatrix;
 	/* View to Projection matrix. */
 	glm::mat4      viewToProjectionMatrix;
-	/* Uniform location for the full transformation. */
-	GLuint         modelToProjectionUniformLocation;
+	/* Uniform location for the world to projection transformation. */
+	GLuint         worldToProjectionUniformLocation;
 	/* Uniform location for the texture. */
 	GLuint         textureUniformLocation;
 	/* Uniform location for the light source. */
 	GLuint         lightSourceUniformLocation;
 	/* Uniform location for the ambient light. */
 	GLuint         ambientLightUniformLocation;
-	/* Uniform location for the model to world transformation.*/
-	GLuint         modelToWorldUniformLocation;
+	/* Programs for the bodies and for the trails. */
+	GLuint         program;
+	GLuint         trailProgram;
+	/* Uniform locations for the trail transformation and color. */
+	GLuint         trailToProjectionUniformLocation;
+	GLuint         trailColorUniformLocation;
+	/* Particle program, its uniform locations, and its vertices. */
+	GLuint         particleProgram;
+	GLuint         particleToViewUniformLocation;
+	GLuint         particleToProjectionUniformLocation;
+	GLuint         particlePixelScaleUniformLocation;
+	GLuint         particleLightUniformLocation;
+	GLuint         particleArray;
+	StreamBuffer   particleStream;
+	/* Loading screen quad, program, and image. */
+	Mesh*          loadingQuad;
+	GLuint         loadingProgram;
+	GLuint         loadingTexture;
+	/* Level of detail selection and its statistics. */
+	GLfloat        lodPixelScale;
+	GLuint64       numFrames;
+	GLuint64       trianglesDrawn;
+	GLuint64       trianglesFull;
+	GLuint64       drawCalls;
+	GLuint64       bodiesDrawn;
+	GLuint64       bodiesCulled;
+	/* View frustum, and the bounding spheres tested against it. */
+	Frustum        frustum;
+	std::vector<glm::vec4> spheres;
+	std::vector<GLubyte>   visible;
+	/* Per-instance model matrices, and the order the bodies are drawn in. */
+	bool           instanced;
+	StreamBuffer   instances;
+	std::vector<GLuint>    drawOrder;
+	std::vector<GLuint>    textureArrays;
+	/* Objects last bound, and the binds made and skipped. */
+	GLuint         boundProgram;
+	GLuint         boundArray;
+	GLuint         boundTexture;
+	GLuint64       bindsIssued;
+	GLuint64       bindsSkipped;
+
+	/* Level of detail to draw a mesh at, given the one it was drawn at. */
+	GLuint         selectLevel(const Mesh*      mesh,
+	                           const glm::mat4& modelToWorld,
+	                           GLuint           current);
+	/* Pixels covered by one model unit of a body (0 at the camera). */
+	GLfloat        pixelsPerUnit(const glm::mat4& modelToWorld);
+
+	/* Forget what is bound (at the start of a frame). */
+	void           resetBinds()
+	{
+		boundProgram = boundArray = boundTexture = BIND_UNKNOWN;
+	}
+	/* Bind an object unless it is bound already. The vertex array bind     *
+	 * returns whether it changed, as attributes set on it must follow.     */
+	void           useProgram(GLuint id)
+	{
+		if(id == boundProgram) {  bindsSkipped++;  return;  }
+		glUseProgram(boundProgram = id);
+		bindsIssued++;
+	}
+	bool           bindVertexArray(GLuint id)
+	{
+		if(id == boundArray) {  bindsSkipped++;  return false;  }
+		glBindVertexArray(boundArray = id);
+		bindsIssued++;
+		return true;
+	}
+	void           bindTexture(GLuint id)
+	{
+		if(id == boundTexture) {  bindsSkipped++;  return;  }
+		glBindTexture(GL_TEXTURE_2D_ARRAY, boundTexture = id);
+		bindsIssued++;
+	}
 
 };
@@ -0,0 +1,171 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Mantissa digits kept exactly (10^19 still fits in 64 bits). */
+#define  FAST_PARSE_MAX_DIGITS                                             19
+/* Largest power of ten, and integer, which a double holds exactly. */
+#define  FAST_PARSE_MAX_EXACT_POW10                                        22
+#define  FAST_PARSE_MAX_EXACT_INT                      (1ull << 53)
+/* Longest number handed to strtod when the fast path does not apply. */
+#define  FAST_PARSE_MAX_LENGTH                                             64
+
+/******************************************************************************
+*                                                                             *
+*                              FastParse   (class)                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Number parsing for text files which are scanned in memory (system files,   *
+*  OBJ meshes). Unlike atof, the input does not have to be NUL-terminated,    *
+*  and the common case never leaves the function: a mantissa of at most 19    *
+*  digits is collected as an integer and, when it and the power of ten are    *
+*  both exact in a double, scaled with one multiplication or division, which  *
+*  rounds correctly. Anything else (long mantissas, large exponents) goes     *
+*  through strtod. Either way the result is the correctly rounded double, so  *
+*  a float read here has the same bits as (GLfloat) atof of the same text.    *
+*                                                                             *
+*******************************************************************************/
+class FastParse
+{
+public:
+	/* Whether c is XML/OBJ whitespace. */
+	static bool       isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	/* Skip whitespace, returning the first other character (or end). */
+	static const char* skipSpace(const char* p, const char* end)
+	{
+		while(p < end && isSpace(*p))
+			p++;
+		return p;
+	}
+
+	/* Parse a number at p, moving p past it (false if there is none). */
+	static bool       parseDouble(const char*& p, const char* end, GLdouble* value)
+	{
+		static const GLdouble POW10[FAST_PARSE_MAX_EXACT_POW10 + 1] =
+		{
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const char* start    = p;
+		const char* s        = p;
+		bool        negative = false;
+		if(s < end && (*s == '+' || *s == '-'))
+			negative = *s++ == '-';
+
+		/* Mantissa, as an integer and a power of ten. */
+		GLuint64 mantissa  = 0;
+		int      digits    = 0;
+		int      exponent  = 0;
+		bool     truncated = false;
+		bool     any       = false;
+		for(; s < end && *s >= '0' && *s <= '9'; s++, any = true)
+		{
+			if(digits < FAST_PARSE_MAX_DIGITS)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				digits  += mantissa != 0;
+			}
+			else
+			{
+				exponent++;
+				truncated |= *s != '0';
+			}
+		}
+		if(s < end && *s == '.')
+		{
+			for(s++; s < end && *s >= '0' && *s <= '9'; s++, any = true)
+			{
+				if(digits < FAST_PARSE_MAX_DIGITS)
+				{
+					mantissa = mantissa * 10 + (*s - '0');
+					digits  += mantissa != 0;
+					exponent--;
+				}
+				else
+					truncated |= *s != '0';
+			}
+		}
+		if(!any)
+			return false;
+
+		/* Exponent (left unread if no digits follow the 'e'). */
+		if(s < end && (*s == 'e' || *s == 'E'))
+		{
+			const char* e        = s + 1;
+			bool        negExp   = false;
+			int         exp10    = 0;
+			if(e < end && (*e == '+' || *e == '-'))
+				negExp = *e++ == '-';
+			if(e < end && *e >= '0' && *e <= '9')
+			{
+				for(; e < end && *e >= '0' && *e <= '9'; e++)
+					if(exp10 < 10000)
+						exp10 = exp10 * 10 + (*e - '0');
+				exponent += negExp ? -exp10 : exp10;
+				s = e;
+			}
+		}
+		p = s;
+
+		/* Fast path: both factors exact, so the one operation rounds right. */
+		if(!truncated && mantissa <= FAST_PARSE_MAX_EXACT_INT)
+		{
+			GLdouble m     = (GLdouble) mantissa;
+			bool     exact = true;
+			if(exponent >= 0 && exponent <= FAST_PARSE_MAX_EXACT_POW10)
+				m *= POW10[exponent];
+			else if(exponent < 0 && exponent >= -FAST_PARSE_MAX_EXACT_POW10)
+				m /= POW10[-exponent];
+			else
+				exact = mantissa == 0;
+			if(exact)
+			{
+				*value = negative ? -m : m;
+				return true;
+			}
+		}
+
+		/* Slow path: strtod on a terminated copy. */
+		char buffer[FAST_PARSE_MAX_LENGTH + 1];
+		size_t length = s - start;
+		if(length > FAST_PARSE_MAX_LENGTH)
+		{
+			std::string copy(start, length);
+			*value = strtod(copy.c_str(), nullptr);
+			return true;
+		}
+		memcpy(buffer, start, length);
+		buffer[length] = '\0';
+		*value = strtod(buffer, nullptr);
+		return true;
+	}
+
+	/* Same as parseDouble, rounded to a float the way (GLfloat) atof is. */
+	static bool       parseFloat(const char*& p, const char* end, GLfloat* value)
+	{
+		GLdouble d;
+		if(!parseDouble(p, end, &d))
+			return false;
+		*value = (GLfloat) d;
+		return true;
+	}
+};
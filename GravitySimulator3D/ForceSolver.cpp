@@ -0,0 +1,265 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "ForceSolver.h"
+#include <SDL\SDL.h>
+
+/******************************************************************************
+*                                                                             *
+*                      ForceSolver::ForceSolver (Constructor)                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param pool                                                                *
+*           Worker threads used for each pass.                                *
+*  @param mode                                                                *
+*           How partial sums from different threads are combined.             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Constructor for the ForceSolver class.                                     *
+*                                                                             *
+*******************************************************************************/
+ForceSolver::ForceSolver(WorkerPool* pool, ReductionMode mode) :
+	pool(pool), mode(mode),
+	positions(nullptr), masses(nullptr), n(0), G(0), out(nullptr),
+	numChunks(0), numBlocks(0), blockSize(0), numTiles(0),
+	numPasses(0), passSeconds(0)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                              ForceSolver::sum                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param tBegin, tEnd                                                        *
+*           Range of bodies whose acceleration is wanted.                     *
+*  @param sBegin, sEnd                                                        *
+*           Range of bodies pulling on the targets.                           *
+*  @param result                                                              *
+*           Array in which the sum for target i is stored at i - tBegin.      *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Sums G * m / r^2 along the unit displacement from each target to each      *
+*  source, in increasing source order, skipping the target itself. This is    *
+*  the only place the arithmetic of the force pass lives, so every mode sums  *
+*  the same terms the same way within a range.                                *
+*                                                                             *
+*******************************************************************************/
+void ForceSolver::sum(GLuint tBegin, GLuint tEnd,
+                      GLuint sBegin, GLuint sEnd,
+                      glm::vec3* result) const
+{
+	for(GLuint i = tBegin; i < tEnd; i++)
+	{
+		glm::vec3 netGravity(0);
+		glm::vec3 position = positions[i];
+
+		for(GLuint j = sBegin; j < sEnd; j++)
+		{
+			/* Do not compare subject with itself. */
+			if(j == i)
+				continue;
+
+			/* Get the unit displacement vector and its magnitude. */
+			glm::vec3 direction = positions[j] - position;
+			GLfloat   radius    = glm::length(direction);
+			direction /= radius;
+
+			/* magnitude = G * m / r^2 */
+			GLfloat magnitude = (G * masses[j]) / (radius * radius);
+			netGravity += magnitude * direction;
+		}
+		result[i - tBegin] = netGravity;
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                            ForceSolver::fastTask                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param context                                                             *
+*           The ForceSolver running the pass.                                 *
+*  @param task                                                                *
+*           Index of the chunk of sources this task sums.                     *
+*  @param worker                                                              *
+*           Index of the worker running the task (not needed).                *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Sums one worker-sized chunk of the sources for all targets and adds the    *
+*  result to the output as soon as it is done, so the order in which chunks   *
+*  are added up is decided by the scheduler.                                  *
+*                                                                             *
+*******************************************************************************/
+void ForceSolver::fastTask(void* context, GLuint task, GLuint /* worker */)
+{
+	ForceSolver* s       = (ForceSolver*) context;
+	glm::vec3*   partial = &s->partials[task * s->n];
+	GLuint       sBegin  = (GLuint) (((GLuint64) s->n *  task)      / s->numChunks);
+	GLuint       sEnd    = (GLuint) (((GLuint64) s->n * (task + 1)) / s->numChunks);
+
+	s->sum(0, s->n, sBegin, sEnd, partial);
+
+	/* Merge in completion order. */
+	std::lock_guard<std::mutex> lock(s->mergeMutex);
+	for(GLuint i = 0; i < s->n; i++)
+		s->out[i] += partial[i];
+}
+
+/******************************************************************************
+*                                                                             *
+*                            ForceSolver::tileTask                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param context                                                             *
+*           The ForceSolver running the pass.                                 *
+*  @param task                                                                *
+*           Index of the target tile to sum.                                  *
+*  @param worker                                                              *
+*           Index of the worker running the task, whose scratch rows it uses. *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Sums every source block for one tile of targets into the worker's rows of  *
+*  the partials array, then combines them with a fixed pairwise tree:         *
+*  (0 + 1), (2 + 3), ... then ((0 + 1) + (2 + 3)), ... The shape of the tree  *
+*  depends only on the number of blocks, which depends only on n, and the     *
+*  rows are only scratch, so the result does not depend on the worker.        *
+*                                                                             *
+*******************************************************************************/
+void ForceSolver::tileTask(void* context, GLuint task, GLuint worker)
+{
+	ForceSolver* s      = (ForceSolver*) context;
+	GLuint       tBegin = task * FORCE_TILE_SIZE;
+	GLuint       tEnd   = glm::min(tBegin + FORCE_TILE_SIZE, s->n);
+	glm::vec3*   p      = &s->partials[(size_t) worker * s->numBlocks * FORCE_TILE_SIZE];
+
+	for(GLuint block = 0; block < s->numBlocks; block++)
+	{
+		GLuint sBegin = block * s->blockSize;
+		GLuint sEnd   = glm::min(sBegin + s->blockSize, s->n);
+		s->sum(tBegin, tEnd, sBegin, sEnd, &p[block * FORCE_TILE_SIZE]);
+	}
+
+	for(GLuint stride = 1; stride < s->numBlocks; stride *= 2)
+		for(GLuint b = 0; b + stride < s->numBlocks; b += 2 * stride)
+			for(GLuint i = 0; i < tEnd - tBegin; i++)
+				p[b * FORCE_TILE_SIZE + i] += p[(b + stride) * FORCE_TILE_SIZE + i];
+
+	for(GLuint i = tBegin; i < tEnd; i++)
+		s->out[i] = p[i - tBegin];
+}
+
+/******************************************************************************
+*                                                                             *
+*                          ForceSolver::accelerations                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param positions                                                           *
+*           Position of each body.                                            *
+*  @param masses                                                              *
+*           Mass of each body.                                                *
+*  @param n                                                                   *
+*           Number of bodies.                                                 *
+*  @param G                                                                   *
+*           Gravitational constant of the system.                             *
+*  @param out                                                                 *
+*           Array of n vectors in which the accelerations are stored.         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Runs one force pass over the whole system in the current reduction mode.   *
+*  Small systems are summed on the calling thread; in DETERMINISTIC mode they *
+*  still go through the same blocks and tree, so the bits never depend on     *
+*  whether the pass was split or not.                                         *
+*                                                                             *
+*******************************************************************************/
+void ForceSolver::accelerations(const glm::vec3* positions,
+                                const GLfloat*   masses,
+                                const GLuint     n,
+                                const GLfloat    G,
+                                      glm::vec3* out)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	/* Publish the inputs of the pass to the tasks. */
+	this->positions = positions;
+	this->masses    = masses;
+	this->n         = n;
+	this->G         = G;
+	this->out       = out;
+	numTiles        = (n + FORCE_TILE_SIZE - 1) / FORCE_TILE_SIZE;
+
+	bool serial = (n < PARALLEL_THRESHOLD) || (pool->getNumWorkers() == 1);
+
+	if(mode == ReductionMode::DETERMINISTIC)
+	{
+		/* Block layout is a function of n alone. */
+		numBlocks = (n + DETERMINISTIC_MIN_BLOCK - 1) / DETERMINISTIC_MIN_BLOCK;
+		numBlocks = glm::clamp(numBlocks, 1u, (GLuint) DETERMINISTIC_MAX_BLOCKS);
+		blockSize = (n + numBlocks - 1) / numBlocks;
+
+		/* A tile's block sums live only while the tile is reduced, so      *
+		 * each worker needs rows for one tile, whatever n is.              */
+		GLuint    numRows = serial ? 1 : pool->getNumWorkers();
+		size_t    rows    = (size_t) numRows * numBlocks * FORCE_TILE_SIZE;
+		if(partials.size() < rows)
+			partials.resize(rows);
+
+		if(serial)
+			for(GLuint t = 0; t < numTiles; t++)
+				tileTask(this, t, 0);
+		else
+			pool->run(tileTask, this, numTiles);
+	}
+	else if(serial)
+	{
+		/* One chunk: a plain sum over all sources. */
+		sum(0, n, 0, n, out);
+	}
+	else
+	{
+		numChunks = pool->getNumWorkers();
+		if(partials.size() < (size_t) numChunks * n)
+			partials.resize((size_t) numChunks * n);
+		for(GLuint i = 0; i < n; i++)
+			out[i] = glm::vec3(0);
+		pool->run(fastTask, this, numChunks);
+	}
+
+	/* Record the time the pass took. */
+	numPasses++;
+	passSeconds += (GLdouble) (SDL_GetPerformanceCounter() - start) /
+	               (GLdouble) SDL_GetPerformanceFrequency();
+}
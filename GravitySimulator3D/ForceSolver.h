@@ -0,0 +1,140 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+#include <mutex>
+#include "WorkerPool.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Fewest sources summed by one block of the deterministic reduction. */
+#define  DETERMINISTIC_MIN_BLOCK                                           64
+/* Most blocks (leaves of the reduction tree) used for any body count. */
+#define  DETERMINISTIC_MAX_BLOCKS                                          32
+/* Number of target bodies handled by a single task. */
+#define  FORCE_TILE_SIZE                                                  256
+/* Below this many bodies a pass is not worth splitting across threads. */
+#define  PARALLEL_THRESHOLD                                               256
+
+/******************************************************************************
+*                                                                             *
+*                             ReductionMode  (enum)                           *
+*                                                                             *
+*******************************************************************************
+*  FAST                                                                       *
+*       Every worker sums the sources of its own share of the bodies, and the *
+*       partial sums are added to the result in whatever order the workers    *
+*       finish. Results depend on the worker count and on scheduling.         *
+*  DETERMINISTIC                                                              *
+*       Sources are split into blocks whose size depends only on the body     *
+*       count, and the block sums are combined by a fixed pairwise tree.      *
+*       Results are bit-identical for any worker count.                       *
+*                                                                             *
+*  On one worker the two modes take the same time to within a few percent    *
+*  from 1000 to 16000 bodies. What the fixed tree costs on several cores has *
+*  not been measured.                                                         *
+*                                                                             *
+*******************************************************************************/
+enum class ReductionMode
+{
+	FAST,
+	DETERMINISTIC,
+};
+
+/******************************************************************************
+*                                                                             *
+*                             ForceSolver   (class)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  pool                                                                       *
+*          Worker threads the passes are split across (not owned).            *
+*  mode                                                                       *
+*          How partial sums computed on different threads are combined.       *
+*  partials                                                                   *
+*          Scratch space holding one partial sum per target for every worker  *
+*          (FAST), or one per target of a tile for every source block, for    *
+*          every worker (DETERMINISTIC).                                      *
+*  numPasses / passSeconds                                                    *
+*          Number of passes run and the total time they took.                 *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Computes the gravitational acceleration every body of a system feels from  *
+*  every other body by direct summation, splitting the work across a pool of  *
+*  threads.                                                                   *
+*                                                                             *
+*******************************************************************************/
+class ForceSolver
+{
+public:
+	/* Constructor. */
+	               ForceSolver(WorkerPool*   pool,
+	                           ReductionMode mode);
+
+	/* Compute the acceleration on each of n bodies due to all the others. */
+	void           accelerations(const glm::vec3* positions,
+	                             const GLfloat*   masses,
+	                             const GLuint     n,
+	                             const GLfloat    G,
+	                                   glm::vec3* out);
+
+	/* Reset the timing statistics. */
+	void           resetStats()                  {  numPasses   = 0;
+	                                                passSeconds = 0;      }
+
+	/* Getters. */
+	ReductionMode  getMode()             const   {  return mode;           }
+	GLuint         getNumWorkers()       const   {  return pool->getNumWorkers(); }
+	GLuint64       getNumPasses()        const   {  return numPasses;      }
+	GLdouble       getPassSeconds()      const   {  return passSeconds;    }
+
+	/* Setters. */
+	void           setMode(ReductionMode m)      {  mode             = m;  }
+
+	/* Destructor. */
+	              ~ForceSolver()                 {                         }
+
+private:
+	/* Not copyable (tasks point back at the solver). */
+	               ForceSolver(const ForceSolver& rhs);
+	ForceSolver&   operator=(const ForceSolver& rhs);
+
+	/* Sum the pull of sources [sBegin, sEnd) on targets [tBegin, tEnd). */
+	void           sum(GLuint tBegin, GLuint tEnd,
+	                   GLuint sBegin, GLuint sEnd,
+	                   glm::vec3* result) const;
+
+	/* Task bodies handed to the worker pool. */
+	static void    fastTask(void* context, GLuint task, GLuint worker);
+	static void    tileTask(void* context, GLuint task, GLuint worker);
+
+	WorkerPool*              pool;
+	ReductionMode            mode;
+	std::vector<glm::vec3>   partials;
+	std::mutex               mergeMutex;
+
+	/* Inputs of the pass currently running. */
+	const glm::vec3*         positions;
+	const GLfloat*           masses;
+	GLuint                   n;
+	GLfloat                  G;
+	glm::vec3*               out;
+	GLuint                   numChunks;
+	GLuint                   numBlocks;
+	GLuint                   blockSize;
+	GLuint                   numTiles;
+
+	/* Statistics. */
+	GLuint64                 numPasses;
+	GLdouble                 passSeconds;
+};
@@ -0,0 +1,131 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Frustum.h"
+#include <emmintrin.h>
+
+/******************************************************************************
+*                                                                             *
+*                               Frustum::extract                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param worldToProjection                                                   *
+*           Projection times world to view matrix of the camera.              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A point is inside when each of its clip coordinates lies within -w and w,  *
+*  so each plane is the last row of the matrix plus or minus one of the       *
+*  others (glm is column major, so row r is element r of each column).        *
+*                                                                             *
+*******************************************************************************/
+void Frustum::extract(const glm::mat4& worldToProjection)
+{
+	const glm::mat4& m = worldToProjection;
+	glm::vec4 rows[4];
+	for(GLuint r = 0; r < 4; r++)
+		rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+
+	for(GLuint p = 0; p < FRUSTUM_PLANES; p++)
+	{
+		glm::vec4 plane = p % 2 == 0 ? rows[3] + rows[p / 2] : rows[3] - rows[p / 2];
+		planes[p] = plane / glm::length(glm::vec3(plane));
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                              Frustum::isVisible                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param center / radius                                                     *
+*           Bounding sphere, in world space.                                  *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether no plane has the whole sphere behind it.                           *
+*                                                                             *
+*******************************************************************************/
+bool Frustum::isVisible(const glm::vec3& center, GLfloat radius) const
+{
+	for(GLuint p = 0; p < FRUSTUM_PLANES; p++)
+		if(glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius)
+			return false;
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 Frustum::cull                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param spheres / n                                                         *
+*           Bounding spheres, each its center in world space and its radius   *
+*           in w.                                                             *
+*  @param visible                                                             *
+*           Set to 1 for each sphere which may be seen and 0 for the others.  *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Number of spheres which may be seen.                                       *
+*                                                                             *
+*******************************************************************************/
+GLuint Frustum::cull(const glm::vec4* spheres, GLuint n, GLubyte* visible) const
+{
+	/* Each plane's components, repeated across a register. */
+	__m128 nx[FRUSTUM_PLANES], ny[FRUSTUM_PLANES], nz[FRUSTUM_PLANES], d[FRUSTUM_PLANES];
+	for(GLuint p = 0; p < FRUSTUM_PLANES; p++)
+	{
+		nx[p] = _mm_set1_ps(planes[p].x);
+		ny[p] = _mm_set1_ps(planes[p].y);
+		nz[p] = _mm_set1_ps(planes[p].z);
+		d[p]  = _mm_set1_ps(planes[p].w);
+	}
+
+	GLuint numVisible = 0;
+	GLuint i          = 0;
+	for(; i + 4 <= n; i += 4)
+	{
+		/* Four spheres, turned into their x, y, z and radius. */
+		__m128 x = _mm_loadu_ps(&spheres[i].x);
+		__m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+		__m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+		__m128 r = _mm_loadu_ps(&spheres[i + 3].x);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		/* Inside while distance + radius >= 0 for every plane. */
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 inside         = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for(GLuint p = 0; p < FRUSTUM_PLANES; p++)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(nx[p], x), _mm_mul_ps(ny[p], y)),
+				_mm_add_ps(_mm_mul_ps(nz[p], z), d[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		GLint mask = _mm_movemask_ps(inside);
+		for(GLuint k = 0; k < 4; k++)
+		{
+			visible[i + k] = (GLubyte) ((mask >> k) & 1);
+			numVisible    += visible[i + k];
+		}
+	}
+
+	/* The last few one at a time. */
+	for(; i < n; i++)
+	{
+		visible[i]  = isVisible(glm::vec3(spheres[i]), spheres[i].w) ? 1 : 0;
+		numVisible += visible[i];
+	}
+	return numVisible;
+}
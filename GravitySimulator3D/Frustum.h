@@ -0,0 +1,56 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Planes of a view frustum. */
+#define  FRUSTUM_PLANES                                                     6
+
+/******************************************************************************
+*                                                                             *
+*                               Frustum   (class)                             *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  planes                                                                     *
+*          Left, right, bottom, top, near and far planes, each (normal,       *
+*          offset) with a unit normal pointing into the frustum, so the       *
+*          distance of a point inside is positive.                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  View frustum of a camera, extracted from its world to projection matrix,   *
+*  against which bounding spheres are tested. A sphere is kept unless it lies *
+*  wholly behind one of the planes, which may keep a few spheres just outside *
+*  a corner of the frustum but never drops a visible one.                     *
+*                                                                             *
+*  cull() tests a whole list of spheres, four at a time with SSE: the         *
+*  spheres are transposed so each register holds one coordinate of four of   *
+*  them, and each plane is a multiply-add against all four.                   *
+*                                                                             *
+*******************************************************************************/
+class Frustum
+{
+public:
+	/* Take the planes of a world to projection transformation. */
+	void           extract(const glm::mat4& worldToProjection);
+	/* Whether a sphere may be seen. */
+	bool           isVisible(const glm::vec3& center, GLfloat radius) const;
+	/* Flag which of n spheres (center, and radius in w) may be seen,       *
+	 * returning how many.                                                  */
+	GLuint         cull(const glm::vec4* spheres, GLuint n,
+	                    GLubyte* visible) const;
+
+private:
+	glm::vec4      planes[FRUSTUM_PLANES];
+};
@@ -8,12 +8,20 @@
 *                                                                             *
 ******************************************************************************/
 #include "Geometry.h"
+#include "Memory.h"
 #include <string>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <GL\glew.h>
 #include <glm\glm.hpp>
 #include <SDL\SDL_image.h>
-#include "tiny_obj_loader.h"
+#include "ObjFile.h"
+#include "AssetPack.h"
+#include "MeshLod.h"
+#include "Icosphere.h"
+#include "TextureArray.h"
 
 /******************************************************************************
 *                                                                             *
@@ -55,8 +63,7 @@ Shader* Geometry::shader = NULL;
 Mesh::Mesh() :
     /* Constructor Initialization. */
     vertices(0), numVertices(0),
-    indices(0), numIndices(0),
-    textureID(-1),
+    indices(0), numIndices(0), indexType(GL_UNSIGNED_SHORT), radius(0),
     numBuffers(DEFAULT_NUM_BUFFERS), bufferIDs(0), vertexArrayID(0),
     drawMode(DEFAULT_DRAW_MODE) 
 {
@@ -66,20 +73,34 @@ Mesh::Mesh(const Mesh& rhs) :
     /* Constructor Initialization. */
 	numVertices(rhs.getNumVertices()),
 	numIndices(rhs.getNumIndices()),
-	textureID(rhs.getTextureID()),
+	indexType(rhs.getIndexType()),
+	levels(rhs.levels),
+	radius(rhs.getRadius()),
 	numBuffers(rhs.getNumBuffers()),
 	vertexArrayID(rhs.getVertexArrayID()),
 	drawMode(rhs.getDrawMode())
 {
-	/* Allocate space for the vertices, indices, and buffers on the heap. */
-	vertices = new Vertex[rhs.getNumVertices()];
-	indices  = new GLushort[rhs.getNumIndices()];
-	bufferIDs = new GLuint[rhs.getNumBuffers()];
-
-	/* Copy the bytes over from the rhs mesh. */
-	memcpy(vertices, rhs.getVertices(), rhs.getNumVertices() * sizeof(Vertex));
-	memcpy(indices, rhs.getIndices(), rhs.getNumIndices() * sizeof(GLushort));
-	memcpy(bufferIDs, rhs.getBufferIDs(), rhs.getNumBuffers() * sizeof(GLuint));
+	/* Allocate space for the vertices, indices, and buffers in the mesh   *
+	 * pools, and copy the bytes over from the rhs mesh. A mesh uploaded    *
+	 * in place (from an asset pack) keeps no vertices or indices.          */
+	vertices  = NULL;
+	indices   = NULL;
+	bufferIDs = NULL;
+	if(rhs.getVertices() != NULL)
+	{
+		vertices = Memory::meshData.allocate<Vertex>(numVertices);
+		memcpy(vertices, rhs.getVertices(), numVertices * sizeof(Vertex));
+	}
+	if(rhs.getIndices() != NULL)
+	{
+		indices = Memory::meshData.allocate(indexBufferSize());
+		memcpy(indices, rhs.getIndices(), indexBufferSize());
+	}
+	if(rhs.getBufferIDs() != NULL)
+	{
+		bufferIDs = Memory::meshData.allocate<GLuint>(numBuffers);
+		memcpy(bufferIDs, rhs.getBufferIDs(), numBuffers * sizeof(GLuint));
+	}
 }
 
 /******************************************************************************
@@ -123,7 +144,7 @@ GLsizeiptr Mesh::vertexBufferSize() const
 *******************************************************************************/
 GLsizeiptr Mesh::indexBufferSize() const
 {
-	return numIndices * sizeof(GLushort);
+	return numIndices * getIndexSize();
 }
 
 /******************************************************************************
@@ -153,19 +174,21 @@ GLsizeiptr Mesh::indexBufferSize() const
 *******************************************************************************/
 void Mesh::setVertices(GLuint n, Vertex* a)
 {
-	/* Set number of vertices. */
+	/* Give back any vertices set before, then set the number of them. */
+	Memory::meshData.free(vertices, numVertices * sizeof(Vertex));
 	numVertices = n;
-	/* Allocate space on the heap. */
-	vertices = new Vertex[n];
+	/* Allocate space in the mesh pools. */
+	vertices = Memory::meshData.allocate<Vertex>(n);
 	/* Copy the data over to the allocated space. */
 	memcpy(vertices, a, sizeof(Vertex) * n);
 }
 void Mesh::setVertices(std::vector<Vertex>* v)
 {
-	/* Set number of vertices. */
+	/* Give back any vertices set before, then set the number of them. */
+	Memory::meshData.free(vertices, numVertices * sizeof(Vertex));
 	numVertices = v->size();
-	/* Allocate space on the heap. */
-	vertices = new Vertex[v->size()];
+	/* Allocate space in the mesh pools. */
+	vertices = Memory::meshData.allocate<Vertex>(v->size());
 	/* Copy the data over to the allocated space. */
 	memcpy(vertices, v->data(), sizeof(Vertex) * v->size());
 }
@@ -186,6 +209,11 @@ void Mesh::setVertices(std::vector<Vertex>* v)
 *           A pointer to a vector containing the values to be set as the      *
 *           indices.                                                          *
 *                                                                             *
+* PARAMETERS (3)                                                              *
+*  v                                                                          *
+*           A pointer to a vector of 32-bit indices, stored in the narrowest  *
+*           type for the vertices already set.                                *
+*                                                                             *
 *******************************************************************************
 * RETURNS                                                                     *
 *  void                                                                       *
@@ -197,178 +225,360 @@ void Mesh::setVertices(std::vector<Vertex>* v)
 *******************************************************************************/
 void Mesh::setIndices(GLuint n, GLushort* a)
 {
-	/* Set number of indices. */
+	/* Give back any indices set before, then set the number of them. */
+	Memory::meshData.free(indices, indexBufferSize());
 	numIndices = n;
-	/* Allocate space on the heap. */
-	indices = new GLushort[n];
+	indexType  = GL_UNSIGNED_SHORT;
+	/* Allocate space in the mesh pools. */
+	indices = Memory::meshData.allocate(indexBufferSize());
 	/* Copy the data over to the allocated space. */
 	memcpy(indices, a, sizeof(GLushort) * n);
 }
 void Mesh::setIndices(std::vector<GLushort>* i)
 {
-	/* Set number of vertices. */
+	/* Give back any indices set before, then set the number of them. */
+	Memory::meshData.free(indices, indexBufferSize());
 	numIndices = i->size();
-	/* Allocate space on the heap. */
-	indices = new GLushort[i->size()];
+	indexType  = GL_UNSIGNED_SHORT;
+	/* Allocate space in the mesh pools. */
+	indices = Memory::meshData.allocate(indexBufferSize());
 	/* Copy the data over to the allocated space. */
 	memcpy(indices, i->data(), sizeof(GLushort) * i->size());
 }
+void Mesh::setIndices(std::vector<GLuint>* i)
+{
+	/* Give back any indices set before, then set the number of them and *
+	 * the narrowest type for the vertices.                               */
+	Memory::meshData.free(indices, indexBufferSize());
+	numIndices = i->size();
+	indexType  = chooseIndexType(numVertices);
+	/* Allocate space in the mesh pools. */
+	indices = Memory::meshData.allocate(indexBufferSize());
+	/* Copy the data over, narrowing it for a small mesh. */
+	if(indexType == GL_UNSIGNED_INT)
+		memcpy(indices, i->data(), sizeof(GLuint) * i->size());
+	else
+		for(GLuint k = 0; k < numIndices; k++)
+			((GLushort*) indices)[k] = (GLushort) (*i)[k];
+}
+
+/******************************************************************************
+*                                                                             *
+*                           Mesh::chooseIndexType  (static)                   *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  numVertices                                                                *
+*           Number of vertices the indices refer to.                          *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  GL_UNSIGNED_SHORT if every vertex fits in 16 bits, else GL_UNSIGNED_INT.   *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Small meshes keep 16-bit indices, which halves the index bandwidth.        *
+*                                                                             *
+*******************************************************************************/
+GLenum Mesh::chooseIndexType(GLuint numVertices)
+{
+	return numVertices > MAX_SHORT_INDEXED_VERTICES ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
+/******************************************************************************
+*                                                                             *
+*                               Mesh::setLevels                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  n                                                                          *
+*           The number of levels (0 for the whole mesh only).                 *
+*  a                                                                          *
+*           The levels, finest first.                                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Must be called after the indices are set. A mesh always has at least one   *
+*  level, drawing all of its indices.                                         *
+*                                                                             *
+*******************************************************************************/
+void Mesh::setLevels(GLuint n, const MeshLevel* a)
+{
+	if(n == 0)
+	{
+		MeshLevel full = { 0, numIndices, 0.0f };
+		levels.assign(1, full);
+	}
+	else
+		levels.assign(a, a + n);
+}
 
 /******************************************************************************
 *                                                                             *
-*                                 Mesh::loadObj                               *
+*                               Mesh::setRadius                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  n                                                                          *
+*           The number of vertices.                                           *
+*  a                                                                          *
+*           The vertices of the mesh.                                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void Mesh::setRadius(GLuint n, const Vertex* a)
+{
+	GLfloat furthest = 0.0f;
+	for(GLuint i = 0; i < n; i++)
+		furthest = std::max(furthest, glm::dot(a[i].position, a[i].position));
+	radius = sqrt(furthest);
+}
+
+/******************************************************************************
+*                                                                             *
+*                               Geometry::loadObj                             *
 *                                                                             *
 *******************************************************************************
 * PARAMETERS                                                                  *
 *  @param objFile                                                             *
 *        The path to the OBJ file that is to be loaded. Must point to a valid *
 *        OBJ file.                                                            *
-*  @param textureFile (optional)                                              *
-*        The path to the texture file to be loaded. Can point to any valid    *
-*        image format. By default this parameter is NULL.                     *
 *                                                                             *
 *******************************************************************************
 * RETURNS                                                                     *
-*  void                                                                       *
+*  The new Mesh, or nullptr if the file could not be loaded.                  *
 *                                                                             *
 *******************************************************************************
 * DESCRIPTION                                                                 *
 *  Loads an OBJ file and generates a Mesh object based on the Vertex and      *
-*  Index data. This function also allows the option for the caller to apply a *
-*  texture to the newly loaded Mesh via the textureFile parameter.            *
+*  Index data. Textures are loaded separately, by loadTexture(). A mesh found *
+*  in the asset pack is uploaded from it instead (see AssetPack.h).           *
 *                                                                             *
 *******************************************************************************/
-Mesh* Geometry::loadObj(const char* objFile, const char* textureFile)
+Mesh* Geometry::loadObj(const char* objFile)
 {
-	/* Create a new Mesh object on the heap. */
-	Mesh* obj = new Mesh();
-
-	/* Declare the Vectors for shape and material data. */
-	std::vector<tinyobj::shape_t>    shapes;
-	std::vector<tinyobj::material_t> materials;
-
-	/* Load the indicated OBJ file and get the error message. */
-	std::string errMsg = tinyobj::LoadObj(shapes, materials, objFile);
+	const PackEntry* packed = AssetPack::find(PACK_MESH, objFile);
+	if(packed != nullptr)
+		return AssetPack::createMesh(packed);
+
+	std::vector<Vertex>   vertices;
+	std::vector<GLuint>   indices;
+	std::vector<MeshLevel> levels;
+	if(!parseObj(objFile, &vertices, &indices, &levels))
+		return nullptr;
+	return createMesh(&vertices, &indices, &levels);
+}
 
-	/* If there was an error message, prompt the user and exit function. */
-	if (!errMsg.empty())
+/******************************************************************************
+*                                                                             *
+*                               Geometry::parseObj                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param objFile                                                             *
+*        The path to the OBJ file that is to be parsed, or the name of a      *
+*        procedural sphere, which is generated instead (see Icosphere.h).     *
+*  @param vertices / indices                                                  *
+*        Filled with the Vertex and Index data of the first shape.            *
+*  @param levels (optional)                                                   *
+*        If given, the levels of detail are built and appended to vertices    *
+*        and indices (see MeshLod.h), and their ranges put here.              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file could be parsed.                                          *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  CPU half of loadObj(). It makes no OpenGL calls, so it can run on any     *
+*  thread.                                                                    *
+*                                                                             *
+*******************************************************************************/
+bool Geometry::parseObj(const char* objFile, std::vector<Vertex>* vertices,
+                        std::vector<GLuint>* indices,
+                        std::vector<MeshLevel>* levels)
+{
+	/* A procedural sphere comes with its own levels of detail. */
+	GLuint subdivisions;
+	if(Icosphere::parseName(objFile, &subdivisions))
 	{
-		std::cerr << "Error loading obj: " << errMsg << std::endl;
-		return nullptr;
+		Icosphere::generate(subdivisions, vertices, indices, levels);
+		return true;
 	}
 
-	/* Get the shape from the file. */
-	tinyobj::shape_t  s = shapes.at(0);
-
-	/* Copy over the Vertex data. */
-	std::vector<Vertex> localVertices;
-	for(GLuint i = 0; i < (s.mesh.positions.size() / 3); i++) 
-		localVertices.push_back({
-
-			/* Vertex Position. */
-			{s.mesh.positions.at((3 * i) + 0), 
-			 s.mesh.positions.at((3 * i) + 1), 
-			 s.mesh.positions.at((3 * i) + 2)},
-
-			/* Vertex Color. */
-			DEFAULT_VERTEX_COLOR,
-
-			/* Vertex Normal. */
-			{s.mesh.normals.at((3 * i) + 0), 
-			 s.mesh.normals.at((3 * i) + 1), 
-			 s.mesh.normals.at((3 * i) + 2)},
-
-			/* U, V Coordinate. */
-			{    s.mesh.texcoords.at((2 * i) + 0), 
-			 1 - s.mesh.texcoords.at((2 * i) + 1) }
-
-		});
+	/* Read the whole file in one pass (see ObjFile.h). The indices are   *
+	 * narrowed, if the mesh is small enough, when the Mesh is created.   */
+	if(!ObjFile::parse(objFile, vertices, indices))
+		return false;
+	if(levels != NULL)
+		MeshLod::build(vertices, indices, levels);
+	return true;
+}
 
-	/* Copy the Index data. */
-	std::vector<GLushort> localIndices;
-	for(GLuint i = 0; i < s.mesh.indices.size(); i++) 
-		localIndices.push_back(
-			(GLushort) s.mesh.indices.at(i)
-		);
+/******************************************************************************
+*                                                                             *
+*                              Geometry::createMesh                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param vertices / indices / levels                                         *
+*        Vertex and Index data and levels of detail, as parsed by parseObj(). *
+*        Without levels, the whole mesh is its only level.                    *
+*  @param numVertices, vertices / numIndices, indexType, indices /            *
+*         numLevels, levels (overloaded)                                      *
+*        Arrays to be uploaded where they lie, such as in a mapped asset      *
+*        pack. The Mesh's own vertices and indices are NULL.                  *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The new Mesh, with its buffers on the graphics hardware.                   *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  GL half of loadObj(). Must be called on the thread owning the context.     *
+*                                                                             *
+*******************************************************************************/
+Mesh* Geometry::createMesh(std::vector<Vertex>* vertices,
+                           std::vector<GLuint>* indices,
+                           const std::vector<MeshLevel>* levels)
+{
+	/* Create a new Mesh object on the heap. */
+	Mesh* obj = new Mesh();
 
-	/* Set the vertices and indices of this mesh. */
-	obj->setVertices(&localVertices);
-	obj->setIndices(&localIndices);
+	/* Set the vertices, indices, and levels of this mesh. */
+	obj->setVertices(vertices);
+	obj->setIndices(indices);
+	if(levels != NULL && !levels->empty())
+		obj->setLevels(levels->size(), levels->data());
+	else
+		obj->setLevels(0, NULL);
+	obj->setRadius(vertices->size(), vertices->data());
 	
 	/* Generate buffer and vertex arrays. */
 	obj->genBufferArrayID();
 	obj->genVertexArrayID();
 
-	/* If the texture file was provided, generate the texture. */
-	if (textureFile != NULL)
-		obj->genTextureID(textureFile);
-
 	/* Return the mesh. */
 	return obj;
 }
+Mesh* Geometry::createMesh(GLuint numVertices, const Vertex* vertices,
+                           GLuint numIndices, GLenum indexType,
+                           const GLvoid* indices, GLuint numLevels,
+                           const MeshLevel* levels)
+{
+	/* The arrays are uploaded in place; the mesh keeps no copy of them. */
+	Mesh* obj = new Mesh();
+	obj->setNumVertices(numVertices);
+	obj->setNumIndices(numIndices);
+	obj->setIndexType(indexType);
+	obj->setLevels(numLevels, levels);
+	obj->setRadius(numVertices, vertices);
+	obj->genBufferArrayID(vertices, indices);
+	obj->genVertexArrayID();
+	return obj;
+}
 
 /******************************************************************************
 *                                                                             *
-*                               Mesh::genTextureID                            *
+*                             Geometry::loadTexture                           *
 *                                                                             *
 *******************************************************************************
 * PARAMETERS                                                                  *
-*  filename                                                                   *
+*  imageFile                                                                  *
 *        The path to the texture that is to be loaded. Can be of any valid    *
 *        image format.                                                        *
+*  bytes (optional)                                                           *
+*        Set to the size of the texture on the graphics hardware.             *
 *                                                                             *
 *******************************************************************************
 * RETURNS                                                                     *
-*  void                                                                       *
+*  Handle of the new texture, or 0 if the image could not be loaded.          *
 *                                                                             *
-*******************************************************************************
 * DESCRIPTION                                                                 *
-*  Generates the texture buffer and sends the data from the indicated file    *
-*  down to the graphics hardware. The texture ID is saved to the indicated    *
-*  parameter for this Mesh.                                                   *
+*  A texture found in the asset pack is uploaded from it, mip chain and all.  *
+*  Any other is decoded and given its mip chain here.                         *
 *                                                                             *
 *******************************************************************************/
-void Mesh::genTextureID(const char* filename)
+GLuint Geometry::loadTexture(const char* imageFile, GLuint64* bytes)
 {
-	/* Enable Texture 2D. */
-	glEnable(GL_TEXTURE_2D);
+	const PackEntry* packed = AssetPack::find(PACK_TEXTURE, imageFile);
+	if(packed != nullptr)
+		return AssetPack::createTexture(packed, bytes);
+
+	PackEntry                  entry;
+	std::vector<unsigned char> levels;
+	if(!decodeTexture(imageFile, &entry, &levels))
+		return 0;
+	return TextureArray::add(&entry, levels.data(), bytes);
+}
 
+/******************************************************************************
+*                                                                             *
+*                             Geometry::decodeImage                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  imageFile                                                                  *
+*        The path to the image that is to be decoded.                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The decoded image, or NULL if it could not be loaded.                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  CPU half of loadTexture(), which can run on any thread (once IMG_Init has  *
+*  loaded the image libraries).                                               *
+*                                                                             *
+*******************************************************************************/
+SDL_Surface* Geometry::decodeImage(const char* imageFile)
+{
 	/* If the filename is null, do nothing. */
-	if(filename != NULL) 
-	{
-		/* Load the SDL_Surface from the file. */
-		SDL_Surface* textureSurface = IMG_Load(filename);
-
-		/* If the image was not loaded correctly, do nothing. */
-		if(textureSurface != NULL) 
-		{
-			/* The default color scheme is RGB. */
-			GLenum colorScheme = GL_RGB;
-
-			/* If the file is a bitmap, change the color scheme to BGR. */
-			std::string file(filename);
-			std::string ext = file.substr(file.find('.'), file.length() - 1);
-			if(ext == ".bmp") 
-				colorScheme = GL_BGR;
-
-			/* Generate the texture buffer. */
-			glGenTextures(1, &textureID);
-
-			/* Bind the texture ID to the appropriate binding point. */
-			glBindTexture(GL_TEXTURE_2D, textureID);
-
-			/* Send the image data down to the graphics card. */
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureSurface->w, 
-				textureSurface->h, 0, colorScheme, GL_UNSIGNED_BYTE, 
-				textureSurface->pixels);
-
-			/* Set the desred texture parameters. */
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		}
-	}
+	if(imageFile == NULL) 
+		return NULL;
+
+	/* Load the SDL_Surface from the file. */
+	SDL_Surface* textureSurface = IMG_Load(imageFile);
+	if(textureSurface == NULL) 
+		std::cerr << "Error loading texture: " << imageFile << std::endl;
+	return textureSurface;
+}
+
+/******************************************************************************
+*                                                                             *
+*                            Geometry::decodeTexture                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  imageFile                                                                  *
+*        The path to the image that is to be decoded.                         *
+*  entry / levels                                                             *
+*        Filled with the format and size of the texture, and its mip levels   *
+*        laid out as in an asset pack.                                        *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the image was decoded.                                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  CPU half of loadTexture(), which can run on any thread. The mip chain is   *
+*  built with a box filter, and compressed to BC1 if the hardware reads it,   *
+*  so the GL half is only the upload into a TextureArray.                     *
+*                                                                             *
+*******************************************************************************/
+bool Geometry::decodeTexture(const char* imageFile, PackEntry* entry,
+                             std::vector<unsigned char>* levels)
+{
+	return AssetPack::encodeTexture(decodeImage(imageFile), imageFile,
+		GLEW_EXT_texture_compression_s3tc != GL_FALSE, entry, levels);
 }
 /******************************************************************************
 *                                                                             *
@@ -386,23 +596,31 @@ void Mesh::genTextureID(const char* filename)
 * DESCRIPTION                                                                 *
 *  Generates the graphics hardware buffers for data regarding this Mesh. The  *
 *  two specific buffers for this class are the vertex buffer and the index    *
-*  buffer. The IDs of these buffers are stored in the bufferIDs array.        *
+*  buffer. The IDs of these buffers are stored in the bufferIDs array. The    *
+*  overload uploads the given arrays in place of the Mesh's own.              *
 *                                                                             *
 *******************************************************************************/
 void Mesh::genBufferArrayID()
+{
+	genBufferArrayID(vertices, indices);
+}
+void Mesh::genBufferArrayID(const Vertex* vertexData, const GLvoid* indexData)
 {
 	/* Generate the buffer space. */
-	bufferIDs = new GLuint[numBuffers];
+	Memory::meshData.free(bufferIDs, numBuffers * sizeof(GLuint));
+	bufferIDs = Memory::meshData.allocate<GLuint>(numBuffers);
 	glGenBuffers(numBuffers, bufferIDs);
 
 	/* Create vertex buffer. */
 	glBindBuffer(GL_ARRAY_BUFFER, bufferIDs[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertexBufferSize(), vertices,
+	glBufferData(GL_ARRAY_BUFFER, vertexBufferSize(), vertexData,
 		GL_STATIC_DRAW);
 
-	/* Create index buffer. */
+	/* Create index buffer (with no vertex array bound, as the binding   *
+	 * would otherwise replace that vertex array's own index buffer).    */
+	glBindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferIDs[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize(), indices, 
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize(), indexData, 
 		GL_STATIC_DRAW);
 }
 
@@ -424,7 +642,7 @@ void Mesh::genBufferArrayID()
 *  object keeps track of the vertex attribute locations for this specific     *
 *  mesh. To draw this mesh, the vertex array object must be bound before      *
 *  telling OpenGL to draw its elements. The vertex array ID is stored in the  *
-*  vertexArrayID value.                                                       *
+*  vertexArrayID value. The index buffer is bound with it.                    *
 *                                                                             *
 *******************************************************************************/
 void Mesh::genVertexArrayID()
@@ -435,8 +653,10 @@ void Mesh::genVertexArrayID()
 	/* Bind this vertex array ID.*/
 	glBindVertexArray(vertexArrayID);
 
-	/* Bind the vertex buffer. */
+	/* Bind the vertex buffer, and the index buffer, which the vertex     *
+	 * array keeps so it need not be bound again to draw.                 */
 	glBindBuffer(GL_ARRAY_BUFFER, bufferIDs[0]);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferIDs[1]);
 
 	/* Enable the vertex attributes. */
 	glEnableVertexAttribArray(0);
@@ -491,10 +711,10 @@ void Mesh::cleanUp()
 	glDeleteBuffers(numBuffers, bufferIDs);
 	glDeleteBuffers(1, &vertexArrayID);
 
-	/* Free the space allocated on the heap for vertex/index data. */
-	delete[] vertices;
-	delete[] indices;
-	delete[] bufferIDs;
+	/* Give the vertex/index data back to the mesh pools. */
+	Memory::meshData.free(vertices, numVertices * sizeof(Vertex));
+	Memory::meshData.free(indices, indexBufferSize());
+	Memory::meshData.free(bufferIDs, numBuffers * sizeof(GLuint));
 
 	/* Remove any dangling pointers. */
 	vertices = NULL;
@@ -10,6 +10,7 @@
 #include <glm\glm.hpp>
 #include <vector>
 #include <map>
+#include <climits>
 #include "Shader.h"
 
 /******************************************************************************
@@ -24,6 +25,8 @@
 #define ATTRIBUTE_1_OFFSET      (sizeof(GLfloat) * 3)
 #define ATTRIBUTE_2_OFFSET      (sizeof(GLfloat) * 6)
 #define ATTRIBUTE_3_OFFSET      (sizeof(GLfloat) * 9)
+/* Most vertices a mesh drawn with 16-bit indices can have. */
+#define MAX_SHORT_INDEXED_VERTICES  (USHRT_MAX + 1)
 
 /******************************************************************************
 *                                                                             *
@@ -77,6 +80,30 @@ struct Triangle
 	GLushort       v3;
 };
 
+/******************************************************************************
+*                                                                             *
+*                          Geometry::MeshLevel (struct)                       *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  firstIndex / numIndices                                                    *
+*          Range of the index buffer drawn for this level of detail.          *
+*  error                                                                      *
+*          About how far, in model units, a vertex of the level is from the   *
+*          surface of the full mesh (0 for the full mesh itself).             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  One level of detail of a Mesh (see MeshLod.h).                             *
+*                                                                             *
+*******************************************************************************/
+struct MeshLevel
+{
+	GLuint         firstIndex;
+	GLuint         numIndices;
+	GLfloat        error;
+};
+
 /******************************************************************************
 *                                                                             *
 *                           Geometry::Mesh   (class)                          *
@@ -84,18 +111,24 @@ struct Triangle
 *******************************************************************************
 * MEMBERS                                                                     *
 *  vertices                                                                   *
-*          Pointer to the collection of Vertex structs for this mesh.         *
+*          Pointer to the collection of Vertex structs for this mesh (NULL,   *
+*          like indices, for a mesh uploaded straight from an asset pack).    *
 *  numVertices                                                                *
 *          Number of vertices in this Mesh object.                            *
 *  indices                                                                    *
 *          Pointer to the written order in which the traingles are to be      *
 *          drawn.                                                             *
+*  indexType                                                                  *
+*          GL_UNSIGNED_SHORT, or GL_UNSIGNED_INT for a mesh of more than      *
+*          MAX_SHORT_INDEXED_VERTICES vertices (see chooseIndexType).         *
 *  numIndices                                                                 *
 *          Number of indices used to draw the Mesh object.                    *
-*  texutreSurface                                                             *
-*          Pointer to the SDL_Surface conatining the texture data.            *
-*  textureID                                                                  *
-*          ID of the texture buffer in which the texture is located.          *
+*  levels                                                                     *
+*          Levels of detail, finest (the whole mesh) first. Each is a range   *
+*          of the one index buffer.                                           *
+*  radius                                                                     *
+*          Distance of the furthest vertex from the origin of the model, the  *
+*          bounding sphere the mesh is culled with.                           *
 *  numBuffers                                                                 *
 *          Number of buffers to be generated for the Mesh object.             *
 *  bufferIDs                                                                  *
@@ -127,8 +160,10 @@ public:
 	GLsizeiptr	   indexBufferSize()     const;
 	/* Generate the graphics buffers and IDs for the mesh.  */
 	void           genBufferArrayID();
-	/* Generate the texture buffer and ID for the mesh.  */
-	void           genTextureID(const char* filename);
+	void           genBufferArrayID(const Vertex* vertexData,
+	                                const GLvoid* indexData);
+	/* Narrowest index type able to address numVertices vertices. */
+	static GLenum  chooseIndexType(GLuint numVertices);
 	/* Generate the vertex array object and ID for the mesh. */
 	void           genVertexArrayID();
 
@@ -136,10 +171,21 @@ public:
 	Vertex*        getVertices()         const   {  return vertices;       }
 	Vertex         getVertex(GLuint i)   const   {  return vertices[i];    }
 	GLuint         getNumVertices()      const   {  return numVertices;    }
-	GLushort*      getIndices()          const   {  return indices;        }
-	GLushort       getIndex(GLuint i)    const   {  return indices[i];     }
+	GLvoid*        getIndices()          const   {  return indices;        }
+	GLuint         getIndex(GLuint i)    const
+	{
+		return indexType == GL_UNSIGNED_INT ?
+			((GLuint*) indices)[i] : ((GLushort*) indices)[i];
+	}
 	GLuint         getNumIndices()       const   {  return numIndices;     }
-	GLuint         getTextureID()        const   {  return textureID;      }
+	GLuint         getNumLevels()        const   {  return levels.size();  }
+	const MeshLevel& getLevel(GLuint i)  const   {  return levels[i];      }
+	GLfloat        getRadius()           const   {  return radius;         }
+	GLenum         getIndexType()        const   {  return indexType;      }
+	GLuint         getIndexSize()        const
+	{
+		return indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+	}
 	GLuint         getNumBuffers()       const   {  return numBuffers;     }
 	GLuint*        getBufferIDs()        const   {  return bufferIDs;      }
 	GLuint         getBufferID(GLuint i) const   {  return bufferIDs[i];   } 
@@ -153,7 +199,14 @@ public:
 	void           setIndices(GLuint n, 
                               GLushort* a);
 	void           setIndices(std::vector<GLushort>* v);
-	void           setTextureID(GLuint t)        {  textureID        = t;  }
+	void           setIndices(std::vector<GLuint>* v);
+	void           setNumVertices(GLuint n)      {  numVertices      = n;  }
+	void           setNumIndices(GLuint n)       {  numIndices       = n;  }
+	void           setIndexType(GLenum t)        {  indexType        = t;  }
+	void           setLevels(GLuint n,
+	                         const MeshLevel* a);
+	void           setRadius(GLuint n,
+	                         const Vertex* a);
 	void           setNumBuffers(GLuint n)       {  numBuffers       = n;  }
 	void           setBufferIDs(GLuint* b)       {  bufferIDs        = b;  }
 	void           setVertexArrayID(GLuint v)    {  vertexArrayID    = v;  }
@@ -167,10 +220,12 @@ protected:
 	Vertex*        vertices;
 	GLuint         numVertices;
 	/* Index Data */
-	GLushort*      indices;
+	GLvoid*        indices;
 	GLuint         numIndices;
-	/* Texture Data */
-	GLuint         textureID;
+	GLenum         indexType;
+	/* Levels of Detail */
+	std::vector<MeshLevel> levels;
+	GLfloat        radius;
 	/* Buffer Data */
 	GLuint         numBuffers;
 	GLuint*        bufferIDs;
@@ -191,14 +246,39 @@ protected:
 *******************************************************************************
 * DESCRIPTION                                                                 *
 *  Class consisitng of static functions to create a series of shapes.         *
+*  Meshes and textures are loaded separately, so bodies which share a mesh    *
+*  can still be textured differently (see AssetCache).                        *
 *                                                                             *
 *******************************************************************************/
+struct PackEntry;
 class Geometry
 {
 public:
 	/* Shader program. */
 	static Shader*   shader;
 	/* Load from .obj file. */
-	static Mesh*     loadObj(const char* objFile, 
-                             const char* textFile = NULL);
+	static Mesh*     loadObj(const char* objFile);
+	/* Load a texture from an image file into a TextureArray, returning its *
+	 * handle (0 if it cannot be loaded).                                   */
+	static GLuint    loadTexture(const char* imageFile, 
+	                             GLuint64* bytes = NULL);
+
+	/* The two halves of loadObj: parsing (any thread) and upload (GL). */
+	static bool      parseObj(const char* objFile, 
+	                          std::vector<Vertex>* vertices,
+	                          std::vector<GLuint>* indices,
+	                          std::vector<MeshLevel>* levels = NULL);
+	static Mesh*     createMesh(std::vector<Vertex>* vertices,
+	                            std::vector<GLuint>* indices,
+	                            const std::vector<MeshLevel>* levels = NULL);
+	static Mesh*     createMesh(GLuint numVertices, const Vertex* vertices,
+	                            GLuint numIndices, GLenum indexType,
+	                            const GLvoid* indices, GLuint numLevels = 0,
+	                            const MeshLevel* levels = NULL);
+	/* The halves of loadTexture: decoding the image and encoding its mip   *
+	 * chain (any thread), and TextureArray::add (GL).                      */
+	static SDL_Surface* decodeImage(const char* imageFile);
+	static bool      decodeTexture(const char* imageFile,
+	                               PackEntry* entry,
+	                               std::vector<unsigned char>* levels);
 };
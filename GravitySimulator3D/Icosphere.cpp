@@ -0,0 +1,411 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Icosphere.h"
+#include "MeshLod.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+/******************************************************************************
+*                                                                             *
+*                                  Baked Levels                               *
+*                                                                             *
+******************************************************************************/
+/* Positions of the vertices of the baked levels: the poles, the two rings    *
+ * of the icosahedron (the lower turned 36 degrees from the upper), then the  *
+ * vertices added by each subdivision, in the order subdivide() adds them.    */
+static const GLfloat bakedPositions[ICOSPHERE_BAKED_VERTICES][3] =
+{
+	{ +0.00000000f, +1.00000000f, +0.00000000f }, { +0.00000000f, -1.00000000f, +0.00000000f },
+	{ +0.89442718f, +0.44721359f, +0.00000000f }, { +0.27639320f, +0.44721359f, +0.85065079f },
+	{ -0.72360682f, +0.44721359f, +0.52573109f }, { -0.72360682f, +0.44721359f, -0.52573109f },
+	{ +0.27639320f, +0.44721359f, -0.85065079f }, { +0.72360682f, -0.44721359f, +0.52573109f },
+	{ -0.27639320f, -0.44721359f, +0.85065079f }, { -0.89442718f, -0.44721359f, +0.00000000f },
+	{ -0.27639320f, -0.44721359f, -0.85065079f }, { +0.72360682f, -0.44721359f, -0.52573109f },
+	{ +0.16245985f, +0.85065085f, +0.49999997f }, { +0.68819094f, +0.52573109f, +0.49999997f },
+	{ +0.52573109f, +0.85065085f, +0.00000000f }, { +0.58778524f, +0.00000000f, +0.80901694f },
+	{ +0.95105654f, +0.00000000f, +0.30901697f }, { +0.00000000f, +0.00000000f, +0.99999994f },
+	{ +0.26286557f, -0.52573109f, +0.80901694f }, { +0.42532542f, -0.85065085f, +0.30901697f },
+	{ -0.16245985f, -0.85065085f, +0.49999997f }, { -0.42532542f, +0.85065085f, +0.30901697f },
+	{ -0.26286557f, +0.52573109f, +0.80901694f }, { -0.58778524f, +0.00000000f, +0.80901694f },
+	{ -0.95105654f, +0.00000000f, +0.30901697f }, { -0.68819094f, -0.52573109f, +0.49999997f },
+	{ -0.52573109f, -0.85065085f, +0.00000000f }, { -0.42532542f, +0.85065085f, -0.30901697f },
+	{ -0.85065085f, +0.52573109f, +0.00000000f }, { -0.95105654f, +0.00000000f, -0.30901697f },
+	{ -0.58778524f, +0.00000000f, -0.80901694f }, { -0.68819094f, -0.52573109f, -0.49999997f },
+	{ -0.16245985f, -0.85065085f, -0.49999997f }, { +0.16245985f, +0.85065085f, -0.49999997f },
+	{ -0.26286557f, +0.52573109f, -0.80901694f }, { +0.00000000f, +0.00000000f, -0.99999994f },
+	{ +0.58778524f, +0.00000000f, -0.80901694f }, { +0.26286557f, -0.52573109f, -0.80901694f },
+	{ +0.42532542f, -0.85065085f, -0.30901697f }, { +0.68819094f, +0.52573109f, -0.49999997f },
+	{ +0.95105654f, +0.00000000f, -0.30901697f }, { +0.85065085f, -0.52573109f, +0.00000000f },
+	{ +0.08444399f, +0.96193826f, +0.25989187f }, { +0.36180338f, +0.89442718f, +0.26286551f },
+	{ +0.27326649f, +0.96193826f, +0.00000000f }, { +0.50137526f, +0.50572091f, +0.70204645f },
+	{ +0.44721362f, +0.72360682f, +0.52573109f }, { +0.22810870f, +0.67460889f, +0.70204639f },
+	{ +0.73817527f, +0.67460889f, +0.00000000f }, { +0.63819659f, +0.72360682f, +0.26286554f },
+	{ +0.82261926f, +0.50572085f, +0.25989187f }, { +0.86180341f, +0.27639320f, +0.42532539f },
+	{ +0.95925254f, +0.23245437f, +0.16062202f }, { +0.44918600f, +0.23245440f, +0.86266851f },
+	{ +0.67082042f, +0.27639320f, +0.68819100f }, { +0.87046283f, -0.23245437f, +0.43388849f },
+	{ +0.80901700f, +0.00000000f, +0.58778524f }, { +0.68164033f, -0.23245437f, +0.69378042f },
+	{ +0.44721362f, -0.27639320f, +0.85065079f }, { +0.51275241f, -0.50572091f, +0.69378048f },
+	{ +0.14366470f, +0.23245437f, +0.96193826f }, { +0.30901700f, +0.00000000f, +0.95105654f },
+	{ -0.00703144f, -0.50572091f, +0.86266851f }, { +0.13819662f, -0.27639320f, +0.95105654f },
+	{ -0.14366470f, -0.23245437f, +0.96193826f }, { +0.22107726f, -0.96193826f, +0.16062202f },
+	{ +0.13819660f, -0.89442718f, +0.42532536f }, { -0.08444399f, -0.96193826f, +0.25989187f },
+	{ +0.36180344f, -0.72360682f, +0.58778524f }, { +0.59719634f, -0.67460889f, +0.43388849f },
+	{ -0.22810870f, -0.67460889f, +0.70204639f }, { +0.05278642f, -0.72360682f, +0.68819100f },
+	{ -0.22107726f, +0.96193826f, +0.16062202f }, { -0.13819660f, +0.89442718f, +0.42532536f },
+	{ -0.51275241f, +0.50572091f, +0.69378048f }, { -0.36180344f, +0.72360682f, +0.58778524f },
+	{ -0.59719634f, +0.67460889f, +0.43388849f }, { -0.05278642f, +0.72360682f, +0.68819100f },
+	{ +0.00703144f, +0.50572091f, +0.86266851f }, { -0.13819662f, +0.27639320f, +0.95105654f },
+	{ -0.68164033f, +0.23245437f, +0.69378042f }, { -0.44721362f, +0.27639320f, +0.85065079f },
+	{ -0.30901700f, +0.00000000f, +0.95105654f }, { -0.44918600f, -0.23245440f, +0.86266851f },
+	{ -0.67082042f, -0.27639320f, +0.68819100f }, { -0.50137526f, -0.50572091f, +0.70204645f },
+	{ -0.87046283f, +0.23245437f, +0.43388849f }, { -0.80901700f, +0.00000000f, +0.58778524f },
+	{ -0.82261926f, -0.50572085f, +0.25989187f }, { -0.86180341f, -0.27639320f, +0.42532539f },
+	{ -0.95925254f, -0.23245437f, +0.16062202f }, { -0.36180338f, -0.89442718f, +0.26286551f },
+	{ -0.27326649f, -0.96193826f, +0.00000000f }, { -0.44721362f, -0.72360682f, +0.52573109f },
+	{ -0.73817527f, -0.67460889f, +0.00000000f }, { -0.63819659f, -0.72360682f, +0.26286554f },
+	{ -0.22107726f, +0.96193826f, -0.16062202f }, { -0.44721359f, +0.89442718f, +0.00000000f },
+	{ -0.81827360f, +0.50572085f, -0.27326649f }, { -0.67082047f, +0.72360682f, -0.16245985f },
+	{ -0.59719634f, +0.67460889f, -0.43388849f }, { -0.67082047f, +0.72360682f, +0.16245985f },
+	{ -0.81827360f, +0.50572085f, +0.27326649f }, { -0.94721359f, +0.27639318f, +0.16245984f },
+	{ -0.87046283f, +0.23245437f, -0.43388849f }, { -0.94721359f, +0.27639318f, -0.16245984f },
+	{ -1.00000000f, +0.00000000f, +0.00000000f }, { -0.95925254f, -0.23245437f, -0.16062202f },
+	{ -0.86180341f, -0.27639320f, -0.42532539f }, { -0.82261926f, -0.50572085f, -0.25989187f },
+	{ -0.68164033f, +0.23245437f, -0.69378042f }, { -0.80901700f, +0.00000000f, -0.58778524f },
+	{ -0.50137526f, -0.50572091f, -0.70204645f }, { -0.67082042f, -0.27639320f, -0.68819100f },
+	{ -0.44918600f, -0.23245440f, -0.86266851f }, { -0.36180338f, -0.89442718f, -0.26286551f },
+	{ -0.08444399f, -0.96193826f, -0.25989187f }, { -0.63819659f, -0.72360682f, -0.26286554f },
+	{ -0.22810870f, -0.67460889f, -0.70204639f }, { -0.44721362f, -0.72360682f, -0.52573109f },
+	{ +0.08444399f, +0.96193826f, -0.25989187f }, { -0.13819660f, +0.89442718f, -0.42532536f },
+	{ +0.00703144f, +0.50572091f, -0.86266851f }, { -0.05278642f, +0.72360682f, -0.68819100f },
+	{ +0.22810870f, +0.67460889f, -0.70204639f }, { -0.36180344f, +0.72360682f, -0.58778524f },
+	{ -0.51275241f, +0.50572091f, -0.69378048f }, { -0.44721362f, +0.27639320f, -0.85065079f },
+	{ +0.14366470f, +0.23245437f, -0.96193826f }, { -0.13819662f, +0.27639320f, -0.95105654f },
+	{ -0.30901700f, +0.00000000f, -0.95105654f }, { -0.14366470f, -0.23245437f, -0.96193826f },
+	{ +0.13819662f, -0.27639320f, -0.95105654f }, { -0.00703144f, -0.50572091f, -0.86266851f },
+	{ +0.44918600f, +0.23245440f, -0.86266851f }, { +0.30901700f, +0.00000000f, -0.95105654f },
+	{ +0.51275241f, -0.50572091f, -0.69378048f }, { +0.44721362f, -0.27639320f, -0.85065079f },
+	{ +0.68164033f, -0.23245437f, -0.69378042f }, { +0.13819660f, -0.89442718f, -0.42532536f },
+	{ +0.22107726f, -0.96193826f, -0.16062202f }, { +0.05278642f, -0.72360682f, -0.68819100f },
+	{ +0.59719634f, -0.67460889f, -0.43388849f }, { +0.36180344f, -0.72360682f, -0.58778524f },
+	{ +0.36180338f, +0.89442718f, -0.26286551f }, { +0.82261926f, +0.50572085f, -0.25989187f },
+	{ +0.63819659f, +0.72360682f, -0.26286554f }, { +0.44721362f, +0.72360682f, -0.52573109f },
+	{ +0.50137526f, +0.50572091f, -0.70204645f }, { +0.67082042f, +0.27639320f, -0.68819100f },
+	{ +0.95925254f, +0.23245437f, -0.16062202f }, { +0.86180341f, +0.27639320f, -0.42532539f },
+	{ +0.80901700f, +0.00000000f, -0.58778524f }, { +0.87046283f, -0.23245437f, -0.43388849f },
+	{ +0.94721359f, -0.27639318f, -0.16245984f }, { +0.81827360f, -0.50572085f, -0.27326649f },
+	{ +1.00000000f, +0.00000000f, +0.00000000f }, { +0.81827360f, -0.50572085f, +0.27326649f },
+	{ +0.94721359f, -0.27639318f, +0.16245984f }, { +0.44721359f, -0.89442718f, +0.00000000f },
+	{ +0.67082047f, -0.72360682f, -0.16245985f }, { +0.67082047f, -0.72360682f, +0.16245985f }
+};
+
+/* Faces of each baked level, counter-clockwise seen from outside. */
+static const GLubyte bakedFaces0[20][3] =
+{
+	{   0,   3,   2 }, {   2,   3,   7 }, {   7,   3,   8 }, {   1,   7,   8 }, {   0,   4,   3 },
+	{   3,   4,   8 }, {   8,   4,   9 }, {   1,   8,   9 }, {   0,   5,   4 }, {   4,   5,   9 },
+	{   9,   5,  10 }, {   1,   9,  10 }, {   0,   6,   5 }, {   5,   6,  10 }, {  10,   6,  11 },
+	{   1,  10,  11 }, {   0,   2,   6 }, {   6,   2,  11 }, {  11,   2,   7 }, {   1,  11,   7 }
+};
+static const GLubyte bakedFaces1[80][3] =
+{
+	{   0,  12,  14 }, {   3,  13,  12 }, {   2,  14,  13 }, {  12,  13,  14 }, {   2,  13,  16 },
+	{   3,  15,  13 }, {   7,  16,  15 }, {  13,  15,  16 }, {   7,  15,  18 }, {   3,  17,  15 },
+	{   8,  18,  17 }, {  15,  17,  18 }, {   1,  19,  20 }, {   7,  18,  19 }, {   8,  20,  18 },
+	{  19,  18,  20 }, {   0,  21,  12 }, {   4,  22,  21 }, {   3,  12,  22 }, {  21,  22,  12 },
+	{   3,  22,  17 }, {   4,  23,  22 }, {   8,  17,  23 }, {  22,  23,  17 }, {   8,  23,  25 },
+	{   4,  24,  23 }, {   9,  25,  24 }, {  23,  24,  25 }, {   1,  20,  26 }, {   8,  25,  20 },
+	{   9,  26,  25 }, {  20,  25,  26 }, {   0,  27,  21 }, {   5,  28,  27 }, {   4,  21,  28 },
+	{  27,  28,  21 }, {   4,  28,  24 }, {   5,  29,  28 }, {   9,  24,  29 }, {  28,  29,  24 },
+	{   9,  29,  31 }, {   5,  30,  29 }, {  10,  31,  30 }, {  29,  30,  31 }, {   1,  26,  32 },
+	{   9,  31,  26 }, {  10,  32,  31 }, {  26,  31,  32 }, {   0,  33,  27 }, {   6,  34,  33 },
+	{   5,  27,  34 }, {  33,  34,  27 }, {   5,  34,  30 }, {   6,  35,  34 }, {  10,  30,  35 },
+	{  34,  35,  30 }, {  10,  35,  37 }, {   6,  36,  35 }, {  11,  37,  36 }, {  35,  36,  37 },
+	{   1,  32,  38 }, {  10,  37,  32 }, {  11,  38,  37 }, {  32,  37,  38 }, {   0,  14,  33 },
+	{   2,  39,  14 }, {   6,  33,  39 }, {  14,  39,  33 }, {   6,  39,  36 }, {   2,  40,  39 },
+	{  11,  36,  40 }, {  39,  40,  36 }, {  11,  40,  41 }, {   2,  16,  40 }, {   7,  41,  16 },
+	{  40,  16,  41 }, {   1,  38,  19 }, {  11,  41,  38 }, {   7,  19,  41 }, {  38,  41,  19 }
+};
+static const GLubyte bakedFaces2[320][3] =
+{
+	{   0,  42,  44 }, {  12,  43,  42 }, {  14,  44,  43 }, {  42,  43,  44 }, {   3,  45,  47 },
+	{  13,  46,  45 }, {  12,  47,  46 }, {  45,  46,  47 }, {   2,  48,  50 }, {  14,  49,  48 },
+	{  13,  50,  49 }, {  48,  49,  50 }, {  12,  46,  43 }, {  13,  49,  46 }, {  14,  43,  49 },
+	{  46,  49,  43 }, {   2,  50,  52 }, {  13,  51,  50 }, {  16,  52,  51 }, {  50,  51,  52 },
+	{   3,  53,  45 }, {  15,  54,  53 }, {  13,  45,  54 }, {  53,  54,  45 }, {   7,  55,  57 },
+	{  16,  56,  55 }, {  15,  57,  56 }, {  55,  56,  57 }, {  13,  54,  51 }, {  15,  56,  54 },
+	{  16,  51,  56 }, {  54,  56,  51 }, {   7,  57,  59 }, {  15,  58,  57 }, {  18,  59,  58 },
+	{  57,  58,  59 }, {   3,  60,  53 }, {  17,  61,  60 }, {  15,  53,  61 }, {  60,  61,  53 },
+	{   8,  62,  64 }, {  18,  63,  62 }, {  17,  64,  63 }, {  62,  63,  64 }, {  15,  61,  58 },
+	{  17,  63,  61 }, {  18,  58,  63 }, {  61,  63,  58 }, {   1,  65,  67 }, {  19,  66,  65 },
+	{  20,  67,  66 }, {  65,  66,  67 }, {   7,  59,  69 }, {  18,  68,  59 }, {  19,  69,  68 },
+	{  59,  68,  69 }, {   8,  70,  62 }, {  20,  71,  70 }, {  18,  62,  71 }, {  70,  71,  62 },
+	{  19,  68,  66 }, {  18,  71,  68 }, {  20,  66,  71 }, {  68,  71,  66 }, {   0,  72,  42 },
+	{  21,  73,  72 }, {  12,  42,  73 }, {  72,  73,  42 }, {   4,  74,  76 }, {  22,  75,  74 },
+	{  21,  76,  75 }, {  74,  75,  76 }, {   3,  47,  78 }, {  12,  77,  47 }, {  22,  78,  77 },
+	{  47,  77,  78 }, {  21,  75,  73 }, {  22,  77,  75 }, {  12,  73,  77 }, {  75,  77,  73 },
+	{   3,  78,  60 }, {  22,  79,  78 }, {  17,  60,  79 }, {  78,  79,  60 }, {   4,  80,  74 },
+	{  23,  81,  80 }, {  22,  74,  81 }, {  80,  81,  74 }, {   8,  64,  83 }, {  17,  82,  64 },
+	{  23,  83,  82 }, {  64,  82,  83 }, {  22,  81,  79 }, {  23,  82,  81 }, {  17,  79,  82 },
+	{  81,  82,  79 }, {   8,  83,  85 }, {  23,  84,  83 }, {  25,  85,  84 }, {  83,  84,  85 },
+	{   4,  86,  80 }, {  24,  87,  86 }, {  23,  80,  87 }, {  86,  87,  80 }, {   9,  88,  90 },
+	{  25,  89,  88 }, {  24,  90,  89 }, {  88,  89,  90 }, {  23,  87,  84 }, {  24,  89,  87 },
+	{  25,  84,  89 }, {  87,  89,  84 }, {   1,  67,  92 }, {  20,  91,  67 }, {  26,  92,  91 },
+	{  67,  91,  92 }, {   8,  85,  70 }, {  25,  93,  85 }, {  20,  70,  93 }, {  85,  93,  70 },
+	{   9,  94,  88 }, {  26,  95,  94 }, {  25,  88,  95 }, {  94,  95,  88 }, {  20,  93,  91 },
+	{  25,  95,  93 }, {  26,  91,  95 }, {  93,  95,  91 }, {   0,  96,  72 }, {  27,  97,  96 },
+	{  21,  72,  97 }, {  96,  97,  72 }, {   5,  98, 100 }, {  28,  99,  98 }, {  27, 100,  99 },
+	{  98,  99, 100 }, {   4,  76, 102 }, {  21, 101,  76 }, {  28, 102, 101 }, {  76, 101, 102 },
+	{  27,  99,  97 }, {  28, 101,  99 }, {  21,  97, 101 }, {  99, 101,  97 }, {   4, 102,  86 },
+	{  28, 103, 102 }, {  24,  86, 103 }, { 102, 103,  86 }, {   5, 104,  98 }, {  29, 105, 104 },
+	{  28,  98, 105 }, { 104, 105,  98 }, {   9,  90, 107 }, {  24, 106,  90 }, {  29, 107, 106 },
+	{  90, 106, 107 }, {  28, 105, 103 }, {  29, 106, 105 }, {  24, 103, 106 }, { 105, 106, 103 },
+	{   9, 107, 109 }, {  29, 108, 107 }, {  31, 109, 108 }, { 107, 108, 109 }, {   5, 110, 104 },
+	{  30, 111, 110 }, {  29, 104, 111 }, { 110, 111, 104 }, {  10, 112, 114 }, {  31, 113, 112 },
+	{  30, 114, 113 }, { 112, 113, 114 }, {  29, 111, 108 }, {  30, 113, 111 }, {  31, 108, 113 },
+	{ 111, 113, 108 }, {   1,  92, 116 }, {  26, 115,  92 }, {  32, 116, 115 }, {  92, 115, 116 },
+	{   9, 109,  94 }, {  31, 117, 109 }, {  26,  94, 117 }, { 109, 117,  94 }, {  10, 118, 112 },
+	{  32, 119, 118 }, {  31, 112, 119 }, { 118, 119, 112 }, {  26, 117, 115 }, {  31, 119, 117 },
+	{  32, 115, 119 }, { 117, 119, 115 }, {   0, 120,  96 }, {  33, 121, 120 }, {  27,  96, 121 },
+	{ 120, 121,  96 }, {   6, 122, 124 }, {  34, 123, 122 }, {  33, 124, 123 }, { 122, 123, 124 },
+	{   5, 100, 126 }, {  27, 125, 100 }, {  34, 126, 125 }, { 100, 125, 126 }, {  33, 123, 121 },
+	{  34, 125, 123 }, {  27, 121, 125 }, { 123, 125, 121 }, {   5, 126, 110 }, {  34, 127, 126 },
+	{  30, 110, 127 }, { 126, 127, 110 }, {   6, 128, 122 }, {  35, 129, 128 }, {  34, 122, 129 },
+	{ 128, 129, 122 }, {  10, 114, 131 }, {  30, 130, 114 }, {  35, 131, 130 }, { 114, 130, 131 },
+	{  34, 129, 127 }, {  35, 130, 129 }, {  30, 127, 130 }, { 129, 130, 127 }, {  10, 131, 133 },
+	{  35, 132, 131 }, {  37, 133, 132 }, { 131, 132, 133 }, {   6, 134, 128 }, {  36, 135, 134 },
+	{  35, 128, 135 }, { 134, 135, 128 }, {  11, 136, 138 }, {  37, 137, 136 }, {  36, 138, 137 },
+	{ 136, 137, 138 }, {  35, 135, 132 }, {  36, 137, 135 }, {  37, 132, 137 }, { 135, 137, 132 },
+	{   1, 116, 140 }, {  32, 139, 116 }, {  38, 140, 139 }, { 116, 139, 140 }, {  10, 133, 118 },
+	{  37, 141, 133 }, {  32, 118, 141 }, { 133, 141, 118 }, {  11, 142, 136 }, {  38, 143, 142 },
+	{  37, 136, 143 }, { 142, 143, 136 }, {  32, 141, 139 }, {  37, 143, 141 }, {  38, 139, 143 },
+	{ 141, 143, 139 }, {   0,  44, 120 }, {  14, 144,  44 }, {  33, 120, 144 }, {  44, 144, 120 },
+	{   2, 145,  48 }, {  39, 146, 145 }, {  14,  48, 146 }, { 145, 146,  48 }, {   6, 124, 148 },
+	{  33, 147, 124 }, {  39, 148, 147 }, { 124, 147, 148 }, {  14, 146, 144 }, {  39, 147, 146 },
+	{  33, 144, 147 }, { 146, 147, 144 }, {   6, 148, 134 }, {  39, 149, 148 }, {  36, 134, 149 },
+	{ 148, 149, 134 }, {   2, 150, 145 }, {  40, 151, 150 }, {  39, 145, 151 }, { 150, 151, 145 },
+	{  11, 138, 153 }, {  36, 152, 138 }, {  40, 153, 152 }, { 138, 152, 153 }, {  39, 151, 149 },
+	{  40, 152, 151 }, {  36, 149, 152 }, { 151, 152, 149 }, {  11, 153, 155 }, {  40, 154, 153 },
+	{  41, 155, 154 }, { 153, 154, 155 }, {   2,  52, 150 }, {  16, 156,  52 }, {  40, 150, 156 },
+	{  52, 156, 150 }, {   7, 157,  55 }, {  41, 158, 157 }, {  16,  55, 158 }, { 157, 158,  55 },
+	{  40, 156, 154 }, {  16, 158, 156 }, {  41, 154, 158 }, { 156, 158, 154 }, {   1, 140,  65 },
+	{  38, 159, 140 }, {  19,  65, 159 }, { 140, 159,  65 }, {  11, 155, 142 }, {  41, 160, 155 },
+	{  38, 142, 160 }, { 155, 160, 142 }, {   7,  69, 157 }, {  19, 161,  69 }, {  41, 157, 161 },
+	{  69, 161, 157 }, {  38, 160, 159 }, {  41, 161, 160 }, {  19, 159, 161 }, { 160, 161, 159 }
+};
+static const GLubyte* const bakedFaces[ICOSPHERE_BAKED_SUBDIVISIONS + 1] =
+{
+	bakedFaces0[0], bakedFaces1[0], bakedFaces2[0]
+};
+
+/* Triangles of a level. */
+static GLuint numFaces(GLuint level)
+{
+	return 20u << (2 * level);
+}
+
+/* Vertex halfway along an edge, pushed out onto the sphere (added once). */
+static GLuint midpoint(std::vector<glm::vec3>* positions,
+                       std::unordered_map<GLuint64, GLuint>* midpoints,
+                       GLuint a, GLuint b)
+{
+	GLuint64 key = a < b ? (GLuint64) a << 32 | b : (GLuint64) b << 32 | a;
+	std::pair<std::unordered_map<GLuint64, GLuint>::iterator, bool> added =
+		midpoints->insert(std::make_pair(key, (GLuint) positions->size()));
+	if(added.second)
+		positions->push_back(glm::normalize(((*positions)[a] + (*positions)[b]) * 0.5f));
+	return added.first->second;
+}
+
+/* Split every face of a level into four, keeping their winding. */
+static void subdivide(std::vector<glm::vec3>* positions,
+                      const std::vector<GLuint>& faces, std::vector<GLuint>* finer)
+{
+	std::unordered_map<GLuint64, GLuint> midpoints;
+	midpoints.reserve(faces.size());
+	finer->reserve(4 * faces.size());
+	for(GLuint i = 0; i < faces.size(); i += 3)
+	{
+		GLuint a  = faces[i], b = faces[i + 1], c = faces[i + 2];
+		GLuint ab = midpoint(positions, &midpoints, a, b);
+		GLuint bc = midpoint(positions, &midpoints, b, c);
+		GLuint ca = midpoint(positions, &midpoints, c, a);
+		GLuint split[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+		finer->insert(finer->end(), split, split + 12);
+	}
+}
+
+/* Longitude and colatitude of a point of the sphere, each from 0 to 1. */
+static glm::vec2 sphereCoordinate(const glm::vec3& p)
+{
+	GLfloat u = (GLfloat) (atan2(p.z, p.x) / (2.0 * M_PI));
+	if(u < 0.0f)
+		u += 1.0f;
+	return glm::vec2(u, (GLfloat) (acos(glm::clamp(p.y, -1.0f, 1.0f)) / M_PI));
+}
+
+/* Append the faces of a level, giving faces across the seam or at a pole   *
+ * their own copies of those vertices. Returns how far the faces sink below  *
+ * the sphere.                                                               */
+static GLfloat addLevel(const std::vector<GLuint>& faces,
+                        std::vector<Vertex>* vertices, std::vector<GLuint>* indices,
+                        std::vector<GLuint>* seamCopies)
+{
+	GLfloat error = 0.0f;
+	for(GLuint i = 0; i < faces.size(); i += 3)
+	{
+		/* The poles are vertices 0 and 1, and have no longitude. */
+		GLuint  corners[3] = { faces[i], faces[i + 1], faces[i + 2] };
+		GLfloat lowest = 1.0f, highest = 0.0f;
+		for(GLuint c = 0; c < 3; c++)
+			if(corners[c] > 1)
+			{
+				lowest  = std::min(lowest,  (*vertices)[corners[c]].textureCoordinate.x);
+				highest = std::max(highest, (*vertices)[corners[c]].textureCoordinate.x);
+			}
+
+		/* A face across the seam takes copies of its corners at u < 0.5 with *
+		 * u + 1 (a pole is never copied, so 0 marks no copy yet).            */
+		if(highest - lowest > 0.5f)
+			for(GLuint c = 0; c < 3; c++)
+			{
+				if(corners[c] <= 1 || (*vertices)[corners[c]].textureCoordinate.x >= 0.5f)
+					continue;
+				GLuint& copy = (*seamCopies)[corners[c]];
+				if(copy == 0)
+				{
+					copy = vertices->size();
+					Vertex vertex = (*vertices)[corners[c]];
+					vertex.textureCoordinate.x += 1.0f;
+					vertices->push_back(vertex);
+				}
+				corners[c] = copy;
+			}
+
+		/* A pole takes the longitude of the middle of the face. */
+		for(GLuint c = 0; c < 3; c++)
+			if(corners[c] <= 1)
+			{
+				Vertex vertex = (*vertices)[corners[c]];
+				vertex.textureCoordinate.x = 0.5f *
+					((*vertices)[corners[(c + 1) % 3]].textureCoordinate.x +
+					 (*vertices)[corners[(c + 2) % 3]].textureCoordinate.x);
+				corners[c] = vertices->size();
+				vertices->push_back(vertex);
+			}
+
+		indices->insert(indices->end(), corners, corners + 3);
+		glm::vec3 middle = ((*vertices)[corners[0]].position + (*vertices)[corners[1]].position +
+		                    (*vertices)[corners[2]].position) / 3.0f;
+		error = std::max(error, 1.0f - glm::length(middle));
+	}
+	return error;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              Icosphere::parseName                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param name                                                                *
+*           Mesh name, as given for a body in place of an OBJ file.           *
+*  @param subdivisions (optional)                                             *
+*           Set to the subdivisions it asks for, at most                      *
+*           ICOSPHERE_MAX_SUBDIVISIONS.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the name is ICOSPHERE_PREFIX followed by a number.                 *
+*                                                                             *
+*******************************************************************************/
+bool Icosphere::parseName(const char* name, GLuint* subdivisions)
+{
+	const size_t prefix = strlen(ICOSPHERE_PREFIX);
+	if(strncmp(name, ICOSPHERE_PREFIX, prefix) != 0 || !isdigit((unsigned char) name[prefix]))
+		return false;
+	char* end;
+	unsigned long count = strtoul(name + prefix, &end, 10);
+	if(*end != '\0')
+		return false;
+	if(subdivisions != NULL)
+		*subdivisions = (GLuint) std::min(count, (unsigned long) ICOSPHERE_MAX_SUBDIVISIONS);
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              Icosphere::generate                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param subdivisions                                                        *
+*           Times the icosahedron is subdivided (at most                      *
+*           ICOSPHERE_MAX_SUBDIVISIONS).                                      *
+*  @param vertices / indices                                                  *
+*           Filled with the sphere, as ObjFile::parse() fills them.           *
+*  @param levels (optional)                                                   *
+*           If given, the coarser spheres are appended to indices as its      *
+*           levels of detail, down to LOD_MIN_TRIANGLES, and their ranges put *
+*           here.                                                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void Icosphere::generate(GLuint subdivisions, std::vector<Vertex>* vertices,
+                         std::vector<GLuint>* indices,
+                         std::vector<MeshLevel>* levels)
+{
+	subdivisions = std::min(subdivisions, (GLuint) ICOSPHERE_MAX_SUBDIVISIONS);
+
+	/* Faces of every level up to the one asked for, from the tables as far  *
+	 * as they go.                                                          */
+	const GLuint baked    = std::min(subdivisions, (GLuint) ICOSPHERE_BAKED_SUBDIVISIONS);
+	const GLuint numBaked = 10 * (1 << (2 * baked)) + 2;
+	std::vector<glm::vec3>            positions;
+	std::vector<std::vector<GLuint> > faces(subdivisions + 1);
+	positions.reserve(10 * (1 << (2 * subdivisions)) + 2);
+	for(GLuint v = 0; v < numBaked; v++)
+		positions.push_back(glm::vec3(bakedPositions[v][0], bakedPositions[v][1],
+		                              bakedPositions[v][2]));
+	for(GLuint level = 0; level <= baked; level++)
+		faces[level].assign(bakedFaces[level], bakedFaces[level] + 3 * numFaces(level));
+	for(GLuint level = baked + 1; level <= subdivisions; level++)
+		subdivide(&positions, faces[level - 1], &faces[level]);
+
+	/* Normals are the positions of a unit sphere. */
+	vertices->clear();
+	indices->clear();
+	vertices->reserve(positions.size() + positions.size() / 8);
+	for(GLuint v = 0; v < positions.size(); v++)
+	{
+		Vertex vertex = { positions[v], DEFAULT_VERTEX_COLOR, positions[v],
+		                  sphereCoordinate(positions[v]) };
+		vertices->push_back(vertex);
+	}
+	std::vector<GLuint> seamCopies(positions.size(), 0);
+	addLevel(faces[subdivisions], vertices, indices, &seamCopies);
+	if(levels == NULL)
+		return;
+
+	/* The coarser spheres use the same vertices, so they cost only indices. */
+	MeshLevel full = { 0, (GLuint) indices->size(), 0.0f };
+	levels->assign(1, full);
+	for(GLuint level = subdivisions; level > 0 && levels->size() < LOD_MAX_LEVELS; level--)
+	{
+		if(numFaces(level - 1) < LOD_MIN_TRIANGLES)
+			break;
+		GLuint    first = indices->size();
+		GLfloat   error = addLevel(faces[level - 1], vertices, indices, &seamCopies);
+		MeshLevel coarse = { first, (GLuint) indices->size() - first, error };
+		levels->push_back(coarse);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <vector>
+#include "Geometry.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Mesh name of a procedural sphere, followed by its subdivisions. */
+#define  ICOSPHERE_PREFIX                                            "sphere:"
+/* Subdivisions whose vertices and faces are baked into Icosphere.cpp. */
+#define  ICOSPHERE_BAKED_SUBDIVISIONS                                       2
+#define  ICOSPHERE_BAKED_VERTICES                                         162
+/* Most subdivisions a sphere gets (20 x 4^7 triangles). */
+#define  ICOSPHERE_MAX_SUBDIVISIONS                                         7
+
+/******************************************************************************
+*                                                                             *
+*                              Icosphere   (class)                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Unit spheres made by subdividing an icosahedron, named "sphere:N" where N  *
+*  is the number of subdivisions, so a body can use one in place of an OBJ    *
+*  file and skip reading and parsing it. Every subdivision splits each        *
+*  triangle into four and pushes the new vertices out onto the sphere, so     *
+*  the triangles stay close to the same size everywhere, unlike the rings of  *
+*  a UV sphere which crowd together at the poles.                             *
+*                                                                             *
+*  The icosahedron has a vertex at each pole. The vertices and faces of the   *
+*  first ICOSPHERE_BAKED_SUBDIVISIONS levels are tables in the source, and    *
+*  finer levels are subdivided from the last of them when asked for. Each     *
+*  level keeps the vertices of the one before as its first ones, so coarser  *
+*  levels are also the mesh's levels of detail (see MeshLod.h), drawn from    *
+*  the same vertices.                                                         *
+*                                                                             *
+*  Normals are the positions. Texture coordinates are the longitude and       *
+*  colatitude, as on the OBJ spheres: vertices on the seam are copied for     *
+*  the faces across it, which run past u = 1, and each face at a pole gets    *
+*  its own pole vertex at the longitude of the face.                          *
+*                                                                             *
+*******************************************************************************/
+class Icosphere
+{
+public:
+	/* Subdivisions of a procedural sphere name (false if it is not one). */
+	static bool    parseName(const char* name, GLuint* subdivisions);
+	/* Build a sphere, and its coarser levels if levels is given. */
+	static void    generate(GLuint subdivisions,
+	                        std::vector<Vertex>* vertices,
+	                        std::vector<GLuint>* indices,
+	                        std::vector<MeshLevel>* levels = NULL);
+};
@@ -13,12 +13,23 @@
 #include <ctime>
 #include "Display.h"
 #include "Shader.h"
+#include "AssetCache.h"
+#include "AssetLoader.h"
+#include "AssetPack.h"
 #include "Geometry.h"
 #include "Camera.h"
 #include "EventManager.h"
 #include "OrbitalBody.h"
 #include "OrbitalSystem.h"
 #include "Planet.h"
+#include "Trajectory.h"
+#include "Checkpoint.h"
+#include "SystemFile.h"
+#include "SceneFile.h"
+#include "ObjFile.h"
+#include "TextureArray.h"
+#include "TextureResidency.h"
+#include "TextureStream.h"
 
 /*******************************************************************************
  *                                                                             *
@@ -34,6 +45,9 @@
 #define  SHADERS_PATH         "res/shaders/";
 #define  FRAMES_PER_SECOND    100
 #define  PROJECT_TITLE        "GravitySimulator3D"
+#define  DEFAULT_SYSTEM_FILE  "res/data/system.xml"
+/* Systems with more bodies than this are drawn as particles. */
+#define  PARTICLE_BODIES      20000
 #define  PRINT(a)             std::cout << a << std::endl;
 
 /*******************************************************************************
@@ -52,6 +66,27 @@ glm::vec3  bases[] =
         {+0.0f, +0.0f, +1.0f}
     };
 
+/*******************************************************************************
+ *                                                                             *
+ *                              showLoadingProgress                            *
+ *                                                                             *
+ *******************************************************************************
+ * PARAMETERS                                                                  *
+ *  context                                                                    *
+ *        The Display the loading screen is drawn on.                          *
+ *  loaded / total                                                             *
+ *        Number of assets resident so far, out of all of them.                *
+ *                                                                             *
+ *******************************************************************************
+ * RETURNS                                                                     *
+ *  void                                                                       *
+ *                                                                             *
+ *******************************************************************************/
+static void showLoadingProgress(void* context, GLuint loaded, GLuint total)
+{
+	((Display*) context)->repaintLoading(total > 0 ? (GLfloat) loaded / total : 1.0f);
+}
+
 /*******************************************************************************
  *                                                                             *
  *                                     main                                    *
@@ -61,7 +96,42 @@ glm::vec3  bases[] =
  *  argc                                                                       *
  *        The number of command line strings.                                  *
  *  argv                                                                       *
- *        The array of command line stirngs.                                   *
+ *        The array of command line stirngs. Recognized options:               *
+ *          --system FILE     System file or scene to load (default            *
+ *                            res/data/system.xml).                            *
+ *          --convert IN OUT  Convert a system file, or a CSV catalogue using  *
+ *                            the parameters of --system, to a scene (see      *
+ *                            SceneFile.h), then exit.                         *
+ *          --pack FILE       Pack the assets of --system and the program's    *
+ *                            shaders into FILE (see AssetPack.h), then exit.  *
+ *          --bc1             Compress the textures of --pack to BC1.          *
+ *          --assets FILE     Asset pack to load from (default                 *
+ *                            res/assets.pack, if it exists).                  *
+ *          --bench-load N    Time loading a generated N-body system file and  *
+ *                            scene, then exit.                                *
+ *          --bench-obj N     Time parsing a generated N-ring sphere OBJ with  *
+ *                            tiny_obj_loader and ObjFile, then exit.          *
+ *          --load-threads N  Number of threads decoding assets at startup.    *
+ *          --deterministic   Bit-reproducible force pass for any --workers.   *
+ *          --workers N       Number of threads used by the force pass.        *
+ *          --record FILE     Stream the state of every body to a trajectory   *
+ *                            file (see Trajectory.h).                         *
+ *          --record-every K  Record every Kth step only (default 1).          *
+ *          --compress        Compress the trajectory (builds with zlib).      *
+ *          --restore FILE    Continue from a checkpoint instead of the        *
+ *                            system file.                                     *
+ *          --checkpoint FILE Snapshot the system to FILE on exit (see         *
+ *                            Checkpoint.h).                                   *
+ *          --checkpoint-every S                                               *
+ *                            Also snapshot it every S seconds.                *
+ *          --particles       Draw the bodies as particles (the default above  *
+ *                            PARTICLE_BODIES bodies).                         *
+ *          --meshes          Draw every body as a mesh.                       *
+ *          --trails N        Number of bodies drawn with an orbit trail       *
+ *                            (default MAX_TRAILS, 0 for none).                *
+ *          --texture-budget MB                                                *
+ *                            Graphics memory the body textures may keep       *
+ *                            resident (see TextureResidency).                 *
  *                                                                             *
  *******************************************************************************
  * RETURNS                                                                     *
@@ -74,32 +144,145 @@ glm::vec3  bases[] =
  *******************************************************************************/
 int main(int argc, char* argv[])
 {
+	/* Time to the first interactive frame is measured from here. */
+	GLuint64 launchCounter = SDL_GetPerformanceCounter();
+
+	/* Find the system to load, and the tools run without a window. */
+	const char* restoreFile = nullptr;
+	const char* systemFile  = DEFAULT_SYSTEM_FILE;
+	const char* packFile    = nullptr;
+	bool        compress    = false;
+	GLuint      loadThreads = DEFAULT_LOADER_THREADS;
+	for(int i = 1; i + 1 < argc; i++)
+	{
+		std::string arg(argv[i]);
+		if(arg == "--restore")
+			restoreFile = argv[i + 1];
+		else if(arg == "--system")
+			systemFile  = argv[i + 1];
+		else if(arg == "--load-threads")
+			loadThreads = (GLuint) atoi(argv[i + 1]);
+		else if(arg == "--assets")
+			packFile    = argv[i + 1];
+	}
+	for(int i = 1; i < argc; i++)
+		if(std::string(argv[i]) == "--bc1")
+			compress = true;
+	for(int i = 1; i + 1 < argc; i++)
+	{
+		std::string arg(argv[i]);
+		if(arg == "--bench-load")
+		{
+			SystemFile::benchmark((GLuint) atoi(argv[i + 1]));
+			return 0;
+		}
+		if(arg == "--bench-obj")
+		{
+			ObjFile::benchmark((GLuint) atoi(argv[i + 1]));
+			return 0;
+		}
+		if(arg == "--pack")
+			return AssetPack::build(argv[i + 1], systemFile, compress) ? 0 : 1;
+		if(arg == "--convert" && i + 2 < argc)
+			return SceneFile::convert(argv[i + 1], argv[i + 2], systemFile) ? 0 : 1;
+	}
+
 	/* Initialize SDL with all subsystems. */
 	SDL_Init(SDL_INIT_EVERYTHING);
 
 	/* Create the display, shader, camera, and event manager. */
 	Display      display(PROJECT_TITLE, DEFAULT_WIDTH, DEFAULT_HEIGHT);
-	Shader       shader(DEFAULT_VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER);
+	AssetPack::open(packFile != nullptr ? packFile : DEFAULT_ASSET_PACK,
+	                packFile != nullptr);
+	Shader&      shader = *AssetCache::acquireShader(DEFAULT_VERTEX_SHADER,
+	                                                 DEFAULT_FRAGMENT_SHADER);
+	Shader&      trailShader = *AssetCache::acquireShader(TRAIL_VERTEX_SHADER,
+	                                                      TRAIL_FRAGMENT_SHADER);
+	Shader&      particleShader = *AssetCache::acquireShader(PARTICLE_VERTEX_SHADER,
+	                                                         PARTICLE_FRAGMENT_SHADER);
 	Camera*      camera = display.getCamera();
 	EventManager eventManager(camera, &speed);
 
 	/* Apply the shaders and maximize the display. */
 	Geometry::shader = &shader;
 	display.setShader(shader);
+	display.setTrailShader(trailShader);
+	display.setParticleShader(particleShader);
 	display.maximize();
 
-	/* Create the orbital system. */
-	OrbitalSystem system = OrbitalSystem::loadFile("res/data/system.xml");
+	/* Show the loading screen while the assets load in the background. */
+	GLuint       loadingImage  = AssetCache::acquireTexture(LOADING_SCREEN_IMAGE);
+	Shader*      loadingShader = AssetCache::acquireShader(LOADING_VERTEX_SHADER,
+	                                                       LOADING_FRAGMENT_SHADER);
+	display.setLoadingScreen(*loadingShader, loadingImage);
+	display.repaintLoading(0.0f);
+	AssetLoader  loader(showLoadingProgress, &display, loadThreads);
+
+	/* Create the orbital system, or restore it from a checkpoint. */
+	OrbitalSystem system = restoreFile != nullptr ?
+		OrbitalSystem::loadCheckpoint(restoreFile, &loader) :
+		OrbitalSystem::loadFile(systemFile, &loader);
 
-	/* Instantiate the event reference. */
+	/* The loading screen is not shown again. */
+	display.clearLoadingScreen();
+	AssetCache::releaseTexture(loadingImage);
+	AssetCache::releaseShader(loadingShader);
+
+	/* Apply the command line options to the force pass, the recorder, and *
+	 * the checkpoints.                                                    */
+	TrajectoryRecorder recorder;
+	const char*        recordFile      = nullptr;
+	GLuint             recordEvery     = 1;
+	GLuint             recordFlags     = TRAJECTORY_DELTA;
+	CheckpointWriter   checkpoints;
+	const char*        checkpointFile  = nullptr;
+	GLuint             checkpointEvery = 0;
+	bool               particles       = system.getNumBodies() > PARTICLE_BODIES;
+	for(int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		if(arg == "--deterministic")
+			system.setReductionMode(ReductionMode::DETERMINISTIC);
+		else if(arg == "--workers" && i + 1 < argc)
+			system.setNumWorkers((GLuint) atoi(argv[++i]));
+		else if(arg == "--record" && i + 1 < argc)
+			recordFile = argv[++i];
+		else if(arg == "--record-every" && i + 1 < argc)
+			recordEvery = (GLuint) atoi(argv[++i]);
+		else if(arg == "--compress")
+			recordFlags |= TRAJECTORY_ZLIB;
+		else if((arg == "--restore" || arg == "--system" ||
+			arg == "--load-threads" || arg == "--assets") && i + 1 < argc)
+			i++;
+		else if(arg == "--checkpoint" && i + 1 < argc)
+			checkpointFile = argv[++i];
+		else if(arg == "--checkpoint-every" && i + 1 < argc)
+			checkpointEvery = (GLuint) atoi(argv[++i]) * MILLIS_PER_SECOND;
+		else if(arg == "--particles")
+			particles = true;
+		else if(arg == "--meshes")
+			particles = false;
+		else if(arg == "--trails" && i + 1 < argc)
+			system.setMaxTrails((GLuint) atoi(argv[++i]));
+		else if(arg == "--texture-budget" && i + 1 < argc)
+			TextureResidency::setBudget((GLuint64) (atof(argv[++i]) * 1024 * 1024));
+	}
+	if(recordFile != nullptr && recorder.open(recordFile, recordFlags))
+		system.setRecorder(&recorder, recordEvery);
+
+	/* Instantiate the event reference, and take the window's size once     *
+	 * more, since a resize while loading is not checked for here.          */
 	SDL_Event event;
 	SDL_PollEvent(&event);	
+	display.updateViewport();
 
 	/* Begin the milliseconds counter. */
 	GLuint startMillis = 0, tempMillis = 0, currentMillis = 0, millisPerFrame = 0;
 	startMillis = tempMillis = currentMillis = SDL_GetTicks();	
 	millisPerFrame = (GLuint) ((1.0 / FRAMES_PER_SECOND) * MILLIS_PER_SECOND);
 	PRINT(millisPerFrame)
+	GLuint checkpointMillis = currentMillis;
+	bool   firstFrame       = true;
 
 	/* Main loop. */
 	while (event.type != SDL_QUIT)
@@ -119,18 +302,60 @@ int main(int argc, char* argv[])
 		if ((currentMillis - startMillis) >= millisPerFrame)
 		{
 			startMillis = currentMillis;
-			display.repaint(system.getMeshes(), system.getTransforms());
+			system.snapshotTransforms(particles);
+			TextureResidency::update();
+			TextureStream::update();
+			display.repaint(system.getRenderList(particles));
+			if (firstFrame)
+			{
+				firstFrame = false;
+				fprintf(stdout, "First interactive frame after %.2f ms "
+					"(%.2f ms of it loading assets)\n",
+					1000.0 * (SDL_GetPerformanceCounter() - launchCounter) /
+					SDL_GetPerformanceFrequency(), 1000.0 * loader.getSeconds());
+			}
+		}
+
+		/* Snapshot the system if one is due (written in the background). */
+		if (checkpointFile != nullptr && checkpointEvery > 0 &&
+			(currentMillis - checkpointMillis) >= checkpointEvery)
+		{
+			checkpointMillis = currentMillis;
+			system.saveCheckpoint(&checkpoints, checkpointFile);
 		}
 
 		/* Update the temporary millisecond counter. */
 		tempMillis = currentMillis;
 		
-		/* Get the next event. */
-		SDL_PollEvent(&event);
+		/* Get the next event (the last one stays if there is none), and      *
+		 * follow the window's size, which is all the projection depends on. */
+		if (SDL_PollEvent(&event) && event.type == SDL_WINDOWEVENT &&
+			event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+			display.updateViewport();
+	}
+
+	/* Take the final snapshot and finish the trajectory, then report how *
+	 * long the force passes took.                                         */
+	if (checkpointFile != nullptr)
+	{
+		checkpoints.wait();
+		system.saveCheckpoint(&checkpoints, checkpointFile);
+		checkpoints.wait();
 	}
+	recorder.close();
+	system.printStats();
+	AssetCache::printStats();
+	display.printStats();
 
-	/* Free the shapes. */
+	/* Free the shapes and the shaders. */
 	system.cleanUp();
+	AssetCache::releaseShader(&particleShader);
+	AssetCache::releaseShader(&trailShader);
+	AssetCache::releaseShader(&shader);
+	TextureStream::cleanUp();
+	TextureResidency::cleanUp();
+	TextureArray::cleanUp();
+	AssetPack::close();
 
 	/* Quit using SDL. */
 	SDL_Quit();
@@ -0,0 +1,144 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "MappedFile.h"
+#ifdef _WIN32
+#define  WIN32_LEAN_AND_MEAN
+#define  NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+*                                                                             *
+*                        MappedFile::MappedFile (Constructor)                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+MappedFile::MappedFile() :
+	data(nullptr), size(0), file(nullptr), mapping(nullptr)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                               MappedFile::open                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           File to be mapped.                                                *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the whole file is now mapped.                                      *
+*                                                                             *
+*******************************************************************************/
+bool MappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(f == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER length;
+	if(!GetFileSizeEx(f, &length) || length.QuadPart == 0)
+	{
+		CloseHandle(f);
+		return false;
+	}
+
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(m == NULL)
+	{
+		CloseHandle(f);
+		return false;
+	}
+
+	void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	if(view == NULL)
+	{
+		CloseHandle(m);
+		CloseHandle(f);
+		return false;
+	}
+
+	file    = f;
+	mapping = m;
+	size    = (GLuint64) length.QuadPart;
+	data    = (const unsigned char*) view;
+#else
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(view == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	file = (void*) (size_t) fd;
+	size = (GLuint64) info.st_size;
+	data = (const unsigned char*) view;
+#endif
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              MappedFile::close                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void MappedFile::close()
+{
+	if(data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE) mapping);
+	CloseHandle((HANDLE) file);
+#else
+	munmap((void*) data, size);
+	::close((int) (size_t) file);
+#endif
+
+	data    = nullptr;
+	size    = 0;
+	file    = nullptr;
+	mapping = nullptr;
+}
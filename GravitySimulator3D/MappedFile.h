@@ -0,0 +1,57 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+
+/******************************************************************************
+*                                                                             *
+*                              MappedFile   (class)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  data / size                                                                *
+*          Read-only view of the whole file and its length in bytes.          *
+*  file / mapping                                                             *
+*          Operating system handles kept open while the view exists (file    *
+*          and mapping handles on Windows, a descriptor elsewhere).          *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Maps a file into memory for reading, with MapViewOfFile on Windows and     *
+*  mmap elsewhere. Pages are only read from disk when first touched, so       *
+*  opening even a very large file is immediate.                               *
+*                                                                             *
+*******************************************************************************/
+class MappedFile
+{
+public:
+	/* Constructor. */
+	               MappedFile();
+
+	/* Map a file (false if it cannot be opened or is empty). */
+	bool           open(const char* path);
+	/* Unmap the file. */
+	void           close();
+
+	/* Getters. */
+	const unsigned char* getData()       const   {  return data;           }
+	GLuint64       getSize()             const   {  return size;           }
+	bool           isOpen()              const   {  return data != nullptr; }
+
+	/* Destructor. */
+	              ~MappedFile()                  {  close();               }
+
+private:
+	/* Not copyable (owns the mapping). */
+	               MappedFile(const MappedFile& rhs);
+	MappedFile&    operator=(const MappedFile& rhs);
+
+	const unsigned char*     data;
+	GLuint64                 size;
+	void*                    file;
+	void*                    mapping;
+};
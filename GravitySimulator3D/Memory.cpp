@@ -0,0 +1,497 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Memory.h"
+#include <cstdlib>
+#include <new>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Storage class of a per-thread variable (VS2013 has no thread_local). */
+#ifdef _MSC_VER
+#define  THREAD_LOCAL                                      __declspec(thread)
+#else
+#define  THREAD_LOCAL                                                __thread
+#endif
+
+/******************************************************************************
+*                                                                             *
+*                                Global Variables                             *
+*                                                                             *
+******************************************************************************/
+/* Calls to the global operator new made by this thread (see the            *
+ * replacements at the bottom).                                             */
+static THREAD_LOCAL GLuint64 heapAllocations = 0;
+
+BlockPool     Memory::bodyRecords(BODY_RECORD_SIZE, BODY_RECORDS_PER_CHUNK);
+SizeClassPool Memory::meshData(MESH_MIN_SHIFT, MESH_MAX_SHIFT, MESH_CHUNK_SIZE);
+
+/******************************************************************************
+*                                                                             *
+*                            Arena::Arena (Constructor)                       *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param chunkSize                                                           *
+*           Smallest number of bytes requested from the heap at once.         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Creates an empty arena. No memory is taken until the first allocation.     *
+*                                                                             *
+*******************************************************************************/
+Arena::Arena(size_t chunkSize) :
+	chunkSize(chunkSize)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                               Arena::allocate                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param bytes                                                               *
+*           Number of bytes wanted.                                           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Pointer to the bytes, aligned to ARENA_ALIGNMENT.                          *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Carves the bytes out of the last chunk, starting a new chunk (at least as  *
+*  big as the request) when the last one is full.                             *
+*                                                                             *
+*******************************************************************************/
+void* Arena::allocate(size_t bytes)
+{
+	bytes = (bytes + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+	/* Start a new chunk if the request does not fit in the last one. */
+	if(chunks.empty() || chunks.back().used + bytes > chunks.back().size)
+	{
+		Chunk c;
+		c.size = bytes > chunkSize ? bytes : chunkSize;
+		c.data = (char*) ::operator new(c.size + ARENA_ALIGNMENT);
+		c.used = 0;
+		chunks.push_back(c);
+	}
+
+	/* Align the start of the chunk's data. */
+	Chunk& c    = chunks.back();
+	char*  base = (char*) (((size_t) c.data + ARENA_ALIGNMENT - 1) &
+	                       ~((size_t) ARENA_ALIGNMENT - 1));
+	void*  p    = base + c.used;
+	c.used     += bytes;
+	return p;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 Arena::reset                                *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Rewinds the arena. If more than one chunk was needed since the last reset, *
+*  they are merged into one chunk holding their combined size, so the next   *
+*  round of the same size fits without going back to the heap.               *
+*                                                                             *
+*******************************************************************************/
+void Arena::reset()
+{
+	if(chunks.size() > 1)
+	{
+		size_t total = 0;
+		for(Chunk& c : chunks)
+		{
+			total += c.size;
+			::operator delete(c.data);
+		}
+		chunks.resize(1);
+		chunks[0].size = total;
+		chunks[0].data = (char*) ::operator new(total + ARENA_ALIGNMENT);
+	}
+	if(!chunks.empty())
+		chunks[0].used = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                Arena::release                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Returns every chunk to the heap.                                           *
+*                                                                             *
+*******************************************************************************/
+void Arena::release()
+{
+	for(Chunk& c : chunks)
+		::operator delete(c.data);
+	chunks.clear();
+}
+
+/******************************************************************************
+*                                                                             *
+*                          Arena::getUsed / getCapacity                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The number of bytes handed out since the last reset / obtained from the    *
+*  heap.                                                                      *
+*                                                                             *
+*******************************************************************************/
+size_t Arena::getUsed() const
+{
+	size_t used = 0;
+	for(const Chunk& c : chunks)
+		used += c.used;
+	return used;
+}
+size_t Arena::getCapacity() const
+{
+	size_t size = 0;
+	for(const Chunk& c : chunks)
+		size += c.size;
+	return size;
+}
+
+/******************************************************************************
+*                                                                             *
+*                        BlockPool::BlockPool (Constructor)                   *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param blockSize                                                           *
+*           Size of each block in bytes.                                      *
+*  @param blocksPerChunk                                                      *
+*           Number of blocks obtained from the heap each time the pool grows. *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+BlockPool::BlockPool(size_t blockSize, size_t blocksPerChunk) :
+	freeList(NULL),
+	blockSize((blockSize + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1)),
+	blocksPerChunk(blocksPerChunk), liveBlocks(0)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                        BlockPool::allocate / BlockPool::free                *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param p                                                                   *
+*           Block returned by allocate() (free only, NULL is ignored).        *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  A block of getBlockSize() bytes (allocate only).                           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Pops a block off the free list, first threading a new chunk onto the list  *
+*  if it is empty / pushes a block back onto the free list.                   *
+*                                                                             *
+*******************************************************************************/
+void* BlockPool::allocate()
+{
+	if(freeList == NULL)
+	{
+		char* chunk = (char*) ::operator new(blockSize * blocksPerChunk);
+		chunks.push_back(chunk);
+		for(size_t i = blocksPerChunk; i > 0; i--)
+		{
+			FreeBlock* b = (FreeBlock*) (chunk + (i - 1) * blockSize);
+			b->next  = freeList;
+			freeList = b;
+		}
+	}
+
+	FreeBlock* b = freeList;
+	freeList = b->next;
+	liveBlocks++;
+	return b;
+}
+void BlockPool::free(void* p)
+{
+	if(p == NULL)
+		return;
+	FreeBlock* b = (FreeBlock*) p;
+	b->next  = freeList;
+	freeList = b;
+	liveBlocks--;
+}
+
+/******************************************************************************
+*                                                                             *
+*                       BlockPool::~BlockPool (Destructor)                    *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+BlockPool::~BlockPool()
+{
+	for(char* chunk : chunks)
+		::operator delete(chunk);
+}
+
+/******************************************************************************
+*                                                                             *
+*                    SizeClassPool::SizeClassPool (Constructor)               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param minShift / maxShift                                                 *
+*           Smallest and largest block size, as powers of two.                *
+*  @param chunkSize                                                           *
+*           Bytes each pool takes from the heap at once (at least a block).   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+SizeClassPool::SizeClassPool(size_t minShift, size_t maxShift, size_t chunkSize) :
+	pools(maxShift - minShift + 1, (BlockPool*) NULL),
+	minShift(minShift), maxShift(maxShift), chunkSize(chunkSize)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                             SizeClassPool::sizeClass                        *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param bytes                                                               *
+*           Size of the request.                                              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Index of the smallest class holding bytes, or pools.size() if none does.   *
+*                                                                             *
+*******************************************************************************/
+size_t SizeClassPool::sizeClass(size_t bytes) const
+{
+	size_t c = 0;
+	while(c < pools.size() && ((size_t) 1 << (minShift + c)) < bytes)
+		c++;
+	return c;
+}
+
+/******************************************************************************
+*                                                                             *
+*                   SizeClassPool::allocate / SizeClassPool::free             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param bytes                                                               *
+*           Size of the request (the same for free as for allocate).          *
+*  @param p                                                                   *
+*           Pointer returned by allocate() (free only, NULL is ignored).      *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Pointer to the bytes (allocate only).                                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Takes a block from / puts it back in the pool of the request's class, or  *
+*  goes to the heap for a request bigger than every class.                    *
+*                                                                             *
+*******************************************************************************/
+void* SizeClassPool::allocate(size_t bytes)
+{
+	const size_t c = sizeClass(bytes);
+	if(c == pools.size())
+		return ::operator new(bytes);
+
+	if(pools[c] == NULL)
+	{
+		const size_t blockSize = (size_t) 1 << (minShift + c);
+		pools[c] = new BlockPool(blockSize,
+			blockSize < chunkSize ? chunkSize / blockSize : 1);
+	}
+	return pools[c]->allocate();
+}
+void SizeClassPool::free(void* p, size_t bytes)
+{
+	if(p == NULL)
+		return;
+
+	const size_t c = sizeClass(bytes);
+	if(c == pools.size())
+		::operator delete(p);
+	else
+		pools[c]->free(p);
+}
+
+/******************************************************************************
+*                                                                             *
+*                   SizeClassPool::getLiveBlocks / ~SizeClassPool             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The number of blocks handed out and not given back, over every class      *
+*  (getLiveBlocks only) / void.                                               *
+*                                                                             *
+*******************************************************************************/
+size_t SizeClassPool::getLiveBlocks() const
+{
+	size_t live = 0;
+	for(BlockPool* pool : pools)
+		if(pool != NULL)
+			live += pool->getLiveBlocks();
+	return live;
+}
+SizeClassPool::~SizeClassPool()
+{
+	for(BlockPool* pool : pools)
+		delete pool;
+}
+
+/******************************************************************************
+*                                                                             *
+*                    Memory::allocateBody / Memory::freeBody                  *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param size                                                                *
+*           Size of the record (the dynamic type of the body).                *
+*  @param p                                                                   *
+*           Record to be freed (freeBody only).                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Pointer to the new record (allocateBody only).                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Body records come from the body pool; a body type too big for a pool      *
+*  block falls back on the heap.                                              *
+*                                                                             *
+*******************************************************************************/
+void* Memory::allocateBody(size_t size)
+{
+	if(size <= bodyRecords.getBlockSize())
+		return bodyRecords.allocate();
+	return ::operator new(size);
+}
+void Memory::freeBody(void* p, size_t size)
+{
+	if(size <= bodyRecords.getBlockSize())
+		bodyRecords.free(p);
+	else
+		::operator delete(p);
+}
+
+/******************************************************************************
+*                                                                             *
+*                          Memory::getHeapAllocations                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The number of calls to the global operator new made so far by the calling  *
+*  thread. Other threads (the asset loader, the driver's) do not move it.     *
+*                                                                             *
+*******************************************************************************/
+GLuint64 Memory::getHeapAllocations()
+{
+	return heapAllocations;
+}
+
+/******************************************************************************
+*                                                                             *
+*                       Global operator new / operator delete                 *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Replacements for the global allocation functions which count every call   *
+*  and otherwise behave like the standard ones.                              *
+*                                                                             *
+*******************************************************************************/
+void* operator new(size_t size)
+{
+	heapAllocations++;
+	void* p = std::malloc(size ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	heapAllocations++;
+	return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return operator new(size, std::nothrow);
+}
+void operator delete(void* p) throw()
+{
+	std::free(p);
+}
+void operator delete[](void* p) throw()
+{
+	std::free(p);
+}
+void operator delete(void* p, size_t) throw()
+{
+	std::free(p);
+}
+void operator delete[](void* p, size_t) throw()
+{
+	std::free(p);
+}
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+	std::free(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+	std::free(p);
+}
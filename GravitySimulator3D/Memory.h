@@ -0,0 +1,232 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <cstddef>
+#include <vector>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Alignment of every arena allocation (enough for SSE loads). */
+#define  ARENA_ALIGNMENT                                                   16
+/* Size of the first chunk of the per-step scratch arena. */
+#define  STEP_ARENA_CHUNK_SIZE                                   (1 << 20)
+/* Size of one body record, and number of records per pool chunk. */
+#define  BODY_RECORD_SIZE                                                 512
+#define  BODY_RECORDS_PER_CHUNK                                          1024
+/* Mesh data size classes: powers of two from 1 << MESH_MIN_SHIFT bytes up   *
+ * to 1 << MESH_MAX_SHIFT (larger arrays come straight from the heap), carved *
+ * out of chunks of MESH_CHUNK_SIZE bytes.                                   */
+#define  MESH_MIN_SHIFT                                                     6
+#define  MESH_MAX_SHIFT                                                    18
+#define  MESH_CHUNK_SIZE                                          (1 << 20)
+
+/******************************************************************************
+*                                                                             *
+*                                Arena   (class)                              *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  chunks                                                                     *
+*          Blocks of memory obtained from the heap, filled front to back.     *
+*  chunkSize                                                                  *
+*          Smallest chunk requested from the heap.                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Bump allocator. Allocation moves a pointer forward; nothing is returned to *
+*  the heap until release(). reset() rewinds the arena in one go, and if the  *
+*  last round needed more than one chunk, replaces them with a single chunk   *
+*  big enough for all of it, so a workload that repeats itself stops hitting  *
+*  the heap after its first round. Single allocations are never given back,  *
+*  so an arena only suits scratch space which is rewound as a whole.          *
+*                                                                             *
+*******************************************************************************/
+class Arena
+{
+public:
+	/* Constructor. */
+	               Arena(size_t chunkSize);
+
+	/* Hand out bytes aligned to ARENA_ALIGNMENT. */
+	void*          allocate(size_t bytes);
+	template<typename T>
+	T*             allocate(size_t count)        {  return (T*) allocate(count * sizeof(T)); }
+
+	/* Rewind the arena, invalidating every allocation. */
+	void           reset();
+	/* Return all of the chunks to the heap. */
+	void           release();
+
+	/* Getters. */
+	size_t         getUsed()             const;
+	size_t         getCapacity()         const;
+
+	/* Destructor. */
+	              ~Arena()                       {  release();             }
+
+private:
+	/* Not copyable (owns its chunks). */
+	               Arena(const Arena& rhs);
+	Arena&         operator=(const Arena& rhs);
+
+	/* A block of memory obtained from the heap. */
+	struct Chunk
+	{
+		char*      data;
+		size_t     size;
+		size_t     used;
+	};
+
+	std::vector<Chunk>       chunks;
+	size_t                   chunkSize;
+};
+
+/******************************************************************************
+*                                                                             *
+*                              BlockPool   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  freeList                                                                   *
+*          Singly linked list threaded through the unused blocks.             *
+*  chunks                                                                     *
+*          Blocks of blocksPerChunk blocks obtained from the heap.            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Fixed-size block allocator. Blocks are carved out of large chunks and      *
+*  recycled through a free list, so allocating and freeing are O(1) and only  *
+*  touch the heap when the pool has to grow.                                  *
+*                                                                             *
+*******************************************************************************/
+class BlockPool
+{
+public:
+	/* Constructor. */
+	               BlockPool(size_t blockSize, size_t blocksPerChunk);
+
+	/* Take a block from the pool / put it back. */
+	void*          allocate();
+	void           free(void* p);
+
+	/* Getters. */
+	size_t         getBlockSize()        const   {  return blockSize;      }
+	size_t         getLiveBlocks()       const   {  return liveBlocks;     }
+
+	/* Destructor. */
+	              ~BlockPool();
+
+private:
+	/* Not copyable (owns its chunks). */
+	               BlockPool(const BlockPool& rhs);
+	BlockPool&     operator=(const BlockPool& rhs);
+
+	/* An unused block. */
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	FreeBlock*               freeList;
+	std::vector<char*>       chunks;
+	size_t                   blockSize;
+	size_t                   blocksPerChunk;
+	size_t                   liveBlocks;
+};
+
+/******************************************************************************
+*                                                                             *
+*                            SizeClassPool   (class)                          *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  pools                                                                      *
+*          One BlockPool per size class, smallest first, each made on its     *
+*          first allocation.                                                  *
+*  minShift / maxShift / chunkSize                                            *
+*          Smallest and largest class (as powers of two), and the bytes each  *
+*          pool takes from the heap at once.                                  *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  General allocator for arrays which come and go one by one. A request is   *
+*  rounded up to the next power of two and served from that class's pool, so *
+*  freed blocks are reused by the next array of a similar size instead of     *
+*  waiting for every other allocation to go, as in an Arena. Requests above  *
+*  the largest class go to the heap. The caller passes the size back to       *
+*  free(), as with operator delete.                                           *
+*                                                                             *
+*******************************************************************************/
+class SizeClassPool
+{
+public:
+	/* Constructor. */
+	               SizeClassPool(size_t minShift, size_t maxShift, size_t chunkSize);
+
+	/* Hand out at least bytes, aligned to ARENA_ALIGNMENT / give them back. */
+	void*          allocate(size_t bytes);
+	template<typename T>
+	T*             allocate(size_t count)        {  return (T*) allocate(count * sizeof(T)); }
+	void           free(void* p, size_t bytes);
+
+	/* Getters. */
+	size_t         getLiveBlocks()       const;
+
+	/* Destructor. */
+	              ~SizeClassPool();
+
+private:
+	/* Not copyable (owns its pools). */
+	               SizeClassPool(const SizeClassPool& rhs);
+	SizeClassPool& operator=(const SizeClassPool& rhs);
+
+	/* Class serving a request (past the last one if it is too big). */
+	size_t         sizeClass(size_t bytes)     const;
+
+	std::vector<BlockPool*>  pools;
+	size_t                   minShift;
+	size_t                   maxShift;
+	size_t                   chunkSize;
+};
+
+/******************************************************************************
+*                                                                             *
+*                                Memory   (class)                             *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  bodyRecords (static)                                                       *
+*          Pool backing every OrbitalBody (see OrbitalBody::operator new).    *
+*  meshData (static)                                                          *
+*          Pools backing the vertex, index, and buffer ID arrays of meshes.   *
+*          Meshes are made and freed on the thread owning the GL context.     *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Class consisting of the shared allocators and the global heap counter.     *
+*  Every call to the global operator new is counted per thread, which is how  *
+*  a caller can check that a piece of code (such as a physics step) stays off *
+*  the heap without counting what other threads allocate meanwhile.          *
+*                                                                             *
+*******************************************************************************/
+class Memory
+{
+public:
+	/* Number of global operator new calls so far (calling thread only). */
+	static GLuint64  getHeapAllocations();
+
+	/* Allocate / free a body record of the given size. */
+	static void*     allocateBody(size_t size);
+	static void      freeBody(void* p, size_t size);
+
+	static BlockPool     bodyRecords;
+	static SizeClassPool meshData;
+};
@@ -0,0 +1,134 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "MeshLod.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+/* Cell of a coordinate on a grid of cells of the given size. */
+static GLuint64 gridCell(GLfloat x, GLfloat origin, GLfloat cellSize, GLuint grid)
+{
+	GLint cell = (GLint) floor((x - origin) / cellSize);
+	return (GLuint64) std::max(0, std::min(cell, (GLint) grid));
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 MeshLod::build                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param vertices / indices                                                  *
+*           Full mesh, to which the levels are appended. Indices refer to     *
+*           the whole array, so a level is drawn on its own.                  *
+*  @param levels                                                              *
+*           Filled with the index range and error of every level, finest      *
+*           first.                                                            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void MeshLod::build(std::vector<Vertex>* vertices, std::vector<GLuint>* indices,
+                    std::vector<MeshLevel>* levels)
+{
+	const GLuint numVertices = vertices->size();
+	const GLuint numIndices  = indices->size();
+	MeshLevel full = { 0, numIndices, 0.0f };
+	levels->assign(1, full);
+	if(numIndices < 3 * LOD_MIN_TRIANGLES)
+		return;
+
+	/* Bounding box. */
+	glm::vec3 lo = (*vertices)[0].position;
+	glm::vec3 hi = lo;
+	for(GLuint v = 1; v < numVertices; v++)
+	{
+		lo = glm::min(lo, (*vertices)[v].position);
+		hi = glm::max(hi, (*vertices)[v].position);
+	}
+	GLfloat extent = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+	if(extent <= 0.0f)
+		return;
+
+	/* Start from the power of two nearest the rings of a sphere this size. */
+	GLuint grid = LOD_MIN_GRID;
+	while(grid * grid * 4 <= numVertices && grid < LOD_MAX_GRID)
+		grid *= 2;
+
+	std::unordered_map<GLuint64, GLuint> clusters;
+	std::vector<GLuint>                  remap(numVertices);
+	std::vector<GLuint>                  counts;
+	for(; grid >= LOD_MIN_GRID && levels->size() < LOD_MAX_LEVELS; grid /= 2)
+	{
+		/* Merge the vertices of each cell into one, at their average. */
+		const GLfloat cellSize = extent / grid;
+		const GLuint  first    = vertices->size();
+		clusters.clear();
+		counts.clear();
+		for(GLuint v = 0; v < numVertices; v++)
+		{
+			const Vertex vertex = (*vertices)[v];
+			GLuint64 key =
+				gridCell(vertex.position.x, lo.x, cellSize, grid)                  |
+				gridCell(vertex.position.y, lo.y, cellSize, grid)           << 11  |
+				gridCell(vertex.position.z, lo.z, cellSize, grid)           << 22  |
+				gridCell(vertex.textureCoordinate.x, 0.0f, 1.0f / grid, grid) << 33 |
+				gridCell(vertex.textureCoordinate.y, 0.0f, 1.0f / grid, grid) << 44;
+			std::pair<std::unordered_map<GLuint64, GLuint>::iterator, bool> added =
+				clusters.insert(std::make_pair(key, (GLuint) vertices->size()));
+			remap[v] = added.first->second;
+			if(added.second)
+			{
+				vertices->push_back(vertex);
+				counts.push_back(1);
+				continue;
+			}
+			Vertex& sum = (*vertices)[remap[v]];
+			sum.position          += vertex.position;
+			sum.color             += vertex.color;
+			sum.normal            += vertex.normal;
+			sum.textureCoordinate += vertex.textureCoordinate;
+			counts[remap[v] - first]++;
+		}
+		for(GLuint c = 0; c < counts.size(); c++)
+		{
+			Vertex& vertex = (*vertices)[first + c];
+			GLfloat n = (GLfloat) counts[c];
+			vertex.position          /= n;
+			vertex.color             /= n;
+			vertex.textureCoordinate /= n;
+			if(glm::length(vertex.normal) > 0.0f)
+				vertex.normal = glm::normalize(vertex.normal);
+		}
+
+		/* Keep the triangles whose corners are still apart. */
+		const GLuint start = indices->size();
+		for(GLuint i = 0; i + 2 < numIndices; i += 3)
+		{
+			GLuint a = remap[(*indices)[i]];
+			GLuint b = remap[(*indices)[i + 1]];
+			GLuint c = remap[(*indices)[i + 2]];
+			if(a == b || b == c || a == c)
+				continue;
+			indices->push_back(a);
+			indices->push_back(b);
+			indices->push_back(c);
+		}
+
+		/* Drop the level if it saves too little over the last one kept. */
+		GLuint kept = indices->size() - start;
+		if(kept == 0 || kept > LOD_MIN_REDUCTION * levels->back().numIndices)
+		{
+			vertices->resize(first);
+			indices->resize(start);
+			continue;
+		}
+		MeshLevel level = { start, kept, cellSize };
+		levels->push_back(level);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <vector>
+#include "Geometry.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Most levels a mesh gets, counting the full mesh. */
+#define  LOD_MAX_LEVELS                                                     6
+/* Coarsest clustering grid (cells along the longest side of the mesh). */
+#define  LOD_MIN_GRID                                                       4
+/* Finest one: a vertex's cells, 0 to the grid inclusive, are packed into  *
+ * 11 bits each of its cluster key.                                        */
+#define  LOD_MAX_GRID                                                    1024
+/* A level is only kept if it has at most this share of the triangles of  *
+ * the level before it.                                                   */
+#define  LOD_MIN_REDUCTION                                               0.6f
+/* Meshes with fewer triangles than this are not simplified. */
+#define  LOD_MIN_TRIANGLES                                                 64
+
+/******************************************************************************
+*                                                                             *
+*                                MeshLod   (class)                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Builds the simplified levels of a mesh by vertex clustering. The bounding  *
+*  box is cut into a grid of cubes, every vertex in a cube is merged into     *
+*  one at their average, and the triangles which collapse are dropped. Each   *
+*  level halves the grid of the one before, and is clustered from the full    *
+*  mesh rather than from the previous level, so errors do not add up.         *
+*                                                                             *
+*  Vertices are only merged if their texture coordinates fall in the same     *
+*  cell of a grid of the same size, so the seam of a UV sphere (where the     *
+*  same position has u = 0 and u = 1) stays a seam.                           *
+*                                                                             *
+*  The levels are appended to the mesh's own vertex and index arrays, so      *
+*  one buffer holds them all and a level is drawn by its index range. The     *
+*  error of a level is the size of its grid cells in model units, about the   *
+*  furthest one of its vertices has moved.                                    *
+*                                                                             *
+*******************************************************************************/
+class MeshLod
+{
+public:
+	/* Append the levels of a mesh to its arrays, filling levels with the   *
+	 * full mesh followed by each simplified one.                           */
+	static void    build(std::vector<Vertex>* vertices,
+	                     std::vector<GLuint>* indices,
+	                     std::vector<MeshLevel>* levels);
+};
@@ -0,0 +1,236 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "MortonOrder.h"
+#include <utility>
+
+/******************************************************************************
+*                                                                             *
+*                                      Macros                                 *
+*                                                                             *
+******************************************************************************/
+/* Smallest number of keys worth giving a chunk of its own. */
+#define  MIN_CHUNK_SIZE                                                  4096
+
+/******************************************************************************
+*                                                                             *
+*                             MortonOrder::encode                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param x, y, z                                                             *
+*           Quantized coordinates (only the low 21 bits are used).            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The Morton key zyxzyx...zyx of the three coordinates.                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Spreads the bits of each coordinate two bits apart with the usual          *
+*  shift-and-mask sequence and interleaves the three results.                 *
+*                                                                             *
+*******************************************************************************/
+GLuint64 MortonOrder::encode(GLuint x, GLuint y, GLuint z)
+{
+	GLuint64 c[3] = { x, y, z };
+	for(GLuint i = 0; i < 3; i++)
+	{
+		GLuint64 v = c[i] & 0x1fffff;
+		v = (v | v << 32) & 0x001f00000000ffffull;
+		v = (v | v << 16) & 0x001f0000ff0000ffull;
+		v = (v | v <<  8) & 0x100f00f00f00f00full;
+		v = (v | v <<  4) & 0x10c30c30c30c30c3ull;
+		v = (v | v <<  2) & 0x1249249249249249ull;
+		c[i] = v;
+	}
+	return c[0] | (c[1] << 1) | (c[2] << 2);
+}
+
+/******************************************************************************
+*                                                                             *
+*                           MortonOrder::chunkBegin                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param c                                                                   *
+*           Index of the chunk (0 - numChunks).                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Index of the first key in the chunk.                                       *
+*                                                                             *
+*******************************************************************************/
+GLuint MortonOrder::chunkBegin(GLuint c) const
+{
+	return (GLuint) (((GLuint64) n * c) / numChunks);
+}
+
+/******************************************************************************
+*                                                                             *
+*                          MortonOrder::histogramTask                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param context                                                             *
+*           The MortonOrder running the sort.                                 *
+*  @param task                                                                *
+*           Index of the chunk to count.                                      *
+*  @param worker                                                              *
+*           Index of the worker running the task (unused).                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Counts how many keys of one chunk fall in each bucket of the current pass. *
+*                                                                             *
+*******************************************************************************/
+void MortonOrder::histogramTask(void* context, GLuint task, GLuint /* worker */)
+{
+	MortonOrder* m = (MortonOrder*) context;
+	GLuint*      h = &m->histograms[task * RADIX_BUCKETS];
+
+	for(GLuint b = 0; b < RADIX_BUCKETS; b++)
+		h[b] = 0;
+	for(GLuint i = m->chunkBegin(task); i < m->chunkEnd(task); i++)
+		h[(m->keys[i] >> m->shift) & (RADIX_BUCKETS - 1)]++;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           MortonOrder::scatterTask                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param context                                                             *
+*           The MortonOrder running the sort.                                 *
+*  @param task                                                                *
+*           Index of the chunk to scatter.                                    *
+*  @param worker                                                              *
+*           Index of the worker running the task (unused).                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Moves the keys of one chunk, in order, to the output slots reserved for    *
+*  that chunk by the prefix sum. Since earlier chunks get earlier slots in    *
+*  every bucket, the pass is stable.                                          *
+*                                                                             *
+*******************************************************************************/
+void MortonOrder::scatterTask(void* context, GLuint task, GLuint /* worker */)
+{
+	MortonOrder* m = (MortonOrder*) context;
+	GLuint*      h = &m->histograms[task * RADIX_BUCKETS];
+
+	for(GLuint i = m->chunkBegin(task); i < m->chunkEnd(task); i++)
+	{
+		GLuint slot = h[(m->keys[i] >> m->shift) & (RADIX_BUCKETS - 1)]++;
+		m->keysOut[slot]  = m->keys[i];
+		m->orderOut[slot] = m->order[i];
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                               MortonOrder::sort                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param positions                                                           *
+*           Points to be ordered.                                             *
+*  @param n                                                                   *
+*           Number of points.                                                 *
+*  @param pool                                                                *
+*           Worker threads the histogram and scatter steps are split across.  *
+*  @param scratch                                                             *
+*           Arena the keys and the permutation are allocated from.            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Pointer to n indices listing the points in Morton order. The array stays   *
+*  valid until the scratch arena is reset.                                    *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Quantizes every point into a 2^21 grid spanning the bounding box of the    *
+*  set, builds its Morton key, and radix sorts the keys RADIX_BITS at a time. *
+*  Passes in which every key lands in the same bucket are skipped.            *
+*                                                                             *
+*******************************************************************************/
+const GLuint* MortonOrder::sort(const glm::vec3* positions,
+                                const GLuint     n,
+                                      WorkerPool* pool,
+                                      Arena*     scratch)
+{
+	this->pool = pool;
+	this->n    = n;
+	numChunks  = glm::clamp(n / MIN_CHUNK_SIZE, 1u, pool->getNumWorkers());
+
+	/* Scratch space, dropped with the rest of the caller's step. */
+	keys       = scratch->allocate<GLuint64>(n);
+	keysOut    = scratch->allocate<GLuint64>(n);
+	order      = scratch->allocate<GLuint>(n);
+	orderOut   = scratch->allocate<GLuint>(n);
+	histograms = scratch->allocate<GLuint>(numChunks * RADIX_BUCKETS);
+
+	if(n == 0)
+		return order;
+
+	/* Bounding box of the set. */
+	glm::vec3 lo = positions[0];
+	glm::vec3 hi = positions[0];
+	for(GLuint i = 1; i < n; i++)
+	{
+		lo = glm::min(lo, positions[i]);
+		hi = glm::max(hi, positions[i]);
+	}
+	GLfloat   cells  = (GLfloat) ((1 << MORTON_BITS_PER_AXIS) - 1);
+	glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-30f));
+	glm::vec3 toGrid = cells / extent;
+
+	/* Build the keys. */
+	for(GLuint i = 0; i < n; i++)
+	{
+		glm::vec3 g = (positions[i] - lo) * toGrid;
+		keys[i]  = encode((GLuint) g.x, (GLuint) g.y, (GLuint) g.z);
+		order[i] = i;
+	}
+
+	/* One stable pass per digit, least significant first. */
+	for(shift = 0; shift < 3 * MORTON_BITS_PER_AXIS; shift += RADIX_BITS)
+	{
+		pool->run(histogramTask, this, numChunks);
+
+		/* Skip the pass if it would not move anything. */
+		GLuint digit = (keys[0] >> shift) & (RADIX_BUCKETS - 1);
+		GLuint count = 0;
+		for(GLuint c = 0; c < numChunks; c++)
+			count += histograms[c * RADIX_BUCKETS + digit];
+		if(count == n)
+			continue;
+
+		/* Exclusive prefix sum, bucket-major then chunk-major. */
+		GLuint offset = 0;
+		for(GLuint b = 0; b < RADIX_BUCKETS; b++)
+			for(GLuint c = 0; c < numChunks; c++)
+			{
+				GLuint tally = histograms[c * RADIX_BUCKETS + b];
+				histograms[c * RADIX_BUCKETS + b] = offset;
+				offset += tally;
+			}
+
+		pool->run(scatterTask, this, numChunks);
+		std::swap(keys, keysOut);
+		std::swap(order, orderOut);
+	}
+
+	return order;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+#include "WorkerPool.h"
+#include "Memory.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Bits of each coordinate interleaved into a key (3 * 21 = 63). */
+#define  MORTON_BITS_PER_AXIS                                              21
+/* Bits sorted by each pass of the radix sort. */
+#define  RADIX_BITS                                                         8
+#define  RADIX_BUCKETS                                    (1 << RADIX_BITS)
+
+/******************************************************************************
+*                                                                             *
+*                             MortonOrder   (class)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  keys / order                                                               *
+*          Morton key of every body and the permutation being sorted, plus    *
+*          the buffers they are scattered into on each pass. Allocated from   *
+*          the caller's scratch arena on every sort.                          *
+*  histograms                                                                 *
+*          RADIX_BUCKETS counters for every chunk of the input; after the     *
+*          prefix sum, the first output slot of each (chunk, bucket).         *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Sorts a set of points along a 3-D Morton (Z-order) curve, so that points   *
+*  which are close in space end up close in memory. The sort is a stable LSD  *
+*  radix sort split into chunks across a worker pool; the permutation it      *
+*  returns is the same for any number of workers.                             *
+*                                                                             *
+*******************************************************************************/
+class MortonOrder
+{
+public:
+	/* Constructor. */
+	               MortonOrder()                 :  keys(nullptr),
+	                                                keysOut(nullptr),
+	                                                order(nullptr),
+	                                                orderOut(nullptr),
+	                                                histograms(nullptr),
+	                                                pool(nullptr), n(0),
+	                                                numChunks(0), shift(0) {}
+
+	/* Sort n points, returning order[k] = index of the k-th point. */
+	const GLuint*  sort(const glm::vec3* positions,
+	                    const GLuint     n,
+	                          WorkerPool* pool,
+	                          Arena*     scratch);
+
+	/* Interleave three 21-bit coordinates into a 63-bit key. */
+	static GLuint64 encode(GLuint x, GLuint y, GLuint z);
+
+private:
+	/* Task bodies handed to the worker pool. */
+	static void    histogramTask(void* context, GLuint task, GLuint worker);
+	static void    scatterTask(void* context, GLuint task, GLuint worker);
+
+	/* First and one-past-last element of a chunk. */
+	GLuint         chunkBegin(GLuint c)  const;
+	GLuint         chunkEnd(GLuint c)    const   {  return chunkBegin(c + 1); }
+
+	GLuint64*                keys;
+	GLuint64*                keysOut;
+	GLuint*                  order;
+	GLuint*                  orderOut;
+	GLuint*                  histograms;
+
+	/* State of the pass currently running. */
+	WorkerPool*              pool;
+	GLuint                   n;
+	GLuint                   numChunks;
+	GLuint                   shift;
+};
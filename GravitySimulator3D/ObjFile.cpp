@@ -0,0 +1,439 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "ObjFile.h"
+#include "FastParse.h"
+#include "MappedFile.h"
+#include "tiny_obj_loader.h"
+#include <SDL\SDL.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+
+/******************************************************************************
+*                                                                             *
+*                                      Macros                                 *
+*                                                                             *
+******************************************************************************/
+/* Output buffer of the generator. */
+#define  OBJ_GENERATE_BUFFER_SIZE                                   (1 << 20)
+/* Index of a corner without a texture coordinate or normal. */
+#define  OBJ_NO_INDEX                                                      -1
+/* Marks an unused entry of the vertex hash table. */
+#define  OBJ_EMPTY_ENTRY                                           0xffffffff
+/* Times each parser is run by the benchmark (the best time is kept). */
+#define  OBJ_BENCH_RUNS                                                     3
+
+/******************************************************************************
+*                                                                             *
+*                          ObjCorner / ObjCornerTable                         *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Open-addressing hash table from a face corner (its position, texture       *
+*  coordinate, and normal indices) to the vertex made for it. Probing is      *
+*  linear, and the table doubles before it is half full.                      *
+*                                                                             *
+*******************************************************************************/
+struct ObjCorner
+{
+	GLint                    v;
+	GLint                    vt;
+	GLint                    vn;
+	GLuint                   vertex;
+};
+
+class ObjCornerTable
+{
+public:
+	               ObjCornerTable(GLuint expected) : count(0)
+	{
+		GLuint size = OBJ_MIN_HASH_SIZE;
+		while(size * OBJ_MAX_HASH_LOAD < expected)
+			size *= 2;
+		resize(size);
+	}
+
+	/* Vertex of a corner, or OBJ_EMPTY_ENTRY after reserving its entry. */
+	GLuint*        find(GLint v, GLint vt, GLint vn)
+	{
+		if(count + 1 > entries.size() * OBJ_MAX_HASH_LOAD)
+			resize(entries.size() * 2);
+		GLuint mask = entries.size() - 1;
+		for(GLuint i = hash(v, vt, vn) & mask; ; i = (i + 1) & mask)
+		{
+			ObjCorner& entry = entries[i];
+			if(entry.vertex == OBJ_EMPTY_ENTRY)
+			{
+				entry.v  = v;
+				entry.vt = vt;
+				entry.vn = vn;
+				count++;
+				return &entry.vertex;
+			}
+			if(entry.v == v && entry.vt == vt && entry.vn == vn)
+				return &entry.vertex;
+		}
+	}
+
+private:
+	static GLuint  hash(GLint v, GLint vt, GLint vn)
+	{
+		/* Mix the three indices, then finish like MurmurHash3. */
+		GLuint h = (GLuint) v * 0x9e3779b1u ^ (GLuint) vt * 0x85ebca77u ^ (GLuint) vn * 0xc2b2ae3du;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h;
+	}
+
+	void           resize(GLuint size)
+	{
+		std::vector<ObjCorner> old;
+		old.swap(entries);
+		ObjCorner empty = { 0, 0, 0, OBJ_EMPTY_ENTRY };
+		entries.assign(size, empty);
+		GLuint mask = size - 1;
+		for(const ObjCorner& entry : old)
+		{
+			if(entry.vertex == OBJ_EMPTY_ENTRY)
+				continue;
+			GLuint i = hash(entry.v, entry.vt, entry.vn) & mask;
+			while(entries[i].vertex != OBJ_EMPTY_ENTRY)
+				i = (i + 1) & mask;
+			entries[i] = entry;
+		}
+	}
+
+	std::vector<ObjCorner>   entries;
+	GLuint                   count;
+};
+
+/* Skip spaces and tabs (not line ends). */
+static const char* skipBlanks(const char* p, const char* end)
+{
+	while(p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	return p;
+}
+
+/* Read the floats of a line, missing ones being 0 (as atof gives). */
+static const char* parseFloats(const char* p, const char* end, GLfloat* values, int n)
+{
+	for(int i = 0; i < n; i++)
+	{
+		p = skipBlanks(p, end);
+		if(!FastParse::parseFloat(p, end, &values[i]))
+			values[i] = 0.0f;
+	}
+	return p;
+}
+
+/* Read a face index (0 if there is none, as atoi gives) and make it     *
+ * 0-based; negative indices count back from the last element read.     */
+static GLint parseIndex(const char*& p, const char* end, GLint n)
+{
+	bool  negative = false;
+	GLint value    = 0;
+	if(p < end && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+	for(; p < end && *p >= '0' && *p <= '9'; p++)
+		value = value * 10 + (*p - '0');
+	if(negative)
+		value = -value;
+	return value > 0 ? value - 1 : value == 0 ? 0 : n + value;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 ObjFile::parse                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           OBJ file to be read.                                              *
+*  @param vertices                                                            *
+*           Filled with one Vertex per distinct face corner.                  *
+*  @param indices                                                             *
+*           Filled with three vertex indices per triangle.                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file could be read.                                            *
+*                                                                             *
+*******************************************************************************/
+bool ObjFile::parse(const char* path, std::vector<Vertex>* vertices,
+                    std::vector<GLuint>* indices)
+{
+	MappedFile file;
+	if(!file.open(path))
+	{
+		std::cerr << "Error loading obj: could not open " << path << std::endl;
+		return false;
+	}
+	const char* p   = (const char*) file.getData();
+	const char* end = p + file.getSize();
+
+	/* Size everything from the file once, instead of regrowing it. */
+	const GLuint expected = (GLuint) (file.getSize() / OBJ_BYTES_PER_VERTEX) + 1;
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> texcoords;
+	positions.reserve(expected);
+	normals.reserve(expected);
+	texcoords.reserve(expected);
+	vertices->clear();
+	indices->clear();
+	vertices->reserve(expected);
+	indices->reserve(expected * 6);
+	ObjCornerTable      corners(expected);
+	std::vector<GLuint> face;
+
+	GLuint line = 0;
+	while(p < end)
+	{
+		line++;
+		const char* eol = (const char*) memchr(p, '\n', end - p);
+		if(eol == nullptr)
+			eol = end;
+		p = skipBlanks(p, eol);
+
+		const bool blank1 = p + 1 < eol && (p[1] == ' ' || p[1] == '\t');
+		const bool blank2 = p + 2 < eol && (p[2] == ' ' || p[2] == '\t');
+		if(p < eol && p[0] == 'v' && blank1)
+		{
+			GLfloat xyz[3];
+			parseFloats(p + 2, eol, xyz, 3);
+			positions.push_back(glm::vec3(xyz[0], xyz[1], xyz[2]));
+		}
+		else if(p + 1 < eol && p[0] == 'v' && p[1] == 'n' && blank2)
+		{
+			GLfloat xyz[3];
+			parseFloats(p + 3, eol, xyz, 3);
+			normals.push_back(glm::vec3(xyz[0], xyz[1], xyz[2]));
+		}
+		else if(p + 1 < eol && p[0] == 'v' && p[1] == 't' && blank2)
+		{
+			GLfloat st[2];
+			parseFloats(p + 3, eol, st, 2);
+			texcoords.push_back(glm::vec2(st[0], st[1]));
+		}
+		else if(p < eol && p[0] == 'f' && blank1)
+		{
+			/* Resolve every corner to a vertex, making the new ones. */
+			face.clear();
+			for(p = skipBlanks(p + 2, eol); p < eol && *p != '\r'; p = skipBlanks(p, eol))
+			{
+				GLint v  = parseIndex(p, eol, positions.size());
+				GLint vt = OBJ_NO_INDEX;
+				GLint vn = OBJ_NO_INDEX;
+				if(p < eol && *p == '/')
+				{
+					p++;
+					if(p < eol && *p != '/')
+						vt = parseIndex(p, eol, texcoords.size());
+					if(p < eol && *p == '/')
+					{
+						p++;
+						vn = parseIndex(p, eol, normals.size());
+					}
+				}
+				while(p < eol && *p != ' ' && *p != '\t' && *p != '\r')
+					p++;
+
+				if(v < 0 || v >= (GLint) positions.size() ||
+				   vt >= (GLint) texcoords.size() || vn >= (GLint) normals.size() ||
+				   vt < OBJ_NO_INDEX || vn < OBJ_NO_INDEX)
+				{
+					std::cerr << "Error loading obj: " << path << " line " << line
+					          << ": index out of range" << std::endl;
+					return false;
+				}
+
+				GLuint* vertex = corners.find(v, vt, vn);
+				if(*vertex == OBJ_EMPTY_ENTRY)
+				{
+					*vertex = vertices->size();
+					glm::vec2 st = vt == OBJ_NO_INDEX ? glm::vec2(0.0f) : texcoords[vt];
+					vertices->push_back({
+						positions[v],
+						DEFAULT_VERTEX_COLOR,
+						vn == OBJ_NO_INDEX ? glm::vec3(0.0f) : normals[vn],
+						{ st.x, 1 - st.y }
+					});
+				}
+				face.push_back(*vertex);
+			}
+
+			/* Split the polygon into a triangle fan. */
+			for(GLuint k = 2; k < face.size(); k++)
+			{
+				indices->push_back(face[0]);
+				indices->push_back(face[k - 1]);
+				indices->push_back(face[k]);
+			}
+		}
+		else if(p < eol && (p[0] == 'g' || p[0] == 'o') && blank1 && !indices->empty())
+			break;
+
+		p = eol < end ? eol + 1 : end;
+	}
+
+	if(indices->empty())
+	{
+		std::cerr << "Error loading obj: " << path << " has no faces" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                               ObjFile::generate                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           File to be written.                                               *
+*  @param rings                                                               *
+*           Number of rings of quads from pole to pole.                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file was written.                                              *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes (rings + 1) x (2 * rings + 1) vertices, each with its own position, *
+*  texture coordinate, and normal, and one quad per cell of the grid, laid    *
+*  out the way modelling tools export a sphere.                               *
+*                                                                             *
+*******************************************************************************/
+bool ObjFile::generate(const char* path, GLuint rings)
+{
+	FILE* out = fopen(path, "wb");
+	if(out == nullptr)
+		return false;
+	setvbuf(out, nullptr, _IOFBF, OBJ_GENERATE_BUFFER_SIZE);
+
+	const GLuint segments = 2 * rings;
+	fprintf(out, "# UV sphere, %u rings x %u segments\no sphere\n", rings, segments);
+	for(GLuint i = 0; i <= rings; i++)
+	{
+		GLdouble theta = M_PI * i / rings;
+		for(GLuint j = 0; j <= segments; j++)
+		{
+			GLdouble phi = 2.0 * M_PI * j / segments;
+			GLdouble x   = sin(theta) * cos(phi), y = cos(theta), z = sin(theta) * sin(phi);
+			fprintf(out, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+				x, y, z, (GLdouble) j / segments, 1.0 - (GLdouble) i / rings, x, y, z);
+		}
+	}
+	for(GLuint i = 0; i < rings; i++)
+		for(GLuint j = 0; j < segments; j++)
+		{
+			GLuint a = i * (segments + 1) + j + 1, b = a + 1;
+			GLuint c = b + segments + 1,           d = a + segments + 1;
+			fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n",
+				a, a, a, d, d, d, c, c, c, b, b, b);
+		}
+	return fclose(out) == 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              ObjFile::benchmark                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param rings                                                               *
+*           Number of rings of the generated sphere.                          *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes a sphere to OBJ_FILE_BENCH_PATH and reads it with both parsers,     *
+*  OBJ_BENCH_RUNS times each, keeping the best time. The old path includes    *
+*  the copy out of tiny_obj_loader's shape that Geometry used to make. The    *
+*  two results are compared, and the file is removed.                         *
+*                                                                             *
+*******************************************************************************/
+void ObjFile::benchmark(GLuint rings)
+{
+	if(!generate(OBJ_FILE_BENCH_PATH, rings))
+	{
+		std::cerr << "ObjFile: could not write " << OBJ_FILE_BENCH_PATH << std::endl;
+		return;
+	}
+	MappedFile file;
+	GLdouble   mb = file.open(OBJ_FILE_BENCH_PATH) ? file.getSize() / (1024.0 * 1024.0) : 0;
+	file.close();
+
+	/* tiny_obj_loader, then the copy into Vertex / index arrays. */
+	std::vector<Vertex> oldVertices;
+	std::vector<GLuint> oldIndices;
+	GLdouble            oldSeconds = 0;
+	for(GLuint run = 0; run < OBJ_BENCH_RUNS; run++)
+	{
+		GLuint64 start = SDL_GetPerformanceCounter();
+		std::vector<tinyobj::shape_t>    shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string err = tinyobj::LoadObj(shapes, materials, OBJ_FILE_BENCH_PATH);
+		if(!err.empty() || shapes.empty())
+		{
+			std::cerr << "ObjFile: tiny_obj_loader failed: " << err << std::endl;
+			remove(OBJ_FILE_BENCH_PATH);
+			return;
+		}
+		tinyobj::shape_t s = shapes.at(0);
+		oldVertices.clear();
+		oldIndices.clear();
+		for(GLuint i = 0; i < (s.mesh.positions.size() / 3); i++)
+			oldVertices.push_back({
+				{ s.mesh.positions.at((3 * i) + 0), s.mesh.positions.at((3 * i) + 1),
+				  s.mesh.positions.at((3 * i) + 2) },
+				DEFAULT_VERTEX_COLOR,
+				{ s.mesh.normals.at((3 * i) + 0), s.mesh.normals.at((3 * i) + 1),
+				  s.mesh.normals.at((3 * i) + 2) },
+				{ s.mesh.texcoords.at((2 * i) + 0), 1 - s.mesh.texcoords.at((2 * i) + 1) }
+			});
+		for(GLuint i = 0; i < s.mesh.indices.size(); i++)
+			oldIndices.push_back(s.mesh.indices.at(i));
+		GLdouble secs = (GLdouble) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+		if(run == 0 || secs < oldSeconds)
+			oldSeconds = secs;
+	}
+
+	/* Mapped single pass. */
+	std::vector<Vertex> newVertices;
+	std::vector<GLuint> newIndices;
+	GLdouble            newSeconds = 0;
+	for(GLuint run = 0; run < OBJ_BENCH_RUNS; run++)
+	{
+		GLuint64 start = SDL_GetPerformanceCounter();
+		if(!parse(OBJ_FILE_BENCH_PATH, &newVertices, &newIndices))
+		{
+			remove(OBJ_FILE_BENCH_PATH);
+			return;
+		}
+		GLdouble secs = (GLdouble) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+		if(run == 0 || secs < newSeconds)
+			newSeconds = secs;
+	}
+	remove(OBJ_FILE_BENCH_PATH);
+
+	bool same = oldVertices.size() == newVertices.size() && oldIndices == newIndices &&
+		memcmp(oldVertices.data(), newVertices.data(), oldVertices.size() * sizeof(Vertex)) == 0;
+	fprintf(stdout, "Mesh: %u vertices, %u triangles (%.1f MB)\n",
+		(GLuint) newVertices.size(), (GLuint) newIndices.size() / 3, mb);
+	fprintf(stdout, "tiny_obj_loader: %.1f ms, %.1f MB/s\n", 1000.0 * oldSeconds, mb / oldSeconds);
+	fprintf(stdout, "ObjFile:         %.1f ms, %.1f MB/s (%.1fx), %s\n", 1000.0 * newSeconds,
+		mb / newSeconds, oldSeconds / newSeconds, same ? "identical" : "DIFFERENT");
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <vector>
+#include "Geometry.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* File written and read by ObjFile::benchmark. */
+#define  OBJ_FILE_BENCH_PATH                                  "bench_mesh.obj"
+/* Smallest vertex hash table, and the most it is filled before it grows. */
+#define  OBJ_MIN_HASH_SIZE                                               1024
+#define  OBJ_MAX_HASH_LOAD                                                0.5
+/* Rough bytes of file per distinct vertex, to size the tables up front. */
+#define  OBJ_BYTES_PER_VERTEX                                             96
+
+/******************************************************************************
+*                                                                             *
+*                               ObjFile   (class)                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Reads Wavefront OBJ meshes straight into the interleaved Vertex array and  *
+*  index buffer a Mesh is built from. The file is mapped into memory and      *
+*  scanned once: numbers are read in place with FastParse, and each face      *
+*  corner (position / texture coordinate / normal triple) is looked up in an  *
+*  open-addressing hash table, so a corner seen before costs one probe and a  *
+*  new one is written to the Vertex array there and then.                     *
+*                                                                             *
+*  The result matches what tiny_obj_loader gave Geometry: polygons are split  *
+*  into triangle fans, vertices are numbered in the order they are first      *
+*  used, texture coordinates are flipped to OpenGL's convention, and only     *
+*  the first group (or object) with faces is read. Corners without a normal   *
+*  or texture coordinate get zeros; materials are ignored.                    *
+*                                                                             *
+*******************************************************************************/
+class ObjFile
+{
+public:
+	/* Read a mesh (false, with a message, if it is malformed). */
+	static bool    parse(const char* path, std::vector<Vertex>* vertices,
+	                     std::vector<GLuint>* indices);
+	/* Write a UV sphere of rings x (2 * rings) quads, with normals and     *
+	 * texture coordinates.                                                */
+	static bool    generate(const char* path, GLuint rings);
+	/* Generate a sphere and time parsing it with tiny_obj_loader (and the *
+	 * copy Geometry used to make) and with parse(), printing the rates.   */
+	static void    benchmark(GLuint rings);
+};
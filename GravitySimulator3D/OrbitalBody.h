@@ -8,6 +8,8 @@
 #include  <math.h>
 #include  <string>
 #include  "Geometry.h"
+#include  "Memory.h"
+#include  "Trail.h"
 #include  "glm\glm.hpp"
 #include  "glm\gtc\matrix_transform.hpp"
 #include  "glm\gtx\vector_angle.hpp"
@@ -23,6 +25,35 @@
 #define   DEFAULT_ROT_AXIS   glm::vec3(+0.0f, +1.0f, +0.0f)
 #define   RAD_TO_DEG         (180 / M_PI)
 
+/******************************************************************************
+*                                                                             *
+*                            BodyState   (struct)                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Every numeric field of an OrbitalBody which evolves with the simulation,   *
+*  as plain values, so that it can be saved and restored bit for bit.         *
+*                                                                             *
+*******************************************************************************/
+struct BodyState
+{
+	glm::vec3      scale;
+	glm::vec3      gravityVector;
+	glm::vec3      linearPosition;
+	glm::vec3      linearVelocity;
+	glm::vec3      linearThrust;
+	glm::vec3      linearAccel;
+	glm::vec3      rotationalAxis;
+	GLfloat        radius;
+	GLfloat        mass;
+	GLfloat        rotationalAngle;
+	GLfloat        angularPosition;
+	GLfloat        angularVelocity;
+	GLfloat        angularAccel;
+	GLfloat        angularThrust;
+	GLfloat        reserved;
+};
+
 /******************************************************************************
  *																			  *
  *                             OrbitalBody Class                              *
@@ -33,7 +64,9 @@
  *          Name of the orbital body (used for hash mapping).                 *
  *  geometry                                                                  *
  *          Mesh describing the position, color, and texture of the vertices  *
- *          to be displayed.                                                  *
+ *          to be displayed. Shared with every body using the same OBJ file.  *
+ *  texture                                                                   *
+ *          Texture drawn on the mesh, shared the same way (see AssetCache).  *
  *  radius                                                                    *
  *          METERS                                                            *
  *          Bounding distance from the center of the object to its surface.   *
@@ -82,6 +115,10 @@
  *  transformationMatrix                                                      *
  *          Matrix describing the body's current transformation, which is     *
  *          based on the current linear and angular positions of the body.    *
+ *          Only rebuilt when a frame is about to be drawn.                   *
+ *  tiltMatrix                                                                *
+ *          Rotation to the angle of inclination, rebuilt only after the tilt *
+ *          is changed.                                                       *
  *                                                                            *
  ******************************************************************************
  * DESCRIPTION                                                                *
@@ -99,6 +136,8 @@ public:
 
 	/* Default Constructor. */
 	OrbitalBody() :
+		geometry(nullptr),
+		texture(0),
 		radius(0),
 		scale(1),
 		mass(0),  
@@ -113,7 +152,9 @@ public:
 		angularVelocity(0),
 		angularAccel(0),
 		angularThrust(0), 
-		transMatrix(0)                            {}
+		transMatrix(0),
+		trail(nullptr),
+		tiltDirty(true)                           {}
 
 	/************************************************************************** 
 	 *  Calculate the current transformation matrix based upon the object's   *
@@ -121,25 +162,31 @@ public:
 	 *************************************************************************/
 	void snapshotMatrix()           
 	{
-		/* Scale the body. */
-		glm::mat4 scaleM          = glm::scale(glm::mat4(), 
-                                               scale);
-		/* Rotate the body. */
-		glm::mat4 rotM;
-		
-		glm::vec3 cross = glm::cross(DEFAULT_ROT_AXIS, rotationalAxis);
+		snapshotMatrix(cos(angularPosition), sin(angularPosition));
+	}
 
-		/* Rotate to angle of inclination. */
-		if(rotationalAxis != DEFAULT_ROT_AXIS)
-			rotM                  = glm::rotate(rotationalAngle, cross);
-		
-		rotM                      = glm::rotate(rotM, 
-                                                angularPosition,
-                                                DEFAULT_ROT_AXIS);	       
-		/* Translate the body. */
-		glm::mat4 tranM           = glm::translate(glm::mat4(), 
-                                                   linearPosition);
-		transMatrix   = tranM * rotM * scaleM ;
+	/************************************************************************** 
+	 *  Same as above, given the cosine and sine of the angular position      *
+	 *  (computed in a batch by the system). Builds translate * tilt * spin * *
+	 *  scale directly: the spin is about the Y axis, so only the columns of  *
+	 *  the cached tilt rotation need to be mixed.                            *
+	 *************************************************************************/
+	void snapshotMatrix(GLfloat c, GLfloat s)
+	{
+		/* Rotation to the angle of inclination only changes with the tilt. */
+		if(tiltDirty)
+		{
+			tiltMatrix = glm::mat3();
+			if(rotationalAxis != DEFAULT_ROT_AXIS)
+				tiltMatrix = glm::mat3(glm::rotate(rotationalAngle,
+				             glm::cross(DEFAULT_ROT_AXIS, rotationalAxis)));
+			tiltDirty = false;
+		}
+
+		transMatrix[0] = glm::vec4(scale.x * (c * tiltMatrix[0] - s * tiltMatrix[2]), 0);
+		transMatrix[1] = glm::vec4(scale.y * tiltMatrix[1], 0);
+		transMatrix[2] = glm::vec4(scale.z * (s * tiltMatrix[0] + c * tiltMatrix[2]), 0);
+		transMatrix[3] = glm::vec4(linearPosition, 1);
 	}
 
 	/************************************************************************** 
@@ -169,6 +216,7 @@ public:
 	/* Getters. */			
 	std::string    getName()            const     {  return name;            }
 	Mesh*          getGeometry()        const     {  return geometry;        }
+	GLuint         getTexture()         const     {  return texture;         }
 	GLfloat        getRadius()          const     {  return radius;          }
 	glm::vec3      getScale()           const     {  return scale;           }
 	GLfloat        getMass()            const     {  return mass;            }
@@ -183,10 +231,53 @@ public:
 	GLfloat        getAngularAccel()    const     {  return angularAccel;    }
 	GLfloat        getAngularThrust()   const     {  return angularThrust;   }
 	glm::mat4*     getTransformation()            {  return &transMatrix;    }
+	Trail*         getTrail()           const     {  return trail;           }
+	std::string    getMeshFile()        const     {  return meshFile;        }
+	std::string    getTextureFile()     const     {  return textureFile;     }
+
+	/* Copy every evolving field out of / into a plain record. */
+	void getState(BodyState* s) const
+	{
+		s->scale           = scale;
+		s->gravityVector   = gravityVector;
+		s->linearPosition  = linearPosition;
+		s->linearVelocity  = linearVelocity;
+		s->linearThrust    = linearThrust;
+		s->linearAccel     = linearAccel;
+		s->rotationalAxis  = rotationalAxis;
+		s->radius          = radius;
+		s->mass            = mass;
+		s->rotationalAngle = rotationalAngle;
+		s->angularPosition = angularPosition;
+		s->angularVelocity = angularVelocity;
+		s->angularAccel    = angularAccel;
+		s->angularThrust   = angularThrust;
+		s->reserved        = 0;
+	}
+	void setState(const BodyState& s)
+	{
+		scale           = s.scale;
+		gravityVector   = s.gravityVector;
+		linearPosition  = s.linearPosition;
+		linearVelocity  = s.linearVelocity;
+		linearThrust    = s.linearThrust;
+		linearAccel     = s.linearAccel;
+		rotationalAxis  = s.rotationalAxis;
+		radius          = s.radius;
+		mass            = s.mass;
+		rotationalAngle = s.rotationalAngle;
+		angularPosition = s.angularPosition;
+		angularVelocity = s.angularVelocity;
+		angularAccel    = s.angularAccel;
+		angularThrust   = s.angularThrust;
+		tiltDirty       = true;
+	}
 												  
 	/* Setters. */			
 	void           setName(std::string n)         {  name              = n;  }
 	void           setGeometry(Mesh* g)           {  geometry          = g;  }
+	void           setTexture(GLuint t)           {  texture           = t;  }
+	void           setTrail(Trail* t)             {  trail             = t;  }
 	void           setRadius(GLfloat r)           {  radius            = r;  }
 	void           setScale(glm::vec3 s)          {  scale             = s;  }
 	void           setMass(GLfloat m)             {  mass              = m;  }
@@ -199,6 +290,7 @@ public:
 	{  
 		rotationalAngle = tilt * 3.14f / 180.0f;
 		rotationalAxis  = glm::rotateX(DEFAULT_ROT_AXIS, rotationalAngle);
+		tiltDirty       = true;
 	}
 	void           setAngularPosition(GLfloat p)  
 	{  
@@ -211,8 +303,13 @@ public:
 	void           setAngularAccel(GLfloat a)     {  angularAccel      = a;  }
 	void           setAngularThrust(GLfloat t)    {  angularThrust     = t;  }
 
+	/* Body records come from the body pool instead of the heap. */
+	static void*   operator new(size_t size)     {  return Memory::allocateBody(size); }
+	static void    operator delete(void* p, size_t size)
+	                                             {  Memory::freeBody(p, size);         }
+
 	/* Destructor. */
-	~OrbitalBody()                                {                          }
+	virtual ~OrbitalBody()                        {                          }
 
 /* Protected Members. */
 protected:
@@ -220,6 +317,11 @@ protected:
 	std::string    name;
 	/* Mesh describing the geometry of the body. */
 	Mesh*          geometry;
+	/* Texture drawn on the mesh (0 for none). */
+	GLuint         texture;
+	/* Files the mesh and its texture were loaded from. */
+	std::string    meshFile;
+	std::string    textureFile;
 	/* Bounding radius of the orbital body. */
 	GLfloat        radius;
 	/* Scale of x, y, and z dimensions of the body. */
@@ -251,6 +353,10 @@ protected:
 
 	/* Mesh transformation data. */
 	glm::mat4      transMatrix;
-	Mesh*          trail;
+	/* Recent positions of the body (owned by the system, may be null). */
+	Trail*         trail;
+	/* Cached rotation to the angle of inclination. */
+	glm::mat3      tiltMatrix;
+	bool           tiltDirty;
 
 };
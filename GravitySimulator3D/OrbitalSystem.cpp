@@ -1,107 +1,306 @@
 #include "OrbitalSystem.h"
-#include "tinyxml2.h"
+#include "SystemFile.h"
+#include "SceneFile.h"
 #include <glm\gtx\rotate_vector.hpp>
 #include <iostream>
 #include "Planet.h"
+#include "MappedFile.h"
+#include "AssetCache.h"
+#include <cstring>
+#include <algorithm>
 
 
 OrbitalSystem::OrbitalSystem(const OrbitalSystem& rhs) :
-	  G(rhs.getG()), clock(rhs.t()), starsMatrix(rhs.getStarsMatrix())
+	  G(rhs.getG()), clock(rhs.t()), scale(rhs.scale),
+	  stars(rhs.stars), starsTexture(rhs.starsTexture),
+	  starsMatrix(rhs.getStarsMatrix()),
+	  starsMeshFile(rhs.starsMeshFile), starsTextureFile(rhs.starsTextureFile),
+	  handles(rhs.handles), slots(rhs.slots),
+	  freeSlot(rhs.freeSlot), names(rhs.names),
+	  pool(nullptr), solver(nullptr), numWorkers(rhs.numWorkers),
+	  reductionMode(rhs.reductionMode),
+	  stepArena(STEP_ARENA_CHUNK_SIZE),
+	  numSteps(0), heapSteps(0), heapAllocations(0), workerHeapAllocations(0),
+	  transformsStale(true), numTrails(0), maxTrails(rhs.maxTrails),
+	  recorder(nullptr), recordInterval(1),
+	  sortInterval(rhs.sortInterval), stepsSinceSort(rhs.stepsSinceSort)
 {
-	stars = new Mesh(*rhs.stars);
+	/* The copy shares the meshes and textures, and draws its own trails. */
+	AssetCache::retainMesh(stars);
+	AssetCache::retainTexture(starsTexture);
 	for(OrbitalBody* b : rhs.bodies)
-		bodies.push_back(new OrbitalBody(*b));
+	{
+		OrbitalBody* copy = new OrbitalBody(*b);
+		AssetCache::retainMesh(copy->getGeometry());
+		AssetCache::retainTexture(copy->getTexture());
+		copy->setTrail(nullptr);
+		bodies.push_back(copy);
+	}
 	
 	meshes.push_back(stars);
+	textures.push_back(starsTexture);
+	lodLevels.push_back(0);
 	for(unsigned int i = 0; i < bodies.size(); i++)
+	{
 		meshes.push_back(bodies.at(i)->getGeometry());
+		textures.push_back(bodies.at(i)->getTexture());
+		lodLevels.push_back(0);
+	}
 
 	transforms.push_back(&starsMatrix);
 	for(unsigned int i = 0; i < bodies.size(); i++)
 		transforms.push_back(bodies.at(i)->getTransformation());
 }
 
-void OrbitalSystem::addBody(OrbitalBody* body)
+BodyHandle OrbitalSystem::addBody(OrbitalBody* body)
 {
-	/* Add the pointer, mesh, and transformation. */
+	/* Reuse a free slot if there is one. */
+	BodyHandle h;
+	if(freeSlot != INVALID_BODY_SLOT)
+	{
+		h.slot   = freeSlot;
+		freeSlot = slots[h.slot].index;
+	}
+	else
+	{
+		h.slot = slots.size();
+		slots.push_back(BodySlot());
+		slots[h.slot].generation = 0;
+	}
+	h.generation = slots[h.slot].generation;
+	slots[h.slot].index = bodies.size();
+
+	/* Add the pointer, mesh, texture, transformation, and handle. */
 	bodies.push_back(body);
 	meshes.push_back(body->getGeometry());
+	textures.push_back(body->getTexture());
+	lodLevels.push_back(0);
 	transforms.push_back(body->getTransformation());
+	handles.push_back(h);
+	names[body->getName()] = h;
+	transformsStale = true;
+	return h;
+}
+
+bool OrbitalSystem::removeBody(const BodyHandle h)
+{
+	if(!isValid(h))
+		return false;
+
+	GLuint       i    = slots[h.slot].index;
+	GLuint       last = bodies.size() - 1;
+	OrbitalBody* body = bodies[i];
+
+	/* Drop the name, unless another body has taken it over since. */
+	std::unordered_map<std::string, BodyHandle>::iterator it =
+		names.find(body->getName());
+	if(it != names.end() && it->second == h)
+		names.erase(it);
+
+	/* Move the last body into the hole, keeping the lists in lockstep. */
+	bodies[i]                       = bodies[last];
+	meshes[FIRST_BODY_SLOT + i]     = meshes[FIRST_BODY_SLOT + last];
+	textures[FIRST_BODY_SLOT + i]   = textures[FIRST_BODY_SLOT + last];
+	lodLevels[FIRST_BODY_SLOT + i]  = lodLevels[FIRST_BODY_SLOT + last];
+	transforms[FIRST_BODY_SLOT + i] = transforms[FIRST_BODY_SLOT + last];
+	handles[i]                      = handles[last];
+	slots[handles[i].slot].index    = i;
+	bodies.pop_back();
+	meshes.pop_back();
+	textures.pop_back();
+	lodLevels.pop_back();
+	transforms.pop_back();
+	handles.pop_back();
+
+	/* Stale the handle and put the slot on the free list. */
+	slots[h.slot].generation++;
+	slots[h.slot].index = freeSlot;
+	freeSlot            = h.slot;
+
+	/* The system owns the body and its trail; the mesh and texture go *
+	 * once no other body uses them.                                   */
+	AssetCache::releaseMesh(body->getGeometry());
+	AssetCache::releaseTexture(body->getTexture());
+	if(body->getTrail() != nullptr)
+	{
+		body->getTrail()->cleanUp();
+		delete body->getTrail();
+		numTrails--;
+	}
+	delete body;
+	transformsStale = true;
+	return true;
 }
 
-void OrbitalSystem::removeBody(const GLuint i)
+bool OrbitalSystem::removeBody(const std::string& name)
 {
-	bodies.erase(bodies.begin() + i);
+	return removeBody(findBody(name));
 }
 
-glm::vec3 OrbitalSystem::gravityVector(OrbitalBody* subject, glm::vec3 position)
+BodyHandle OrbitalSystem::findBody(const std::string& name) const
 {
-	glm::vec3 netGravity(0);
-	glm::vec3 direction(0);
+	std::unordered_map<std::string, BodyHandle>::const_iterator it =
+		names.find(name);
+	return it == names.end() ? INVALID_BODY_HANDLE : it->second;
+}
 
-	/* Calculate attraction to all bodies. */
-	for(OrbitalBody* body : bodies)
-	{
-		/* Do not compare subject with itself. */
-		if(body == subject)
-			continue;
+void OrbitalSystem::reorderBodies()
+{
+	const GLuint n = bodies.size();
 
-		/* Get the displacement vector. */
-		direction = body->getLinearPosition() - position;
+	startWorkers();
 
-		/* Get the magnitude of the displacement vector. */
-		GLfloat radius = glm::length(direction);
-		direction /= radius;
-		
-		/* Get the magnitude of the force of gravity. *
-		 *  -> magnitude = G * m / r^2                */
-		GLfloat magnitude = (G * body->getMass()) / (radius * radius);
-		
-		/* Calculate gravity and apply to body. */
-		netGravity += magnitude * direction;
+	/* Sort the current positions. */
+	glm::vec3* positions = stepArena.allocate<glm::vec3>(n);
+	for(GLuint i = 0; i < n; i++)
+		positions[i] = bodies[i]->getLinearPosition();
+	const GLuint* order = morton.sort(positions, n, pool, &stepArena);
+
+	/* Permute the bodies, their render data, and their handles together. */
+	OrbitalBody** sortedBodies     = stepArena.allocate<OrbitalBody*>(n);
+	Mesh**        sortedMeshes     = stepArena.allocate<Mesh*>(n);
+	GLuint*       sortedTextures   = stepArena.allocate<GLuint>(n);
+	GLuint*       sortedLevels     = stepArena.allocate<GLuint>(n);
+	glm::mat4**   sortedTransforms = stepArena.allocate<glm::mat4*>(n);
+	BodyHandle*   sortedHandles    = stepArena.allocate<BodyHandle>(n);
+	for(GLuint k = 0; k < n; k++)
+	{
+		sortedBodies[k]     = bodies[order[k]];
+		sortedMeshes[k]     = meshes[FIRST_BODY_SLOT + order[k]];
+		sortedTextures[k]   = textures[FIRST_BODY_SLOT + order[k]];
+		sortedLevels[k]     = lodLevels[FIRST_BODY_SLOT + order[k]];
+		sortedTransforms[k] = transforms[FIRST_BODY_SLOT + order[k]];
+		sortedHandles[k]    = handles[order[k]];
+	}
+	for(GLuint k = 0; k < n; k++)
+	{
+		bodies[k]                       = sortedBodies[k];
+		meshes[FIRST_BODY_SLOT + k]     = sortedMeshes[k];
+		textures[FIRST_BODY_SLOT + k]   = sortedTextures[k];
+		lodLevels[FIRST_BODY_SLOT + k]  = sortedLevels[k];
+		transforms[FIRST_BODY_SLOT + k] = sortedTransforms[k];
+		handles[k]                      = sortedHandles[k];
+		slots[handles[k].slot].index    = k;
 	}
-	/* Return gravity vector */
-	return netGravity;
 }
 
-
-glm::vec3 OrbitalSystem::A(OrbitalBody* subject, const glm::vec3 position, float dt)
+void OrbitalSystem::scheduleReorder()
 {
-	/* Calculate the force of gravity the the body's new position. */
-	glm::vec3 netAcceleration = gravityVector(subject, position);
+	/* Not worth it for small systems. */
+	if(bodies.size() < MORTON_MIN_BODIES)
+		return;
 
-	/* Account for thrust and return net Acceleration. */
-	return netAcceleration;
-	//return netAcceleration += dt * subject->getLinearThrust();
+	if(++stepsSinceSort >= sortInterval)
+	{
+		stepsSinceSort = 0;
+		reorderBodies();
+	}
+}
+
+void OrbitalSystem::startWorkers()
+{
+	if(pool == nullptr)
+		pool = new WorkerPool(numWorkers);
+	if(solver == nullptr)
+		solver = new ForceSolver(pool, reductionMode);
 }
 
-void OrbitalSystem::rungeKattaApprx(OrbitalBody* subject, const GLfloat dt)
+void OrbitalSystem::rungeKattaApprx(const GLfloat dt)
 {
-	const GLuint  order      = 4;
-	const GLfloat c          = 1.0f / 6.0f;
+	/* Step size of each stage and its weight in the final average. */
+	static const GLfloat stageStep[]   = { 0.0f, 0.5f, 0.5f, 1.0f };
+	static const GLfloat stageWeight[] = { 1.0f, 2.0f, 2.0f, 1.0f };
+	const GLuint         order         = 4;
+	const GLfloat        c             = 1.0f / 6.0f;
+	const GLuint         n             = bodies.size();
 
-	glm::vec3     k[order];
-	glm::vec3     l[order];
-	glm::vec3     r          = subject->getLinearPosition();
-	glm::vec3     v          = subject->getLinearVelocity();
-			     	  
-	k[0]  = dt * v;
-	l[0]  = dt * A(subject, r, 0);
-	k[1]  = dt * (v + (0.5f * l[0]));
-	l[1]  = dt * A(subject, r + (0.5f * k[0]), (0.5f * dt));
-	k[2]  = dt * (v + (0.5f * l[1]));
-	l[2]  = dt * A(subject, r + (0.5f * k[1]), (0.5f * dt));
-	k[3]  = dt * (v + l[2]);
-	l[3]  = dt * A(subject, r + k[2], dt);
+	if(n == 0)
+		return;
 
-	r += c * (k[0] + k[1] + k[2] + k[3]);
-	v += c * (l[0] + l[1] + l[2] + l[3]);
+	/* Start the force pass on the first step. */
+	startWorkers();
+	GLuint64 heapBefore   = Memory::getHeapAllocations();
+	GLuint64 workerBefore = pool->getHeapAllocations();
 
-	subject->setLinearPosition(r);
-	subject->setLinearVelocity(v);
-	subject->setGravityVector(gravityVector(subject, r));
-	subject->setAngularPosition(subject->getAngularPosition() + subject->getAngularVelocity() * dt);
-	subject->snapshotMatrix();
+	/* Scratch space for the step, dropped when the step is done. */
+	glm::vec3* stepPositions   = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* stepVelocities  = stepArena.allocate<glm::vec3>(n);
+	GLfloat*   stepMasses      = stepArena.allocate<GLfloat>(n);
+	glm::vec3* stagePositions  = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* stageVelocities = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* stageAccels     = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* stageK          = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* stageL          = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* sumK            = stepArena.allocate<glm::vec3>(n);
+	glm::vec3* sumL            = stepArena.allocate<glm::vec3>(n);
+
+	/* Gather the state of every body. */
+	for(GLuint i = 0; i < n; i++)
+	{
+		stepPositions[i]  = bodies[i]->getLinearPosition();
+		stepVelocities[i] = bodies[i]->getLinearVelocity();
+		stepMasses[i]     = bodies[i]->getMass();
+		sumK[i]           = glm::vec3(0);
+		sumL[i]           = glm::vec3(0);
+	}
+
+	/* Every stage moves all bodies at once, so each pass sees a consistent *
+	 * snapshot of the system no matter how it is split across threads.     */
+	for(GLuint s = 0; s < order; s++)
+	{
+		for(GLuint i = 0; i < n; i++)
+		{
+			stagePositions[i]  = stepPositions[i];
+			stageVelocities[i] = stepVelocities[i];
+			if(s > 0)
+			{
+				stagePositions[i]  += stageStep[s] * stageK[i];
+				stageVelocities[i] += stageStep[s] * stageL[i];
+			}
+		}
+
+		solver->accelerations(stagePositions, stepMasses, n, G, stageAccels);
+
+		for(GLuint i = 0; i < n; i++)
+		{
+			stageK[i]  = dt * stageVelocities[i];
+			stageL[i]  = dt * stageAccels[i];
+			sumK[i]   += stageWeight[s] * stageK[i];
+			sumL[i]   += stageWeight[s] * stageL[i];
+		}
+
+		/* Gravity felt at the start of the step. */
+		if(s == 0)
+			for(GLuint i = 0; i < n; i++)
+				bodies[i]->setGravityVector(stageAccels[i]);
+	}
+
+	/* Scatter the new state back to the bodies. */
+	for(GLuint i = 0; i < n; i++)
+	{
+		OrbitalBody* subject = bodies[i];
+		subject->setLinearPosition(stepPositions[i] + c * sumK[i]);
+		subject->setLinearVelocity(stepVelocities[i] + c * sumL[i]);
+		subject->setAngularPosition(subject->getAngularPosition() + subject->getAngularVelocity() * dt);
+	}
+	transformsStale = true;
+	record();
+
+	scheduleReorder();
+	stepArena.reset();
+
+	/* Count the steps which still went to the heap (the first one always *
+	 * does, while the arena and the force pass size themselves), on this *
+	 * thread and on the pool's workers.                                  */
+	GLuint64 workerAllocations = pool->getHeapAllocations() - workerBefore;
+	GLuint64 allocations       = Memory::getHeapAllocations() - heapBefore +
+	                             workerAllocations;
+	if(numSteps++ > 0 && allocations > 0)
+	{
+		heapSteps++;
+		heapAllocations       += allocations;
+		workerHeapAllocations += workerAllocations;
+	}
 }
 
 /* Delta t is in real-time seconds. */
@@ -115,108 +314,559 @@ void OrbitalSystem::interpolate(GLfloat realSeconds)
 	clock += dt;
 
 	/* Use Runge-Katta approximation to update the state vectors. */
-	for(OrbitalBody* subject : bodies) 
-		rungeKattaApprx(subject, dt);
-	
+	rungeKattaApprx(dt);
+}
+
+void OrbitalSystem::snapshotTransforms(bool withParticles)
+{
+	const GLuint n = bodies.size();
+
+	/* Nothing moved since the last frame. */
+	if(!transformsStale)
+		return;
+
+	/* Spin angles of every body first, in one tight loop. */
+	GLfloat* cosines = stepArena.allocate<GLfloat>(n);
+	GLfloat* sines   = stepArena.allocate<GLfloat>(n);
+	for(GLuint i = 0; i < n; i++)
+		cosines[i] = bodies[i]->getAngularPosition();
+	for(GLuint i = 0; i < n; i++)
+	{
+		sines[i]   = sin(cosines[i]);
+		cosines[i] = cos(cosines[i]);
+	}
+
+	/* Then the matrices themselves. */
+	for(GLuint i = 0; i < n; i++)
+		bodies[i]->snapshotMatrix(cosines[i], sines[i]);
+
+	/* The same positions for the particle path, with the radius drawn. */
+	particles.resize(n);
+	for(GLuint i = 0; i < n; i++)
+	{
+		glm::vec3 scale = bodies[i]->getScale();
+		particles[i] = glm::vec4(bodies[i]->getLinearPosition(),
+			std::max(scale.x, std::max(scale.y, scale.z)));
+	}
+
+	/* One trail point per frame, for the bodies with a trail (the draw *
+	 * list keeps its capacity). Particles are drawn without trails.     */
+	trails.clear();
+	for(GLuint i = 0; i < n && !withParticles; i++)
+	{
+		if(bodies[i]->getTrail() == nullptr)
+		{
+			if(numTrails >= maxTrails)
+				continue;
+			bodies[i]->setTrail(new Trail());
+			numTrails++;
+		}
+		bodies[i]->getTrail()->sample(bodies[i]->getLinearPosition());
+		trails.push_back(bodies[i]->getTrail());
+	}
+
+	stepArena.reset();
+	transformsStale = false;
+}
+
+/* Views of the draw lists, which stay valid until the bodies change. */
+RenderList OrbitalSystem::getRenderList(bool withParticles)
+{
+	RenderList list;
+	list.meshes               = meshes;
+	list.textures             = textures;
+	list.modelToWorldMatrices = transforms;
+	list.lodLevels            = lodLevels;
+	if(withParticles)
+		list.particles        = particles;
+	else
+		list.trails           = trails;
+	return list;
 }
 
-OrbitalSystem OrbitalSystem::loadFile(const char* xmlFile)
+void OrbitalSystem::record()
 {
+	if(recorder == nullptr || numSteps % recordInterval != 0)
+		return;
+
+	const GLuint     n     = bodies.size();
+	TrajectoryFrame* frame = recorder->beginFrame(clock, n);
+	if(frame == nullptr)
+		return;
+
+	for(GLuint i = 0; i < n; i++)
+	{
+		frame->ids[i]         = handles[i].slot;
+		frame->generations[i] = handles[i].generation;
+		frame->positions[i]   = bodies[i]->getLinearPosition();
+		frame->velocities[i]  = bodies[i]->getLinearVelocity();
+	}
+	recorder->commitFrame(frame);
+}
+
+void OrbitalSystem::setRecorder(TrajectoryRecorder* r, GLuint everyK)
+{
+	recorder       = r;
+	recordInterval = glm::max(everyK, 1u);
+}
+
+void OrbitalSystem::setReductionMode(ReductionMode m)
+{
+	reductionMode = m;
+	if(solver != nullptr)
+		solver->setMode(m);
+}
+
+void OrbitalSystem::setNumWorkers(GLuint n)
+{
+	/* The pool is sized on construction, so start a new one next step. */
+	numWorkers = n;
+	delete solver;
+	delete pool;
+	solver = nullptr;
+	pool   = nullptr;
+}
+
+void OrbitalSystem::printStats() const
+{
+	if(solver == nullptr || solver->getNumPasses() == 0)
+		return;
+
+	fprintf(stdout, "Stats: %llu force passes, %.4f ms/pass (%s, %u workers)\n",
+		(unsigned long long) solver->getNumPasses(),
+		1000.0 * solver->getPassSeconds() / solver->getNumPasses(),
+		solver->getMode() == ReductionMode::DETERMINISTIC ? "deterministic" : "fast",
+		solver->getNumWorkers());
+	fprintf(stdout, "Heap: %llu of %llu steps allocated (%llu allocations, "
+		"%llu on workers), %.2f MB step arena\n",
+		(unsigned long long) heapSteps, (unsigned long long) numSteps,
+		(unsigned long long) heapAllocations,
+		(unsigned long long) workerHeapAllocations,
+		stepArena.getCapacity() / (1024.0 * 1024.0));
+
+	if(recorder != nullptr && recorder->getNumFrames() > 0)
+		fprintf(stdout, "Recorder: %llu frames (%llu dropped), %.4f ms/frame "
+			"on the simulation thread\n",
+			(unsigned long long) recorder->getNumFrames(),
+			(unsigned long long) recorder->getNumDropped(),
+			1000.0 * recorder->getRecordSeconds() / recorder->getNumFrames());
+}
+
+OrbitalSystem OrbitalSystem::loadFile(const char* xmlFile, AssetLoader* loader)
+{
+	/* Scenes converted with --convert are mapped instead of parsed. */
+	if(SceneFile::isSceneFile(xmlFile))
+		return loadScene(xmlFile, loader);
+
 	//OrbitalSystem newSystem("res/meshes/body.obj", "res/textures/milkyway.jpg", 1.000e5f);
 	OrbitalSystem newSystem;
 
-	if(true) {
-		tinyxml2::XMLDocument doc;
-		if(!doc.LoadFile(xmlFile)) 
-		{
-			/* Get the root, background, and bodies elements of the document. */
-			tinyxml2::XMLElement* root   = doc.RootElement();
-			tinyxml2::XMLElement* background = root->FirstChildElement("background");
-			tinyxml2::XMLElement* bodies = root->FirstChildElement("bodies");
-
-			/* Parse the root parameters of the system. */
-			const char* g_str          = root->FirstChildElement("g")->GetText();
-			GLfloat     g_float        = (GLfloat) atof(g_str);
-			const char* scale_str      = root->FirstChildElement("scale")->GetText();
-			GLfloat     scale_float    = (GLfloat) atof(scale_str);
-
-			/* Set the root parameters of the system. */
-			newSystem.scale            = scale_float;
-			newSystem.G                = g_float / scale_float;
-
-			/* Parse the background parameters of the system. */
-			const char* bgMeshFile_str = background->FirstChildElement("meshFile")->GetText();
-			const char* bgTextFile_str = background->FirstChildElement("textureFile")->GetText();
-			const char* bgRadius_str   = background->FirstChildElement("radius")->GetText();
-			GLfloat     bgRadius_float = (GLfloat) atof(bgRadius_str);
-			const char* bgTilt_str     = background->FirstChildElement("tilt")->GetText();
-			GLfloat     bgTilt_float   = (GLfloat) atof(bgTilt_str);
-
-			/* Set the background parameters of the system. */
-			newSystem.stars = Geometry::loadObj(bgMeshFile_str, bgTextFile_str);
-			Vertex* vertices = newSystem.stars->getVertices();
-			for(unsigned int i = 0; i < newSystem.stars->getNumVertices(); i++)
-				vertices[i].normal = glm::vec3(0.0f, -1.0f, 0.0f);//glm::normalize(vertices[i].position);
-			newSystem.meshes.push_back(newSystem.stars);
-			glm::mat4 starsMatrix = glm::scale(glm::mat4(), glm::vec3(bgRadius_float));
-			newSystem.starsMatrix = glm::rotate(starsMatrix, bgTilt_float, DEFAULT_TILT_AXIS);
-			newSystem.transforms.push_back(&newSystem.starsMatrix);
-		
-			/* Parse each body of the system. */
-			for(tinyxml2::XMLElement* body = bodies->FirstChildElement("body"); body != NULL; body = body->NextSiblingElement("body"))
-			{
-				/* Parse the body parameters for each body. */
-				const char* bodyName_str       = body->FirstChildElement("name")->GetText();
-				const char* bodyMass_str       = body->FirstChildElement("mass")->GetText();
-				GLfloat     bodyMass_float     = (GLfloat) atof(bodyMass_str);
-				const char* bodyRadius_str     = body->FirstChildElement("radius")->GetText();
-				GLfloat     bodyRadius_float   = (GLfloat) atof(bodyRadius_str);
-				const char* bodyMeshFile_str   = body->FirstChildElement("meshFile")->GetText();
-				const char* bodyTextFile_str   = body->FirstChildElement("textureFile")->GetText();
-				const char* bodyPosX_str       = body->FirstChildElement("position")->FirstChildElement("x")->GetText();
-				GLfloat     bodyPosX_float     = (GLfloat) atof(bodyPosX_str);  
-				const char* bodyPosY_str       = body->FirstChildElement("position")->FirstChildElement("y")->GetText();
-				GLfloat     bodyPosY_float     = (GLfloat) atof(bodyPosY_str);  
-				const char* bodyPosZ_str       = body->FirstChildElement("position")->FirstChildElement("z")->GetText();
-				GLfloat     bodyPosZ_float     = (GLfloat) atof(bodyPosZ_str);  
-				const char* bodyVelX_str       = body->FirstChildElement("velocity")->FirstChildElement("x")->GetText();
-				GLfloat     bodyVelX_float     = (GLfloat) atof(bodyVelX_str);  
-				const char* bodyVelY_str       = body->FirstChildElement("velocity")->FirstChildElement("y")->GetText();
-				GLfloat     bodyVelY_float     = (GLfloat) atof(bodyVelY_str);  
-				const char* bodyVelZ_str       = body->FirstChildElement("velocity")->FirstChildElement("z")->GetText();
-				GLfloat     bodyVelZ_float     = (GLfloat) atof(bodyVelZ_str);  
-				const char* bodyTilt_str       = body->FirstChildElement("tilt")->GetText();
-				GLfloat     bodyTilt_float     = (GLfloat) atof(bodyTilt_str);  
-				const char* bodyRotSpeed_str   = body->FirstChildElement("rotationalSpeed")->GetText();
-				GLfloat     bodyRotSpeed_float = (GLfloat) atof(bodyRotSpeed_str);
-
-				/* Set the body parameters for each body, and add the body to the system. */
-				glm::vec3   bodyPos_vec{bodyPosX_float, bodyPosY_float, bodyPosZ_float};
-				glm::vec3   bodyVel_vec{bodyVelX_float, bodyVelY_float, bodyVelZ_float};
-				Planet*     newBody = new Planet(bodyName_str,
-				                                 bodyMass_float/ scale_float, 
-				                                 bodyRadius_float/ scale_float,
-				                                 bodyMeshFile_str, 
-				                                 bodyTextFile_str, 
-				                                 bodyPos_vec/ scale_float, 
-				                                 bodyVel_vec/ sqrt(scale_float));
-
-				newBody->setRotationalAxis(bodyTilt_float);
-				newBody->setAngularVelocity(bodyRotSpeed_float);
-
-				newSystem.addBody(newBody);
-			}
+	/* Read the whole file in one pass, without building a document. */
+	SystemDescription system;
+	if(!SystemFile::parse(xmlFile, &system))
+		return newSystem;
 
+	/* Decode every asset in parallel before the bodies ask for them. */
+	if(loader != nullptr)
+	{
+		loader->requestMesh(system.getString(system.starsMeshFile));
+		loader->requestTexture(system.getString(system.starsTextureFile));
+		for(const BodyDescription& body : system.bodies)
+		{
+			loader->requestMesh(system.getString(body.meshFile));
+			loader->requestTexture(system.getString(body.textureFile));
 		}
+		loader->load();
 	}
+
+	/* Set the root and background parameters of the system. */
+	const GLuint n = system.bodies.size();
+	newSystem.setUp(system.g, system.scale,
+	                system.getString(system.starsMeshFile),
+	                system.getString(system.starsTextureFile),
+	                system.starsRadius, system.starsTilt, n);
+
+	/* Set the body parameters for each body, and add the body to the system. */
+	for(const BodyDescription& body : system.bodies)
+		newSystem.addPlanet(system.getString(body.name), body.mass, body.radius,
+		                    system.getString(body.meshFile),
+		                    system.getString(body.textureFile),
+		                    body.position, body.velocity, body.tilt, body.rotationalSpeed);
+	if(loader != nullptr)
+		loader->release();
+
 	/* Return the system. */
 	return newSystem;
 }
 
+OrbitalSystem OrbitalSystem::loadScene(const char* sceneFile, AssetLoader* loader)
+{
+	OrbitalSystem newSystem;
+
+	/* Map the scene; its columns are read in place. */
+	SceneFile scene;
+	if(!scene.open(sceneFile))
+		return newSystem;
+
+	/* Decode every asset in parallel before the bodies ask for them. The   *
+	 * string table is deduplicated, so runs of one file share an offset. */
+	const SceneHeader* header       = scene.getHeader();
+	const GLuint       n            = scene.getNumBodies();
+	const GLuint*      meshFiles    = scene.getMeshFiles();
+	const GLuint*      textureFiles = scene.getTextureFiles();
+	if(loader != nullptr)
+	{
+		loader->requestMesh(scene.getString(header->starsMeshFile));
+		loader->requestTexture(scene.getString(header->starsTextureFile));
+		for(GLuint i = 0; i < n; i++)
+		{
+			if(i == 0 || meshFiles[i] != meshFiles[i - 1])
+				loader->requestMesh(scene.getString(meshFiles[i]));
+			if(i == 0 || textureFiles[i] != textureFiles[i - 1])
+				loader->requestTexture(scene.getString(textureFiles[i]));
+		}
+		loader->load();
+	}
+
+	/* Set the root and background parameters of the system. */
+	newSystem.setUp(header->g, header->scale,
+	                scene.getString(header->starsMeshFile),
+	                scene.getString(header->starsTextureFile),
+	                header->starsRadius, header->starsTilt, n);
+
+	/* Add the bodies straight from the columns. */
+	const GLfloat*   masses       = scene.getMasses();
+	const GLfloat*   radii        = scene.getRadii();
+	const glm::vec3* positions    = scene.getPositions();
+	const glm::vec3* velocities   = scene.getVelocities();
+	const GLfloat*   tilts        = scene.getTilts();
+	const GLfloat*   speeds       = scene.getRotationalSpeeds();
+	const GLuint*    names        = scene.getNames();
+	for(GLuint i = 0; i < n; i++)
+		newSystem.addPlanet(scene.getString(names[i]), masses[i], radii[i],
+		                    scene.getString(meshFiles[i]),
+		                    scene.getString(textureFiles[i]),
+		                    positions[i], velocities[i], tilts[i], speeds[i]);
+	if(loader != nullptr)
+		loader->release();
+	return newSystem;
+}
+
+void OrbitalSystem::setUp(GLfloat g, GLfloat scale, const char* starsMeshFile,
+	const char* starsTextureFile, GLfloat starsRadius, GLfloat starsTilt, GLuint numBodies)
+{
+	/* Set the root parameters of the system. */
+	this->scale = scale;
+	this->G     = g / scale;
+
+	/* Set the background parameters of the system. */
+	loadStars(starsMeshFile, starsTextureFile);
+	glm::mat4 matrix = glm::scale(glm::mat4(), glm::vec3(starsRadius));
+	starsMatrix      = glm::rotate(matrix, starsTilt, DEFAULT_TILT_AXIS);
+	transforms.push_back(&starsMatrix);
+
+	/* Make room for every body at once. */
+	bodies.reserve(numBodies);
+	meshes.reserve(FIRST_BODY_SLOT + numBodies);
+	textures.reserve(FIRST_BODY_SLOT + numBodies);
+	lodLevels.reserve(FIRST_BODY_SLOT + numBodies);
+	transforms.reserve(FIRST_BODY_SLOT + numBodies);
+	handles.reserve(numBodies);
+	slots.reserve(numBodies);
+	names.reserve(numBodies);
+}
+
+void OrbitalSystem::addPlanet(const char* name, GLfloat mass, GLfloat radius,
+	const char* meshFile, const char* textureFile, const glm::vec3& position,
+	const glm::vec3& velocity, GLfloat tilt, GLfloat rotationalSpeed)
+{
+	/* Convert from the units of the file to those of the system. */
+	Planet* newBody = new Planet(name,
+	                             mass/ scale,
+	                             radius/ scale,
+	                             meshFile,
+	                             textureFile,
+	                             position/ scale,
+	                             velocity/ sqrt(scale));
+
+	newBody->setRotationalAxis(tilt);
+	newBody->setAngularVelocity(rotationalSpeed);
+
+	addBody(newBody);
+}
+
+void OrbitalSystem::loadStars(const char* meshFile, const char* textureFile)
+{
+	stars        = AssetCache::acquireMesh(meshFile);
+	starsTexture = AssetCache::acquireTexture(textureFile);
+	meshes.push_back(stars);
+	textures.push_back(starsTexture);
+	lodLevels.push_back(0);
+	starsMeshFile    = meshFile;
+	starsTextureFile = textureFile;
+}
+
+/* Round up to the alignment of the sections of a checkpoint. */
+static GLuint64 alignCheckpoint(GLuint64 offset)
+{
+	return (offset + CHECKPOINT_ALIGNMENT - 1) & ~(GLuint64) (CHECKPOINT_ALIGNMENT - 1);
+}
+
+/* Copy a string into the string table of a checkpoint, returning its offset. */
+static GLuint putCheckpointString(char* strings, GLuint& used, const std::string& s)
+{
+	GLuint offset = used;
+	memcpy(strings + used, s.c_str(), s.size() + 1);
+	used += s.size() + 1;
+	return offset;
+}
+
+/* Check that the records and slot table of a checkpoint point at strings,   *
+ * slots and bodies which exist, and agree with each other: every body's slot *
+ * leads back to it, and the free list covers the other slots.               */
+static bool validCheckpoint(const CheckpointHeader* header,
+	const CheckpointBody* records, const CheckpointSlot* table)
+{
+	const GLuint64 bytes = header->stringsBytes;
+	if(header->starsMeshFile >= bytes || header->starsTextureFile >= bytes)
+		return false;
+
+	std::vector<bool> used(header->numSlots, false);
+	for(GLuint i = 0; i < header->numBodies; i++)
+	{
+		const CheckpointBody& r = records[i];
+		if(r.name >= bytes || r.meshFile >= bytes || r.textureFile >= bytes ||
+		   r.slot >= header->numSlots || used[r.slot] ||
+		   table[r.slot].index != i || table[r.slot].generation != r.generation)
+			return false;
+		used[r.slot] = true;
+	}
+
+	/* The free list must end, and hold exactly the unused slots. */
+	GLuint numFree = 0;
+	for(GLuint s = header->freeSlot; s != INVALID_BODY_SLOT; s = table[s].index)
+	{
+		if(s >= header->numSlots || used[s])
+			return false;
+		used[s] = true;
+		numFree++;
+	}
+	return (GLuint64) header->numBodies + numFree == header->numSlots;
+}
+
+bool OrbitalSystem::saveCheckpoint(CheckpointWriter* writer, const char* path) const
+{
+	std::vector<unsigned char>* buffer = writer->acquire();
+	if(buffer == nullptr)
+		return false;
+
+	/* Lay out the file. */
+	const GLuint n            = bodies.size();
+	GLuint64     stringsBytes = starsMeshFile.size() + starsTextureFile.size() + 2;
+	for(OrbitalBody* b : bodies)
+		stringsBytes += b->getName().size() + b->getMeshFile().size()
+		              + b->getTextureFile().size() + 3;
+
+	CheckpointHeader header = CheckpointHeader();
+	header.magic         = CHECKPOINT_MAGIC;
+	header.version       = CHECKPOINT_VERSION;
+	header.bodiesOffset  = alignCheckpoint(sizeof(CheckpointHeader));
+	header.slotsOffset   = alignCheckpoint(header.bodiesOffset + (GLuint64) n * sizeof(CheckpointBody));
+	header.stringsOffset = alignCheckpoint(header.slotsOffset + slots.size() * sizeof(CheckpointSlot));
+	header.stringsBytes  = stringsBytes;
+	header.fileBytes     = header.stringsOffset + stringsBytes;
+
+	/* The buffer keeps its capacity between snapshots. */
+	buffer->resize((size_t) header.fileBytes);
+	unsigned char*  data    = buffer->data();
+	memset(data, 0, (size_t) header.fileBytes);
+	CheckpointBody* records = (CheckpointBody*) (data + header.bodiesOffset);
+	CheckpointSlot* table   = (CheckpointSlot*) (data + header.slotsOffset);
+	char*           strings = (char*)           (data + header.stringsOffset);
+	GLuint          used    = 0;
+
+	/* System. */
+	header.clock            = clock;
+	header.G                = G;
+	header.scale            = scale;
+	header.reductionMode    = (GLuint) reductionMode;
+	header.starsMatrix      = starsMatrix;
+	header.starsMeshFile    = putCheckpointString(strings, used, starsMeshFile);
+	header.starsTextureFile = putCheckpointString(strings, used, starsTextureFile);
+	header.sortInterval     = sortInterval;
+	header.stepsSinceSort   = stepsSinceSort;
+	header.numBodies        = n;
+	header.numSlots         = slots.size();
+	header.freeSlot         = freeSlot;
+
+	/* Bodies, in body order, and the slot table. */
+	for(GLuint i = 0; i < n; i++)
+	{
+		bodies[i]->getState(&records[i].state);
+		records[i].slot        = handles[i].slot;
+		records[i].generation  = handles[i].generation;
+		records[i].name        = putCheckpointString(strings, used, bodies[i]->getName());
+		records[i].meshFile    = putCheckpointString(strings, used, bodies[i]->getMeshFile());
+		records[i].textureFile = putCheckpointString(strings, used, bodies[i]->getTextureFile());
+	}
+	for(GLuint i = 0; i < slots.size(); i++)
+	{
+		table[i].index      = slots[i].index;
+		table[i].generation = slots[i].generation;
+	}
+	memcpy(data, &header, sizeof(header));
+
+	writer->submit(path);
+	return true;
+}
+
+OrbitalSystem OrbitalSystem::loadCheckpoint(const char* path, AssetLoader* loader)
+{
+	OrbitalSystem newSystem;
+
+	MappedFile file;
+	if(!file.open(path))
+	{
+		std::cerr << "Checkpoint: could not open " << path << std::endl;
+		return newSystem;
+	}
+
+	/* Check the header and that every section lies inside the file. */
+	const unsigned char*    data   = file.getData();
+	const CheckpointHeader* header = (const CheckpointHeader*) data;
+	if(file.getSize() < sizeof(CheckpointHeader) || header->magic != CHECKPOINT_MAGIC ||
+	   header->version != CHECKPOINT_VERSION || header->fileBytes != file.getSize() ||
+	   header->bodiesOffset + (GLuint64) header->numBodies * sizeof(CheckpointBody) > header->fileBytes ||
+	   header->slotsOffset + (GLuint64) header->numSlots * sizeof(CheckpointSlot) > header->fileBytes ||
+	   header->stringsOffset + header->stringsBytes > header->fileBytes ||
+	   header->stringsBytes == 0 || data[header->fileBytes - 1] != '\0')
+	{
+		std::cerr << "Checkpoint: " << path << " is not a valid checkpoint" << std::endl;
+		return newSystem;
+	}
+	const CheckpointBody* records = (const CheckpointBody*) (data + header->bodiesOffset);
+	const CheckpointSlot* table   = (const CheckpointSlot*) (data + header->slotsOffset);
+	const char*           strings = (const char*)           (data + header->stringsOffset);
+
+	/* Then that everything in them points where it should. */
+	if(!validCheckpoint(header, records, table))
+	{
+		std::cerr << "Checkpoint: " << path << " is not a valid checkpoint" << std::endl;
+		return newSystem;
+	}
+
+	/* Decode every asset in parallel before the bodies ask for them. */
+	if(loader != nullptr)
+	{
+		loader->requestMesh(strings + header->starsMeshFile);
+		loader->requestTexture(strings + header->starsTextureFile);
+		for(GLuint i = 0; i < header->numBodies; i++)
+		{
+			loader->requestMesh(strings + records[i].meshFile);
+			loader->requestTexture(strings + records[i].textureFile);
+		}
+		loader->load();
+	}
+
+	/* System. */
+	newSystem.clock          = header->clock;
+	newSystem.G              = header->G;
+	newSystem.scale          = header->scale;
+	newSystem.reductionMode  = (ReductionMode) header->reductionMode;
+	newSystem.sortInterval   = header->sortInterval;
+	newSystem.stepsSinceSort = header->stepsSinceSort;
+	newSystem.loadStars(strings + header->starsMeshFile, strings + header->starsTextureFile);
+	newSystem.starsMatrix    = header->starsMatrix;
+	newSystem.transforms.push_back(&newSystem.starsMatrix);
+
+	/* Bodies, in the order they were saved in. */
+	const GLuint n = header->numBodies;
+	newSystem.bodies.reserve(n);
+	newSystem.meshes.reserve(FIRST_BODY_SLOT + n);
+	newSystem.textures.reserve(FIRST_BODY_SLOT + n);
+	newSystem.lodLevels.reserve(FIRST_BODY_SLOT + n);
+	newSystem.transforms.reserve(FIRST_BODY_SLOT + n);
+	newSystem.handles.reserve(n);
+	for(GLuint i = 0; i < n; i++)
+	{
+		const BodyState& state   = records[i].state;
+		Planet*          newBody = new Planet(strings + records[i].name,
+		                                      state.mass,
+		                                      state.radius,
+		                                      strings + records[i].meshFile,
+		                                      strings + records[i].textureFile,
+		                                      state.linearPosition,
+		                                      state.linearVelocity);
+		newBody->setState(state);
+		newSystem.addBody(newBody);
+	}
+
+	/* Handles: the saved slot table replaces the one addBody built. */
+	newSystem.slots.resize(header->numSlots);
+	for(GLuint i = 0; i < header->numSlots; i++)
+	{
+		newSystem.slots[i].index      = table[i].index;
+		newSystem.slots[i].generation = table[i].generation;
+	}
+	newSystem.freeSlot = header->freeSlot;
+	newSystem.names.clear();
+	for(GLuint i = 0; i < n; i++)
+	{
+		newSystem.handles[i].slot       = records[i].slot;
+		newSystem.handles[i].generation = records[i].generation;
+		newSystem.names[newSystem.bodies[i]->getName()] = newSystem.handles[i];
+	}
+	if(loader != nullptr)
+		loader->release();
+	return newSystem;
+}
 
 void OrbitalSystem::cleanUp() 
 {
-	stars->cleanUp();
+	/* Drop this system's references; shared assets go with the last one. */
+	AssetCache::releaseMesh(stars);
+	AssetCache::releaseTexture(starsTexture);
+	stars        = nullptr;
+	starsTexture = 0;
 	for(OrbitalBody* body : bodies)
-		body->getGeometry()->cleanUp();
+	{
+		AssetCache::releaseMesh(body->getGeometry());
+		AssetCache::releaseTexture(body->getTexture());
+		body->setGeometry(nullptr);
+		body->setTexture(0);
+		if(body->getTrail() != nullptr)
+		{
+			body->getTrail()->cleanUp();
+			delete body->getTrail();
+			body->setTrail(nullptr);
+		}
+	}
+	trails.clear();
+	numTrails = 0;
+	meshes.clear();
+	textures.clear();
+	lodLevels.clear();
+}
+
+OrbitalSystem::~OrbitalSystem()
+{
+	/* Joins the worker threads. */
+	delete solver;
+	delete pool;
+
+	/* Copies (such as the one a loader returns) release what they retained; *
+	 * a system already cleaned up holds nothing.                            */
+	AssetCache::releaseMesh(stars);
+	AssetCache::releaseTexture(starsTexture);
+	for(OrbitalBody* body : bodies)
+	{
+		AssetCache::releaseMesh(body->getGeometry());
+		AssetCache::releaseTexture(body->getTexture());
+		if(body->getTrail() != nullptr)
+		{
+			body->getTrail()->cleanUp();
+			delete body->getTrail();
+		}
+		delete body;
+	}
 }
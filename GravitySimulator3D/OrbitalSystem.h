@@ -7,17 +7,88 @@
 
 #include  <string>
 #include  <map>
+#include  <unordered_map>
 #include  <vector>
 #include  <glm\glm.hpp>
 #include  <GL\glew.h>
 #include  "OrbitalBody.h"
 #include  "Geometry.h"
+#include  "ForceSolver.h"
+#include  "MortonOrder.h"
+#include  "Memory.h"
+#include  "Trajectory.h"
+#include  "Checkpoint.h"
+#include  "AssetLoader.h"
+#include  "RenderList.h"
 
 #define   SIM_SECONDS_PER_REAL_SECOND                            1.0f
 #define   SECONDS_PER_HOUR                                    3600.0f
 #define   MAX_DELTA_T                                          100.0f                
 #define   DEFAULT_G                                      6.67384e-20f
 #define   DEFAULT_TILT_AXIS            glm::vec3{+1.0f, +0.0f, +0.0f}
+#define   DEFAULT_NUM_WORKERS       (std::thread::hardware_concurrency())
+#define   DEFAULT_REDUCTION_MODE                    ReductionMode::FAST
+#define   INVALID_BODY_SLOT                                  0xffffffff
+/* Slot of the first body in the render lists (slot 0 is the stars). */
+#define   FIRST_BODY_SLOT                                             1
+/* Systems smaller than this are never re-sorted. */
+#define   MORTON_MIN_BODIES                                        1024
+/* Steps between re-sorts. */
+#define   MORTON_SORT_INTERVAL                                      256
+/* Bodies given a trail at most (changed with --trails). */
+#define   MAX_TRAILS                                                 64
+
+/******************************************************************************
+ *																			  *
+ *                             BodyHandle Struct                              *
+ *																			  *
+ ******************************************************************************
+ * MEMBERS                                                                    *
+ *  slot                                                                      *
+ *          Index of the handle's entry in the system's slot table.           *
+ *  generation                                                                *
+ *          Generation of the slot when the handle was issued. A slot's       *
+ *          generation is bumped whenever its body is removed, which turns    *
+ *          every handle still pointing at it stale.                          *
+ *                                                                            *
+ ******************************************************************************
+ * DESCRIPTION                                                                *
+ *  Stable reference to a body of an OrbitalSystem. Unlike a body's position  *
+ *  in the body list, it survives re-sorting and the removal of other bodies. *
+ *                                                                            *
+ ******************************************************************************/
+struct BodyHandle
+{
+	GLuint         slot;
+	GLuint         generation;
+
+	bool operator==(const BodyHandle& rhs) const
+	{  return slot == rhs.slot && generation == rhs.generation;  }
+	bool operator!=(const BodyHandle& rhs) const
+	{  return !(*this == rhs);  }
+};
+
+/* Handle which never refers to a body. */
+const BodyHandle  INVALID_BODY_HANDLE = { INVALID_BODY_SLOT, 0 };
+
+/******************************************************************************
+ *																			  *
+ *                              BodySlot Struct                               *
+ *																			  *
+ ******************************************************************************
+ * MEMBERS                                                                    *
+ *  index                                                                     *
+ *          Position of the body in the body list while the slot is in use,   *
+ *          or the next free slot while it is not.                            *
+ *  generation                                                                *
+ *          Number of times the slot has been freed.                          *
+ *                                                                            *
+ ******************************************************************************/
+struct BodySlot
+{
+	GLuint         index;
+	GLuint         generation;
+};
 
 /******************************************************************************
  *																			  *
@@ -31,6 +102,47 @@
  *  radius                                                                    *
  *          METERS                                                            *
  *          Bounding distance from the center of the object to its surface.   *
+ *  solver                                                                    *
+ *          Force pass shared by all stages of the integrator. Created on the *
+ *          first step with numWorkers threads in reductionMode.              *
+ *  bodies / meshes / textures / lodLevels / transforms / handles             *
+ *          Dense lists kept in lockstep: the body at position i owns entry   *
+ *          FIRST_BODY_SLOT + i of the render lists and entry i of handles.   *
+ *          Removal moves the last body into the hole (swap-and-pop), and     *
+ *          bodies are periodically re-sorted along a Morton curve, so        *
+ *          positions change; handles do not. lodLevels holds the level of   *
+ *          detail each body was last drawn at, which Display updates.        *
+ *  slots / freeSlot                                                          *
+ *          Generational slot table mapping each handle to a position, and    *
+ *          the head of the list of unused slots.                             *
+ *  names                                                                     *
+ *          Hash index from body name to handle.                              *
+ *  stepArena                                                                 *
+ *          Integrator stage buffers and re-sort scratch. Everything a step   *
+ *          allocates from it is dropped at the end of the step, so once the  *
+ *          arena has grown to fit one step, steps stop touching the heap.    *
+ *  transformsStale                                                           *
+ *          Set by every step; the transforms are only rebuilt, all at once,  *
+ *          when a frame asks for them with snapshotTransforms().             *
+ *  trails / numTrails / maxTrails                                            *
+ *          Trails drawn this frame, how many bodies have one, and how many   *
+ *          may. A body without one gets one on the first frame it is drawn  *
+ *          in while there is room, keeps it until removed, and gets a new    *
+ *          point on every frame. The cap keeps trails (their points and one  *
+ *          or two draws each) from growing with the system.                  *
+ *  particles                                                                 *
+ *          Position and radius (in w) of every body, in body order, rebuilt  *
+ *          with the transforms for drawing the bodies as particles.          *
+ *  recorder                                                                  *
+ *          Receives the state of every body every recordInterval steps. The  *
+ *          copy is the only work done on the simulation thread; encoding and *
+ *          writing happen on the recorder's own thread.                      *
+ *  sortInterval                                                              *
+ *          Steps between re-sorts. It is fixed rather than paced by step     *
+ *          times: the cost of the direct-sum force pass does not depend on   *
+ *          the body order, so its timings say nothing about when to sort.    *
+ *          Being fixed, the body order (and thus the bits) never depends on *
+ *          timings.                                                          *
  *                                                                            *
  ******************************************************************************
  * DESCRIPTION                                                                *
@@ -48,58 +160,64 @@ public:
 	/* Custom constructor. */
 	OrbitalSystem(const char* objFile,
 		          const char* textureFile,
-				  const GLfloat starsScale) : G(DEFAULT_G), clock(0), scale(1)
+				  const GLfloat starsScale) : G(DEFAULT_G), clock(0), scale(1),
+		freeSlot(INVALID_BODY_SLOT), pool(nullptr), solver(nullptr),
+		numWorkers(DEFAULT_NUM_WORKERS), reductionMode(DEFAULT_REDUCTION_MODE),
+		stepArena(STEP_ARENA_CHUNK_SIZE),
+		numSteps(0), heapSteps(0), heapAllocations(0), workerHeapAllocations(0),
+		transformsStale(true), numTrails(0), maxTrails(MAX_TRAILS),
+		recorder(nullptr), recordInterval(1),
+		sortInterval(MORTON_SORT_INTERVAL), stepsSinceSort(0)
 	{
 		/* Initialize the stars. */
-		stars = Geometry::loadObj(objFile, textureFile);
-		Vertex* vertices = stars->getVertices();
-		for(unsigned int i = 0; i < stars->getNumVertices(); i++)
-		{
-			std::cout << "Old normal: {" 
-					  << vertices[i].normal.x << ", "
-					  << vertices[i].normal.y << ", "
-					  << vertices[i].normal.z << "} ";
-			vertices[i].normal = -glm::normalize(vertices[i].position);
-			std::cout << "New normal: {" 
-					  << vertices[i].normal.x << ", "
-					  << vertices[i].normal.y << ", "
-					  << vertices[i].normal.z << "} "
-					  << std::endl;
-		}
-
-		meshes.push_back(stars);
+		loadStars(objFile, textureFile);
 		starsMatrix = glm::scale(glm::mat4(), glm::vec3(starsScale));
 		transforms.push_back(&starsMatrix);
 	}
 
 	OrbitalSystem(const OrbitalSystem& rhs);
 
-	/* Load an orbital system from a file. */
-	static OrbitalSystem      loadFile         (const char*        xmlFile    );
+	/* Load an orbital system from a system file or a scene. With a loader, *
+	 * the assets of the bodies are loaded in parallel before the bodies.   */
+	static OrbitalSystem      loadFile         (const char*        xmlFile,
+	                                            AssetLoader*       loader = nullptr);
+	/* Load an orbital system from a binary scene (see SceneFile.h). */
+	static OrbitalSystem      loadScene        (const char*        sceneFile,
+	                                            AssetLoader*       loader = nullptr);
+	/* Restore an orbital system from a checkpoint. */
+	static OrbitalSystem      loadCheckpoint   (const char*        path,
+	                                            AssetLoader*       loader = nullptr);
 
-	/* Add a body to the system. */
-	void                      addBody          (      OrbitalBody* body       );
+	/* Snapshot the system to path in the background (false if skipped). */
+	bool                      saveCheckpoint   (CheckpointWriter*  writer,
+	                                            const char*        path       ) const;
+
+	/* Add a body to the system (which takes ownership of it). */
+	BodyHandle                addBody          (      OrbitalBody* body       );
 	
-	/* Remove a body from the system given its name. */
-	void                      removeBody       (const GLuint       i          );
+	/* Remove a body from the system given its handle or its name. */
+	bool                      removeBody       (const BodyHandle   h          );
+	bool                      removeBody       (const std::string& name       );
+
+	/* Find the handle of a body given its name. */
+	BodyHandle                findBody         (const std::string& name       ) const;
+
+	/* Sort the bodies along a Morton curve. */
+	void                      reorderBodies    (                              );
 	
-	/* Adjust the gravity vector for each body in the system. */
-	void                      compute          (                              );
 	/* Update the system by incrementing the time until seconds have passed. */
 	void                      interpolate      (const GLfloat      seconds    );
-	
-	/* Calculate the gravitational forces felt by each body. */
-	glm::vec3                 gravityVector    (      OrbitalBody* subject,      
-	                                                  glm::vec3    position  );
-
-
-	glm::vec3                 A                (      OrbitalBody* subject, 
-	                                            const glm::vec3    position, 
-	                                            const GLfloat      dt         );
+	/* Bring the transforms up to date with the bodies (before drawing), *
+	 * sampling the trails unless the bodies are drawn as particles.     */
+	void                      snapshotTransforms(     bool         withParticles);
+	/* Everything to draw this frame, with the bodies as particles or not. */
+	RenderList                getRenderList    (      bool         withParticles);
 	
 	/* Approximation of the change in variables using Runge-Katta method. */
-	void                      rungeKattaApprx  (      OrbitalBody* subject, 
-	                                            const GLfloat      t          );
+	void                      rungeKattaApprx  (const GLfloat      dt         );
+
+	/* Print the force pass timings to stdout. */
+	void                      printStats       (                              ) const;
 
 	/* Remove all of the allocated space. */
 	void                      cleanUp();
@@ -108,16 +226,72 @@ public:
 	GLfloat                   getG()            const  {  return G;            }
 	GLfloat                   t()               const  {  return clock;        }
 	OrbitalBody*              getBody(GLuint i)        {  return bodies.at(i); }
-	std::vector<Mesh*>        getMeshes()       const  {  return meshes;       }
-	std::vector<glm::mat4*>   getTransforms()   const  {  return transforms;   }
+	OrbitalBody*              getBody(BodyHandle h)    {  return isValid(h) ? bodies[slots[h.slot].index] : nullptr; }
+	BodyHandle                getHandle(GLuint i) const {  return handles.at(i); }
+	bool                      isValid(BodyHandle h) const
+	{
+		return h.slot < slots.size() && slots[h.slot].generation == h.generation;
+	}
+	GLuint                    getNumBodies()    const  {  return bodies.size(); }
+	const std::vector<Mesh*>& getMeshes()       const  {  return meshes;       }
+	const std::vector<GLuint>& getTextures()    const  {  return textures;     }
+	std::vector<GLuint>&      getLodLevels()           {  return lodLevels;    }
+	const std::vector<glm::vec4>& getParticles() const {  return particles;    }
+	const std::vector<glm::mat4*>& getTransforms() const {  return transforms; }
+	const std::vector<Trail*>& getTrails()      const  {  return trails;       }
 	glm::mat4                 getStarsMatrix()  const  {  return starsMatrix;  }
 	Mesh*                     getStars()        const  {  return stars;        }
+	ForceSolver*              getForceSolver()  const  {  return solver;       }
+
+	/* Setters. */
+	void                      setReductionMode (ReductionMode m);
+	void                      setNumWorkers    (GLuint        n);
+	void                      setRecorder      (TrajectoryRecorder* r,
+	                                            GLuint        everyK = 1);
+	void                      setMaxTrails     (GLuint        n) {  maxTrails = n;  }
+
+	/* Destructor. */
+	                         ~OrbitalSystem();
 
 protected:
 	
 	/* Private default constructor (used for loading xml file).*/
 	OrbitalSystem() :
-	G(0.0f), clock(0), stars(nullptr) {}
+	G(0.0f), clock(0), stars(nullptr), starsTexture(0), freeSlot(INVALID_BODY_SLOT),
+	pool(nullptr), solver(nullptr),
+	numWorkers(DEFAULT_NUM_WORKERS), reductionMode(DEFAULT_REDUCTION_MODE),
+	stepArena(STEP_ARENA_CHUNK_SIZE),
+	numSteps(0), heapSteps(0), heapAllocations(0), workerHeapAllocations(0),
+	transformsStale(true), numTrails(0), maxTrails(MAX_TRAILS),
+	recorder(nullptr), recordInterval(1),
+	sortInterval(MORTON_SORT_INTERVAL), stepsSinceSort(0) {}
+
+	/* Set the parameters and stars of a loaded system, and make room for  *
+	 * its bodies.                                                         */
+	void                      setUp            (GLfloat g, GLfloat scale,
+	                                            const char* starsMeshFile,
+	                                            const char* starsTextureFile,
+	                                            GLfloat starsRadius,
+	                                            GLfloat starsTilt,
+	                                            GLuint numBodies);
+	/* Add a planet given in the units of a system file. */
+	void                      addPlanet        (const char* name, GLfloat mass,
+	                                            GLfloat radius,
+	                                            const char* meshFile,
+	                                            const char* textureFile,
+	                                            const glm::vec3& position,
+	                                            const glm::vec3& velocity,
+	                                            GLfloat tilt,
+	                                            GLfloat rotationalSpeed);
+	/* Load the stars mesh and put it first in the render lists. */
+	void                      loadStars        (const char*        meshFile,
+	                                            const char*        textureFile);
+	/* Start the worker pool and force pass if they are not running. */
+	void                      startWorkers     (                              );
+	/* Re-sort the bodies after a step if they are due. */
+	void                      scheduleReorder  (                              );
+	/* Hand the state of the bodies to the recorder if a frame is due. */
+	void                      record           (                              );
 
 	/* Collection of orbital bodies in this system. */
 	GLfloat                   G;
@@ -125,8 +299,51 @@ protected:
 	GLfloat                   scale;
 	std::vector<OrbitalBody*> bodies;
 	Mesh*                     stars;
+	GLuint                    starsTexture;
 	glm::mat4                 starsMatrix;
+	std::string               starsMeshFile;
+	std::string               starsTextureFile;
 	std::vector<Mesh*>        meshes;
+	std::vector<GLuint>       textures;
+	std::vector<GLuint>       lodLevels;
 	std::vector<glm::mat4*>   transforms;
+	std::vector<glm::vec4>    particles;
+
+	/* Handles of the bodies. */
+	std::vector<BodyHandle>   handles;
+	std::vector<BodySlot>     slots;
+	GLuint                    freeSlot;
+	std::unordered_map<std::string, BodyHandle> names;
+
+	/* Worker threads and force pass, and the settings they are made with. */
+	WorkerPool*               pool;
+	ForceSolver*              solver;
+	GLuint                    numWorkers;
+	ReductionMode             reductionMode;
+
+	/* Scratch space of a step, rewound at the end of every step, and the *
+	 * heap allocations counted during steps after the first one (in all, *
+	 * and those made on the force pass's worker threads).                */
+	Arena                     stepArena;
+	GLuint64                  numSteps;
+	GLuint64                  heapSteps;
+	GLuint64                  heapAllocations;
+	GLuint64                  workerHeapAllocations;
+
+	/* Whether the bodies have moved since the transforms were built. */
+	bool                      transformsStale;
+	/* Trails of the bodies, gathered for drawing by snapshotTransforms. */
+	std::vector<Trail*>       trails;
+	GLuint                    numTrails;
+	GLuint                    maxTrails;
+
+	/* Trajectory output (not owned) and the steps between frames. */
+	TrajectoryRecorder*       recorder;
+	GLuint                    recordInterval;
+
+	/* Morton re-sorting state and scratch space. */
+	MortonOrder               morton;
+	GLuint                    sortInterval;
+	GLuint                    stepsSinceSort;
 };
 
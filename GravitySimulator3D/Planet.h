@@ -2,7 +2,7 @@
 
 #include "OrbitalBody.h"
 #include <GL\glew.h>
-#include "Geometry.h"
+#include "AssetCache.h"
 
 class Planet : public OrbitalBody
 {
@@ -15,8 +15,11 @@ public:
            const glm::vec3   initialPosition,
 		   const glm::vec3   initialVelocity) 
 	{
-		this->geometry       = Geometry::loadObj(objFile, textFile);
+		this->geometry       = AssetCache::acquireMesh(objFile);
+		this->texture        = AssetCache::acquireTexture(textFile);
 		this->name           = std::string(name);
+		this->meshFile       = std::string(objFile);
+		this->textureFile    = std::string(textFile);
 		this->mass           = mass;
 		this->radius         = radius;
 		this->scale          = glm::vec3(1.0f) * radius;
@@ -0,0 +1,82 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <type_traits>
+#include <vector>
+
+class Mesh;
+class Trail;
+
+/******************************************************************************
+*                                                                             *
+*                                Span   (struct)                              *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  data / size                                                                *
+*          First element, and the number of elements, of an array owned by    *
+*          someone else.                                                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  View of a contiguous array, usually a std::vector, passed without copying  *
+*  it. A span of const elements may be made from a const or non-const vector. *
+*  The view is only valid until the vector is resized.                        *
+*                                                                             *
+*******************************************************************************/
+template<typename T>
+struct Span
+{
+	typedef typename std::remove_const<T>::type Element;
+
+	T*             data;
+	GLuint         size;
+
+	Span() : data(nullptr), size(0)                       {}
+	Span(T* data, GLuint size) : data(data), size(size)   {}
+	Span(std::vector<Element>& v) : data(v.data()), size(v.size()) {}
+	Span(const std::vector<Element>& v) : data(v.data()), size(v.size()) {}
+
+	T&             operator[](GLuint i)  const   {  return data[i];        }
+	T*             begin()               const   {  return data;           }
+	T*             end()                 const   {  return data + size;    }
+	bool           empty()               const   {  return size == 0;      }
+};
+
+/******************************************************************************
+*                                                                             *
+*                             RenderList   (struct)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  meshes / textures / modelToWorldMatrices / lodLevels                       *
+*          Mesh, texture (0 for none), model matrix and level of detail of    *
+*          every body, in lockstep. The levels are written back as they are   *
+*          picked, so the next frame starts from them.                        *
+*  trails                                                                     *
+*          Orbit trails, already in world space (empty with particles).       *
+*  particles                                                                  *
+*          Position and radius of every body (empty to draw meshes only).     *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Everything Display::repaint() draws in a frame, as views of the arrays     *
+*  the OrbitalSystem keeps, so nothing is copied or allocated to hand it      *
+*  over.                                                                      *
+*                                                                             *
+*******************************************************************************/
+struct RenderList
+{
+	Span<Mesh* const>             meshes;
+	Span<const GLuint>            textures;
+	Span<glm::mat4* const>        modelToWorldMatrices;
+	Span<GLuint>                  lodLevels;
+	Span<Trail* const>            trails;
+	Span<const glm::vec4>         particles;
+};
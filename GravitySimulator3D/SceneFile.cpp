@@ -0,0 +1,259 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "SceneFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Round up to the alignment of the columns of a scene. */
+static GLuint64 alignScene(GLuint64 offset)
+{
+	return (offset + SCENE_ALIGNMENT - 1) & ~(GLuint64) (SCENE_ALIGNMENT - 1);
+}
+
+/******************************************************************************
+*                                                                             *
+*                         SceneFile::SceneFile (Constructor)                  *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+SceneFile::SceneFile() :
+	header(nullptr)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                            SceneFile::isSceneFile                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           File to be checked.                                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file starts with SCENE_MAGIC (system files start with text).   *
+*                                                                             *
+*******************************************************************************/
+bool SceneFile::isSceneFile(const char* path)
+{
+	FILE*  in    = fopen(path, "rb");
+	GLuint magic = 0;
+	if(in == nullptr)
+		return false;
+	size_t read  = fread(&magic, sizeof(magic), 1, in);
+	fclose(in);
+	return read == 1 && magic == SCENE_MAGIC;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                SceneFile::write                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Scene file to be written.                                         *
+*  @param system                                                              *
+*           System to be written.                                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file was written.                                              *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Transposes the bodies into columns. Strings are looked up in a hash map    *
+*  as they are added, so an asset path shared by every body of a catalogue    *
+*  is stored once.                                                            *
+*                                                                             *
+*******************************************************************************/
+bool SceneFile::write(const char* path, const SystemDescription& system)
+{
+	const GLuint n = system.bodies.size();
+
+	/* String table, each distinct string once. */
+	std::vector<char>                       strings;
+	std::unordered_map<std::string, GLuint> offsets;
+	auto addString = [&](GLuint offset) -> GLuint
+	{
+		std::string s(system.getString(offset));
+		std::unordered_map<std::string, GLuint>::const_iterator it = offsets.find(s);
+		if(it != offsets.end())
+			return it->second;
+		GLuint added = strings.size();
+		strings.insert(strings.end(), s.begin(), s.end());
+		strings.push_back('\0');
+		offsets[s] = added;
+		return added;
+	};
+
+	/* Lay out the file. */
+	SceneHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic                 = SCENE_MAGIC;
+	header.version               = SCENE_VERSION;
+	header.g                     = system.g;
+	header.scale                 = system.scale;
+	header.starsRadius           = system.starsRadius;
+	header.starsTilt             = system.starsTilt;
+	header.starsMeshFile         = addString(system.starsMeshFile);
+	header.starsTextureFile      = addString(system.starsTextureFile);
+	header.numBodies             = n;
+	header.massOffset            = alignScene(sizeof(SceneHeader));
+	header.radiusOffset          = alignScene(header.massOffset            + n * sizeof(GLfloat));
+	header.positionOffset        = alignScene(header.radiusOffset          + n * sizeof(GLfloat));
+	header.velocityOffset        = alignScene(header.positionOffset        + n * sizeof(glm::vec3));
+	header.tiltOffset            = alignScene(header.velocityOffset        + n * sizeof(glm::vec3));
+	header.rotationalSpeedOffset = alignScene(header.tiltOffset            + n * sizeof(GLfloat));
+	header.nameOffset            = alignScene(header.rotationalSpeedOffset + n * sizeof(GLfloat));
+	header.meshFileOffset        = alignScene(header.nameOffset            + n * sizeof(GLuint));
+	header.textureFileOffset     = alignScene(header.meshFileOffset        + n * sizeof(GLuint));
+	header.stringsOffset         = alignScene(header.textureFileOffset     + n * sizeof(GLuint));
+
+	std::vector<unsigned char> data((size_t) header.stringsOffset, 0);
+	GLfloat*   masses           = (GLfloat*)   (data.data() + header.massOffset);
+	GLfloat*   radii            = (GLfloat*)   (data.data() + header.radiusOffset);
+	glm::vec3* positions        = (glm::vec3*) (data.data() + header.positionOffset);
+	glm::vec3* velocities       = (glm::vec3*) (data.data() + header.velocityOffset);
+	GLfloat*   tilts            = (GLfloat*)   (data.data() + header.tiltOffset);
+	GLfloat*   rotationalSpeeds = (GLfloat*)   (data.data() + header.rotationalSpeedOffset);
+	GLuint*    names            = (GLuint*)    (data.data() + header.nameOffset);
+	GLuint*    meshFiles        = (GLuint*)    (data.data() + header.meshFileOffset);
+	GLuint*    textureFiles     = (GLuint*)    (data.data() + header.textureFileOffset);
+	for(GLuint i = 0; i < n; i++)
+	{
+		const BodyDescription& body = system.bodies[i];
+		masses[i]           = body.mass;
+		radii[i]            = body.radius;
+		positions[i]        = body.position;
+		velocities[i]       = body.velocity;
+		tilts[i]            = body.tilt;
+		rotationalSpeeds[i] = body.rotationalSpeed;
+		names[i]            = addString(body.name);
+		meshFiles[i]        = addString(body.meshFile);
+		textureFiles[i]     = addString(body.textureFile);
+	}
+	header.stringsBytes = strings.size();
+	header.fileBytes    = header.stringsOffset + strings.size();
+	memcpy(data.data(), &header, sizeof(header));
+
+	std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write((const char*) data.data(), data.size());
+	out.write(strings.data(), strings.size());
+	out.close();
+	if(!out)
+	{
+		std::cerr << "SceneFile: could not write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                               SceneFile::convert                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param input                                                               *
+*           System file, or CSV catalogue if its name ends in ".csv".         *
+*  @param output                                                              *
+*           Scene file to be written.                                         *
+*  @param systemFile                                                          *
+*           System file whose G, scale, and background a catalogue gets (its  *
+*           bodies are not included).                                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the scene was written.                                             *
+*                                                                             *
+*******************************************************************************/
+bool SceneFile::convert(const char* input, const char* output, const char* systemFile)
+{
+	SystemDescription system;
+	std::string       name(input);
+	bool              csv = name.size() >= 4 && name.compare(name.size() - 4, 4, ".csv") == 0;
+	if(csv)
+	{
+		if(!SystemFile::parse(systemFile, &system))
+			return false;
+		system.bodies.clear();
+		if(!SystemFile::parseCsv(input, &system))
+			return false;
+	}
+	else if(!SystemFile::parse(input, &system))
+		return false;
+
+	if(!write(output, system))
+		return false;
+	fprintf(stdout, "Converted %u bodies from %s to %s\n",
+		(GLuint) system.bodies.size(), input, output);
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                                SceneFile::open                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Scene file to be mapped.                                          *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the scene is mapped and every column lies inside it.               *
+*                                                                             *
+*******************************************************************************/
+bool SceneFile::open(const char* path)
+{
+	close();
+	if(!file.open(path))
+	{
+		std::cerr << "SceneFile: could not open " << path << std::endl;
+		return false;
+	}
+
+	const SceneHeader* h    = (const SceneHeader*) file.getData();
+	const GLuint64     size = file.getSize();
+	const GLuint64     n    = size < sizeof(SceneHeader) ? 0 : h->numBodies;
+	bool valid = size >= sizeof(SceneHeader) && h->magic == SCENE_MAGIC &&
+		h->version == SCENE_VERSION && h->fileBytes == size &&
+		h->massOffset            + n * sizeof(GLfloat)   <= size &&
+		h->radiusOffset          + n * sizeof(GLfloat)   <= size &&
+		h->positionOffset        + n * sizeof(glm::vec3) <= size &&
+		h->velocityOffset        + n * sizeof(glm::vec3) <= size &&
+		h->tiltOffset            + n * sizeof(GLfloat)   <= size &&
+		h->rotationalSpeedOffset + n * sizeof(GLfloat)   <= size &&
+		h->nameOffset            + n * sizeof(GLuint)    <= size &&
+		h->meshFileOffset        + n * sizeof(GLuint)    <= size &&
+		h->textureFileOffset     + n * sizeof(GLuint)    <= size &&
+		h->stringsOffset + h->stringsBytes == size &&
+		h->stringsBytes > 0 && file.getData()[size - 1] == '\0';
+	if(!valid)
+	{
+		std::cerr << "SceneFile: " << path << " is not a valid scene" << std::endl;
+		file.close();
+		return false;
+	}
+
+	header = h;
+	return true;
+}
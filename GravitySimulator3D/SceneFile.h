@@ -0,0 +1,133 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "MappedFile.h"
+#include "SystemFile.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+#define  SCENE_MAGIC                                               0x4e435347
+#define  SCENE_VERSION                                                      1
+/* Alignment of every column of the file. */
+#define  SCENE_ALIGNMENT                                                   16
+
+/******************************************************************************
+*                                                                             *
+*                            SceneHeader   (struct)                           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Start of a binary scene file. The header holds the system parameters (in  *
+*  the units of the system file, like everything else in the scene) and the  *
+*  offset of each body column: numBodies masses, radii, positions,            *
+*  velocities, tilts, rotational speeds, and the string table offsets of the  *
+*  names, mesh files, and texture files. The string table comes last and      *
+*  stores each distinct string once, NUL-terminated. Every column starts on   *
+*  a SCENE_ALIGNMENT boundary, so a mapped scene is read in place.            *
+*                                                                             *
+*******************************************************************************/
+struct SceneHeader
+{
+	GLuint                   magic;
+	GLuint                   version;
+	GLuint64                 fileBytes;
+	/* System. */
+	GLfloat                  g;
+	GLfloat                  scale;
+	GLfloat                  starsRadius;
+	GLfloat                  starsTilt;
+	GLuint                   starsMeshFile;
+	GLuint                   starsTextureFile;
+	GLuint                   numBodies;
+	GLuint                   reserved;
+	/* Offsets of the columns and of the string table. */
+	GLuint64                 massOffset;
+	GLuint64                 radiusOffset;
+	GLuint64                 positionOffset;
+	GLuint64                 velocityOffset;
+	GLuint64                 tiltOffset;
+	GLuint64                 rotationalSpeedOffset;
+	GLuint64                 nameOffset;
+	GLuint64                 meshFileOffset;
+	GLuint64                 textureFileOffset;
+	GLuint64                 stringsOffset;
+	GLuint64                 stringsBytes;
+};
+
+/******************************************************************************
+*                                                                             *
+*                              SceneFile   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  file                                                                       *
+*          Mapping of the scene. Every getter points into it, so they are     *
+*          only valid while the scene is open.                                *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Binary counterpart of a system file. Opening a scene maps it and checks    *
+*  that the header and every column lie inside the file; nothing is parsed    *
+*  or copied, so the time to open one does not depend on its size. write()    *
+*  converts a SystemDescription read from a system file or CSV catalogue.     *
+*                                                                             *
+*******************************************************************************/
+class SceneFile
+{
+public:
+	/* Constructor. */
+	               SceneFile();
+
+	/* Whether path starts with the scene magic number. */
+	static bool    isSceneFile(const char* path);
+	/* Write a system as a scene. */
+	static bool    write(const char* path, const SystemDescription& system);
+	/* Convert a system file or CSV catalogue (see SystemFile) to a scene. */
+	static bool    convert(const char* input, const char* output,
+	                       const char* systemFile);
+
+	/* Map a scene (false, with a message, if it is not a valid one). */
+	bool           open(const char* path);
+	/* Unmap the scene. */
+	void           close()                       {  file.close(); header = nullptr; }
+
+	/* Getters. */
+	const SceneHeader* getHeader()       const   {  return header;         }
+	GLuint         getNumBodies()        const   {  return header->numBodies; }
+	const GLfloat* getMasses()           const   {  return column<GLfloat>(header->massOffset);            }
+	const GLfloat* getRadii()            const   {  return column<GLfloat>(header->radiusOffset);          }
+	const glm::vec3* getPositions()      const   {  return column<glm::vec3>(header->positionOffset);      }
+	const glm::vec3* getVelocities()     const   {  return column<glm::vec3>(header->velocityOffset);      }
+	const GLfloat* getTilts()            const   {  return column<GLfloat>(header->tiltOffset);            }
+	const GLfloat* getRotationalSpeeds() const   {  return column<GLfloat>(header->rotationalSpeedOffset); }
+	const GLuint*  getNames()            const   {  return column<GLuint>(header->nameOffset);             }
+	const GLuint*  getMeshFiles()        const   {  return column<GLuint>(header->meshFileOffset);         }
+	const GLuint*  getTextureFiles()     const   {  return column<GLuint>(header->textureFileOffset);      }
+	const char*    getString(GLuint offset) const
+	{
+		/* The table ends in a NUL, so any offset inside it is safe. */
+		return offset < header->stringsBytes ?
+			(const char*) file.getData() + header->stringsOffset + offset : "";
+	}
+
+private:
+	/* Not copyable (owns the mapping). */
+	               SceneFile(const SceneFile& rhs);
+	SceneFile&     operator=(const SceneFile& rhs);
+
+	/* Column starting at an offset of the file. */
+	template<typename T>
+	const T*       column(GLuint64 offset) const {  return (const T*) (file.getData() + offset); }
+
+	MappedFile               file;
+	const SceneHeader*       header;
+};
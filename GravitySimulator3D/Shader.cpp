@@ -4,6 +4,7 @@
 *                                                                             *
 ******************************************************************************/
 #include "Shader.h"
+#include "AssetPack.h"
 #include <iostream>
 #include <fstream>
 
@@ -68,6 +69,8 @@ Shader::Shader(std::string vertexShaderFilepath,
 	glBindAttribLocation(program, 1, "modelColor");
 	glBindAttribLocation(program, 2, "modelNormal");
 	glBindAttribLocation(program, 3, "modelTexCoord");
+	glBindAttribLocation(program, MODEL_TO_WORLD_ATTRIBUTE, "modelToWorldMatrix");
+	glBindAttribLocation(program, TEXTURE_LAYER_ATTRIBUTE, "textureLayer");
 
 	/* Link the shader objects. */
 	glLinkProgram(program);
@@ -97,11 +100,17 @@ Shader::Shader(std::string vertexShaderFilepath,
 *******************************************************************************
 * DESCRIPTION                                                                 *
 *  This function opens a GLSL source code file and copies the entire contents *
-*  of the file to a string and returns it to the caller.                      *
+*  of the file to a string and returns it to the caller. Sources found in    *
+*  the asset pack are taken from it instead.                                  *
 *                                                                             *
 ******************************************************************************/
 std::string Shader::loadShaderSource(std::string shaderFilepath)
 {
+	/* Use the packed source, if there is one. */
+	const PackEntry* packed = AssetPack::find(PACK_SHADER, shaderFilepath.c_str());
+	if(packed != nullptr)
+		return AssetPack::getSource(packed);
+
 	/* Declare the input file and output string. */
 	std::ifstream file;
 	std::string output;
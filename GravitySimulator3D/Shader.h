@@ -8,6 +8,18 @@
 #include <string>
 #include <gl\glew.h>
 
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* First of the four attribute locations of a body's model matrix, which is  *
+ * given per instance (see Display::repaint).                                */
+#define  MODEL_TO_WORLD_ATTRIBUTE                                           4
+/* Attribute location of a body's texture layer and the finest level of it   *
+ * uploaded so far, also given per instance.                                 */
+#define  TEXTURE_LAYER_ATTRIBUTE                                            8
+
 /******************************************************************************
 *																			  *
 *								Shader Class 								  *
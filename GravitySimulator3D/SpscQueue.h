@@ -0,0 +1,77 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <atomic>
+
+/******************************************************************************
+*                                                                             *
+*                              SpscQueue   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  items                                                                      *
+*          Ring of Capacity slots (Capacity must be a power of two).          *
+*  head                                                                       *
+*          Number of items ever popped (only written by the consumer).        *
+*  tail                                                                       *
+*          Number of items ever pushed (only written by the producer).        *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Bounded lock-free queue for exactly one producer thread and one consumer   *
+*  thread. Each side only writes its own counter, with a release store which  *
+*  the other side reads with an acquire load, so an item is fully written     *
+*  before it can be seen. Neither side ever blocks: push() fails when the     *
+*  queue is full and pop() fails when it is empty.                            *
+*                                                                             *
+*******************************************************************************/
+template<typename T, GLuint Capacity>
+class SpscQueue
+{
+public:
+	/* Constructor. */
+	               SpscQueue()                   :  head(0), tail(0)       {}
+
+	/* Producer side: add an item (false if the queue is full). */
+	bool push(const T& item)
+	{
+		GLuint t = tail.load(std::memory_order_relaxed);
+		if(t - head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		items[t & (Capacity - 1)] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* Consumer side: take the oldest item (false if the queue is empty). */
+	bool pop(T* item)
+	{
+		GLuint h = head.load(std::memory_order_relaxed);
+		if(h == tail.load(std::memory_order_acquire))
+			return false;
+		*item = items[h & (Capacity - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* Number of items in the queue (exact only on a quiet queue). */
+	GLuint size() const
+	{
+		return tail.load(std::memory_order_acquire) -
+		       head.load(std::memory_order_acquire);
+	}
+
+private:
+	/* Not copyable. */
+	               SpscQueue(const SpscQueue& rhs);
+	SpscQueue&     operator=(const SpscQueue& rhs);
+
+	T                        items[Capacity];
+	std::atomic<GLuint>      head;
+	std::atomic<GLuint>      tail;
+};
@@ -0,0 +1,206 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "StreamBuffer.h"
+#include <algorithm>
+
+/******************************************************************************
+*                                                                             *
+*                        StreamBuffer::StreamBuffer (Constructor)             *
+*                                                                             *
+******************************************************************************/
+StreamBuffer::StreamBuffer(GLenum target) :
+	target(target), bufferID(0), persistent(false), mapped(nullptr), regionBytes(0), region(0),
+	numFrames(0), numStalls(0)
+{
+	for(GLuint r = 0; r < STREAM_BUFFER_FRAMES; r++)
+		fences[r] = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              StreamBuffer::begin                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param bytes                                                               *
+*           Bytes the frame will write.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Where to write them, valid until end().                                    *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Moves on to the next region, waiting only if the card is still drawing    *
+*  from it (three frames behind). A frame larger than the regions makes the   *
+*  buffer again, twice as large, once the card is done with all of it.        *
+*                                                                             *
+*******************************************************************************/
+GLvoid* StreamBuffer::begin(GLsizeiptr bytes)
+{
+	numFrames++;
+	if(bufferID == 0 || bytes > regionBytes)
+		allocate(bytes);
+
+	if(!persistent)
+	{
+		staging.resize((size_t) bytes);
+		return staging.data();
+	}
+
+	region = (region + 1) % STREAM_BUFFER_FRAMES;
+	wait(region);
+	glBindBuffer(target, bufferID);
+	return mapped + region * regionBytes;
+}
+
+/******************************************************************************
+*                                                                             *
+*                               StreamBuffer::end                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Offset of the frame's bytes in the buffer.                                 *
+*                                                                             *
+*******************************************************************************/
+GLintptr StreamBuffer::end()
+{
+	glBindBuffer(target, bufferID);
+	if(persistent)
+		return region * regionBytes;
+
+	glBufferData(target, staging.size(), staging.data(), GL_STREAM_DRAW);
+	return 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              StreamBuffer::fence                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void StreamBuffer::fence()
+{
+	if(!persistent)
+		return;
+	if(fences[region] != 0)
+		glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/******************************************************************************
+*                                                                             *
+*                              StreamBuffer::wait                             *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param r                                                                   *
+*           Region about to be written.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void StreamBuffer::wait(GLuint r)
+{
+	if(fences[r] == 0)
+		return;
+
+	/* Check first without waiting, so only real stalls are counted. */
+	GLenum status = glClientWaitSync(fences[r], 0, 0);
+	if(status == GL_TIMEOUT_EXPIRED)
+	{
+		numStalls++;
+		do
+			status = glClientWaitSync(fences[r], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		while(status == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fences[r]);
+	fences[r] = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                            StreamBuffer::allocate                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param bytes                                                               *
+*           Bytes the regions must hold at least.                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void StreamBuffer::allocate(GLsizeiptr bytes)
+{
+	cleanUp();
+	regionBytes = std::max((GLsizeiptr) STREAM_BUFFER_MIN_BYTES, regionBytes);
+	while(regionBytes < bytes)
+		regionBytes *= 2;
+
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(target, bufferID);
+	persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	if(!persistent)
+		return;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage(target, STREAM_BUFFER_FRAMES * regionBytes, nullptr, flags);
+	mapped = (GLubyte*) glMapBufferRange(target, 0,
+		STREAM_BUFFER_FRAMES * regionBytes, flags);
+	region     = 0;
+	if(mapped != nullptr)
+		return;
+
+	/* Mapping failed: fall back to a plain buffer. */
+	persistent = false;
+	glDeleteBuffers(1, &bufferID);
+	glGenBuffers(1, &bufferID);
+	glBindBuffer(target, bufferID);
+}
+
+/******************************************************************************
+*                                                                             *
+*                             StreamBuffer::cleanUp                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void StreamBuffer::cleanUp()
+{
+	for(GLuint r = 0; r < STREAM_BUFFER_FRAMES; r++)
+		wait(r);
+	if(bufferID == 0)
+		return;
+	if(mapped != nullptr)
+	{
+		glBindBuffer(target, bufferID);
+		glUnmapBuffer(target);
+		mapped = nullptr;
+	}
+	glDeleteBuffers(1, &bufferID);
+	bufferID = 0;
+}
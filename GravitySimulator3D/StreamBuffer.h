@@ -0,0 +1,102 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <vector>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Frames a stream buffer holds at once: the one being written, and those   *
+ * the graphics card may still be drawing from.                             */
+#define  STREAM_BUFFER_FRAMES                                               3
+/* Smallest region of a frame, in bytes. */
+#define  STREAM_BUFFER_MIN_BYTES                                        65536
+
+/******************************************************************************
+*                                                                             *
+*                            StreamBuffer   (class)                           *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  target                                                                     *
+*          Binding point the buffer is used at (GL_ARRAY_BUFFER for vertex    *
+*          data, GL_PIXEL_UNPACK_BUFFER for texture uploads).                 *
+*  bufferID                                                                   *
+*          Buffer of STREAM_BUFFER_FRAMES regions of regionBytes each         *
+*          (0 until the first frame).                                         *
+*  persistent / mapped                                                        *
+*          Whether the buffer has immutable storage mapped for good (OpenGL   *
+*          4.4 or ARB_buffer_storage), and where.                             *
+*  region / fences                                                            *
+*          Region of the current frame, and the fence put after the draws     *
+*          reading each region (0 once it has been waited on).                *
+*  staging                                                                    *
+*          Copy written in place of the mapping without buffer storage.       *
+*  numFrames / numStalls                                                      *
+*          Frames streamed, and those which had to wait for the card to be    *
+*          done with their region.                                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Buffer of per-frame data (instance matrices, particles, texels on their    *
+*  way to a texture) written straight into mapped memory. Each frame writes   *
+*  the next of three regions while the card may still be reading the two      *
+*  before, so neither side waits for the other: a fence after the frame's     *
+*  draws or uploads marks when its region may be written again, which is      *
+*  checked only when the ring comes back round to it.                         *
+*  The mapping is coherent, so nothing is flushed or uploaded.                *
+*                                                                             *
+*  Without buffer storage, the frame is written to a staging copy and sent    *
+*  with glBufferData, orphaning the previous frame's storage.                 *
+*                                                                             *
+*******************************************************************************/
+class StreamBuffer
+{
+public:
+	/* Constructor, for a buffer bound to target when in use. */
+	               StreamBuffer(GLenum target = GL_ARRAY_BUFFER);
+
+	/* Memory to write this frame's bytes to (bound to the target). */
+	GLvoid*        begin(GLsizeiptr bytes);
+	/* Finish writing, leaving the buffer bound. Returns the offset of the  *
+	 * frame's bytes in the buffer.                                         */
+	GLintptr       end();
+	/* Mark the frame's region as in use by the draws issued so far. */
+	void           fence();
+	/* Free the buffer (GL thread, while the context is alive). */
+	void           cleanUp();
+
+	/* Getters. */
+	GLuint         getBufferID()         const   {  return bufferID;       }
+	bool           isPersistent()        const   {  return persistent;     }
+	GLuint64       getNumFrames()        const   {  return numFrames;      }
+	GLuint64       getNumStalls()        const   {  return numStalls;      }
+
+private:
+	/* Not copyable (owns its buffer). */
+	               StreamBuffer(const StreamBuffer& rhs);
+	StreamBuffer&  operator=(const StreamBuffer& rhs);
+
+	/* Wait for the card to be done with a region. */
+	void           wait(GLuint r);
+	/* Make the buffer, with regions of at least bytes. */
+	void           allocate(GLsizeiptr bytes);
+
+	GLenum         target;
+	GLuint         bufferID;
+	bool           persistent;
+	GLubyte*       mapped;
+	GLsizeiptr     regionBytes;
+	GLuint         region;
+	GLsync         fences[STREAM_BUFFER_FRAMES];
+	std::vector<GLubyte> staging;
+	GLuint64       numFrames;
+	GLuint64       numStalls;
+};
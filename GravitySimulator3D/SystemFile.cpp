@@ -0,0 +1,883 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "SystemFile.h"
+#include "FastParse.h"
+#include "MappedFile.h"
+#include "SceneFile.h"
+#include <SDL\SDL.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+
+/******************************************************************************
+*                                                                             *
+*                                      Macros                                 *
+*                                                                             *
+******************************************************************************/
+/* Output buffer of the generator. */
+#define  GENERATE_BUFFER_SIZE                                       (1 << 20)
+/* Generated systems: central star, and the range of the orbit radii. */
+#define  GENERATE_STAR_MASS                                         1.989e30
+#define  GENERATE_MIN_ORBIT                                            1.0e9
+#define  GENERATE_MAX_ORBIT                                            1.0e11
+#define  GENERATE_G                                              6.67384e-11
+
+/******************************************************************************
+*                                                                             *
+*                            SystemElement   (enum)                           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Elements of a system file the parser knows about.                          *
+*                                                                             *
+*******************************************************************************/
+enum class SystemElement
+{
+	UNKNOWN, SYSTEM, G, SCALE, BACKGROUND, BODIES, BODY, NAME, MASS, RADIUS,
+	MESH_FILE, TEXTURE_FILE, POSITION, VELOCITY, X, Y, Z, TILT,
+	ROTATIONAL_SPEED
+};
+
+/******************************************************************************
+*                                                                             *
+*                               CsvField   (enum)                             *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Columns of a CSV catalogue the parser knows about.                         *
+*                                                                             *
+*******************************************************************************/
+enum class CsvField
+{
+	IGNORED, NAME, MASS, RADIUS, MESH_FILE, TEXTURE_FILE, X, Y, Z, VX, VY, VZ,
+	TILT, ROTATIONAL_SPEED
+};
+
+/* Column names, and the field each one stands for. */
+static const struct
+{
+	const char*    name;
+	CsvField       field;
+} CSV_FIELD_NAMES[] =
+{
+	{ "name",            CsvField::NAME             },
+	{ "mass",            CsvField::MASS             },
+	{ "radius",          CsvField::RADIUS           },
+	{ "meshFile",        CsvField::MESH_FILE        },
+	{ "textureFile",     CsvField::TEXTURE_FILE     },
+	{ "x",               CsvField::X                },
+	{ "y",               CsvField::Y                },
+	{ "z",               CsvField::Z                },
+	{ "vx",              CsvField::VX               },
+	{ "vy",              CsvField::VY               },
+	{ "vz",              CsvField::VZ               },
+	{ "tilt",            CsvField::TILT             },
+	{ "rotationalSpeed", CsvField::ROTATIONAL_SPEED }
+};
+
+/* Element names, and the element each one stands for. */
+static const struct
+{
+	const char*    name;
+	size_t         length;
+	SystemElement  element;
+} ELEMENT_NAMES[] =
+{
+	{ "system",          6,  SystemElement::SYSTEM           },
+	{ "g",               1,  SystemElement::G                },
+	{ "scale",           5,  SystemElement::SCALE            },
+	{ "background",      10, SystemElement::BACKGROUND       },
+	{ "bodies",          6,  SystemElement::BODIES           },
+	{ "body",            4,  SystemElement::BODY             },
+	{ "name",            4,  SystemElement::NAME             },
+	{ "mass",            4,  SystemElement::MASS             },
+	{ "radius",          6,  SystemElement::RADIUS           },
+	{ "meshFile",        8,  SystemElement::MESH_FILE        },
+	{ "textureFile",     11, SystemElement::TEXTURE_FILE     },
+	{ "position",        8,  SystemElement::POSITION         },
+	{ "velocity",        8,  SystemElement::VELOCITY         },
+	{ "x",               1,  SystemElement::X                },
+	{ "y",               1,  SystemElement::Y                },
+	{ "z",               1,  SystemElement::Z                },
+	{ "tilt",            4,  SystemElement::TILT             },
+	{ "rotationalSpeed", 15, SystemElement::ROTATIONAL_SPEED }
+};
+
+/* Predefined entities, and the character each one stands for. */
+static const struct
+{
+	const char*    name;
+	size_t         length;
+	char           c;
+} ENTITY_NAMES[] =
+{
+	{ "amp",             3,  '&'                             },
+	{ "lt",              2,  '<'                             },
+	{ "gt",              2,  '>'                             },
+	{ "quot",            4,  '"'                             },
+	{ "apos",            4,  '\''                            }
+};
+
+/* Element named by the length bytes at name. */
+static SystemElement findElement(const char* name, size_t length)
+{
+	for(size_t i = 0; i < sizeof(ELEMENT_NAMES) / sizeof(ELEMENT_NAMES[0]); i++)
+		if(ELEMENT_NAMES[i].length == length &&
+		   memcmp(ELEMENT_NAMES[i].name, name, length) == 0)
+			return ELEMENT_NAMES[i].element;
+	return SystemElement::UNKNOWN;
+}
+
+/* Copy the text [begin, end), trimmed, into the string table. */
+static GLuint addString(std::vector<char>& strings, const char* begin, const char* end)
+{
+	begin = FastParse::skipSpace(begin, end);
+	while(end > begin && FastParse::isSpace(end[-1]))
+		end--;
+
+	GLuint offset = strings.size();
+	strings.insert(strings.end(), begin, end);
+	strings.push_back('\0');
+	return offset;
+}
+
+/* First occurrence of text in [p, end), or nullptr. */
+static const char* findText(const char* p, const char* end, const char* text)
+{
+	size_t length = strlen(text);
+	for(; p + length <= end; p++)
+	{
+		p = (const char*) memchr(p, text[0], end - p);
+		if(p == nullptr || p + length > end)
+			return nullptr;
+		if(memcmp(p, text, length) == 0)
+			return p;
+	}
+	return nullptr;
+}
+
+/* Closing '>' of a tag from p, skipping quoted attribute values, or       *
+ * nullptr.                                                                */
+static const char* findTagEnd(const char* p, const char* end)
+{
+	for(; p < end; p++)
+	{
+		if(*p == '"' || *p == '\'')
+		{
+			p = (const char*) memchr(p + 1, *p, end - p - 1);
+			if(p == nullptr)
+				return nullptr;
+		}
+		else if(*p == '>')
+			return p;
+	}
+	return nullptr;
+}
+
+/* Append the character named by the reference [begin, end) (between '&'  *
+ * and ';') to text, UTF-8 encoded. False if it names none.                */
+static bool decodeEntity(std::vector<char>& text, const char* begin, const char* end)
+{
+	for(size_t i = 0; i < sizeof(ENTITY_NAMES) / sizeof(ENTITY_NAMES[0]); i++)
+		if(ENTITY_NAMES[i].length == (size_t) (end - begin) &&
+		   memcmp(ENTITY_NAMES[i].name, begin, end - begin) == 0)
+		{
+			text.push_back(ENTITY_NAMES[i].c);
+			return true;
+		}
+
+	/* Character reference, &#N; or &#xN;. */
+	if(begin == end || *begin++ != '#')
+		return false;
+	GLuint base = begin < end && *begin == 'x' ? 16 : 10;
+	begin      += base == 16;
+	if(begin == end)
+		return false;
+	GLuint code = 0;
+	for(; begin < end; begin++)
+	{
+		GLuint digit = *begin >= '0' && *begin <= '9' ? *begin - '0' :
+		               base == 16 && *begin >= 'a' && *begin <= 'f' ? *begin - 'a' + 10 :
+		               base == 16 && *begin >= 'A' && *begin <= 'F' ? *begin - 'A' + 10 : base;
+		if(digit >= base)
+			return false;
+		code = code * base + digit;
+		if(code > 0x10FFFF)
+			return false;
+	}
+	if(code == 0 || (code >= 0xD800 && code <= 0xDFFF))
+		return false;
+
+	if(code < 0x80)
+		text.push_back((char) code);
+	else if(code < 0x800)
+	{
+		text.push_back((char) (0xC0 | (code >> 6)));
+		text.push_back((char) (0x80 | (code & 0x3F)));
+	}
+	else if(code < 0x10000)
+	{
+		text.push_back((char) (0xE0 | (code >> 12)));
+		text.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+		text.push_back((char) (0x80 | (code & 0x3F)));
+	}
+	else
+	{
+		text.push_back((char) (0xF0 | (code >> 18)));
+		text.push_back((char) (0x80 | ((code >> 12) & 0x3F)));
+		text.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+		text.push_back((char) (0x80 | (code & 0x3F)));
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              addText (static)                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param text / textBegin / textEnd                                          *
+*           Text of the element so far: [textBegin, textEnd) in the file, or *
+*           copied into text once textBegin is nullptr.                       *
+*  @param begin / end                                                         *
+*           Run of text to be added.                                          *
+*  @param decode                                                              *
+*           Whether the run is character data, whose entities are replaced,  *
+*           or the inside of a CDATA section, taken as written.              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Where an unknown or unterminated entity starts, or nullptr.                *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A field written as a single run without entities, as nearly all are, is   *
+*  left in place in the file; only the others are copied.                     *
+*                                                                             *
+*******************************************************************************/
+static const char* addText(std::vector<char>& text, const char** textBegin,
+	const char** textEnd, const char* begin, const char* end, bool decode)
+{
+	if(begin == end)
+		return nullptr;
+	if(text.empty() && *textBegin == nullptr &&
+	   (!decode || memchr(begin, '&', end - begin) == nullptr))
+	{
+		*textBegin = begin;
+		*textEnd   = end;
+		return nullptr;
+	}
+	if(*textBegin != nullptr)
+	{
+		text.assign(*textBegin, *textEnd);
+		*textBegin = nullptr;
+	}
+	if(!decode)
+	{
+		text.insert(text.end(), begin, end);
+		return nullptr;
+	}
+
+	while(begin < end)
+	{
+		const char* amp = (const char*) memchr(begin, '&', end - begin);
+		if(amp == nullptr)
+			amp = end;
+		text.insert(text.end(), begin, amp);
+		if(amp == end)
+			break;
+		const char* semi = (const char*) memchr(amp, ';', end - amp);
+		if(semi == nullptr || !decodeEntity(text, amp + 1, semi))
+			return amp;
+		begin = semi + 1;
+	}
+	return nullptr;
+}
+
+/* Split the next CSV field off [p, end), moving p past its comma. */
+static void nextCsvField(const char*& p, const char* end, const char** begin, const char** fieldEnd)
+{
+	p = FastParse::skipSpace(p, end);
+	if(p < end && *p == '"')
+	{
+		/* Quoted (may hold commas). */
+		const char* quote = (const char*) memchr(p + 1, '"', end - p - 1);
+		*begin    = p + 1;
+		*fieldEnd = quote != nullptr ? quote : end;
+		p         = quote != nullptr ? quote + 1 : end;
+		const char* comma = (const char*) memchr(p, ',', end - p);
+		p = comma != nullptr ? comma + 1 : end;
+	}
+	else
+	{
+		const char* comma = (const char*) memchr(p, ',', end - p);
+		*begin    = p;
+		*fieldEnd = comma != nullptr ? comma : end;
+		p         = comma != nullptr ? comma + 1 : end;
+	}
+}
+
+/* Parse the text [begin, end) as a single number. */
+static bool readFloat(const char* begin, const char* end, GLfloat* value)
+{
+	const char* p = FastParse::skipSpace(begin, end);
+	return FastParse::parseFloat(p, end, value) && FastParse::skipSpace(p, end) == end;
+}
+
+/******************************************************************************
+*                                                                             *
+*                              readText (static)                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param element / parent                                                    *
+*           Element the text belongs to, and the element enclosing it.        *
+*  @param begin / end                                                         *
+*           Text between the element's tags.                                  *
+*  @param system / body                                                       *
+*           System being read, and the body being read (if any).              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  False if the text of a numeric field is not a number.                      *
+*                                                                             *
+*******************************************************************************/
+static bool readText(SystemElement element, SystemElement parent,
+	const char* begin, const char* end, SystemDescription* system, BodyDescription* body)
+{
+	switch(element)
+	{
+	case SystemElement::G:
+		return parent != SystemElement::SYSTEM || readFloat(begin, end, &system->g);
+	case SystemElement::SCALE:
+		return parent != SystemElement::SYSTEM || readFloat(begin, end, &system->scale);
+	case SystemElement::MASS:
+		return parent != SystemElement::BODY || readFloat(begin, end, &body->mass);
+	case SystemElement::ROTATIONAL_SPEED:
+		return parent != SystemElement::BODY || readFloat(begin, end, &body->rotationalSpeed);
+	case SystemElement::RADIUS:
+		if(parent == SystemElement::BACKGROUND)
+			return readFloat(begin, end, &system->starsRadius);
+		return parent != SystemElement::BODY || readFloat(begin, end, &body->radius);
+	case SystemElement::TILT:
+		if(parent == SystemElement::BACKGROUND)
+			return readFloat(begin, end, &system->starsTilt);
+		return parent != SystemElement::BODY || readFloat(begin, end, &body->tilt);
+	case SystemElement::X:
+	case SystemElement::Y:
+	case SystemElement::Z:
+	{
+		glm::vec3* v = parent == SystemElement::POSITION ? &body->position :
+		               parent == SystemElement::VELOCITY ? &body->velocity : nullptr;
+		int        i = (int) element - (int) SystemElement::X;
+		return v == nullptr || readFloat(begin, end, &(*v)[i]);
+	}
+	case SystemElement::NAME:
+		if(parent == SystemElement::BODY)
+			body->name = addString(system->strings, begin, end);
+		return true;
+	case SystemElement::MESH_FILE:
+		if(parent == SystemElement::BACKGROUND)
+			system->starsMeshFile = addString(system->strings, begin, end);
+		else if(parent == SystemElement::BODY)
+			body->meshFile = addString(system->strings, begin, end);
+		return true;
+	case SystemElement::TEXTURE_FILE:
+		if(parent == SystemElement::BACKGROUND)
+			system->starsTextureFile = addString(system->strings, begin, end);
+		else if(parent == SystemElement::BODY)
+			body->textureFile = addString(system->strings, begin, end);
+		return true;
+	default:
+		/* Whitespace between the children of a container. */
+		return true;
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                              SystemFile::parse                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           System file to be read.                                           *
+*  @param system                                                              *
+*           Description filled with the contents of the file.                 *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file could be read. If not, the reason and the line it was     *
+*  found on are printed to stderr.                                            *
+*                                                                             *
+*******************************************************************************/
+bool SystemFile::parse(const char* path, SystemDescription* system)
+{
+	MappedFile file;
+	if(!file.open(path))
+	{
+		std::cerr << "SystemFile: could not open " << path << std::endl;
+		return false;
+	}
+
+	/* Offset 0 of the string table is the empty string, for missing ones. */
+	system->g                = 0.0f;
+	system->scale            = 1.0f;
+	system->starsMeshFile    = 0;
+	system->starsTextureFile = 0;
+	system->starsRadius      = 1.0f;
+	system->starsTilt        = 0.0f;
+	system->bodies.clear();
+	system->strings.assign(1, '\0');
+
+	const char*     begin = (const char*) file.getData();
+	const char*     end   = begin + file.getSize();
+	const char*     p     = begin;
+	const char*     error = nullptr;
+	SystemElement   stack[SYSTEM_FILE_MAX_DEPTH];
+	int             depth = 0;
+	BodyDescription body;
+	const char*     bodyStart = nullptr;
+	size_t          bodyStrings = 0;
+	std::vector<char> text;
+	const char*     textBegin = nullptr;
+	const char*     textEnd   = nullptr;
+
+	while(error == nullptr)
+	{
+		const char* tag = (const char*) memchr(p, '<', end - p);
+		if(tag == nullptr)
+			break;
+
+		/* Text of the innermost open element, read at its end tag. */
+		if(depth > 0)
+		{
+			const char* entity = addText(text, &textBegin, &textEnd, p, tag, true);
+			if(entity != nullptr)
+			{
+				error = "unknown entity";
+				p     = entity;
+				break;
+			}
+		}
+
+		p = tag + 1;
+		if(end - p >= 8 && memcmp(p, "![CDATA[", 8) == 0)
+		{
+			/* Text taken as written. */
+			const char* close = findText(p + 8, end, "]]>");
+			if(close == nullptr)
+				error = "unterminated CDATA section";
+			else
+			{
+				if(depth > 0)
+					addText(text, &textBegin, &textEnd, p + 8, close, false);
+				p = close + 3;
+			}
+		}
+		else if(p < end && (*p == '?' || *p == '!'))
+		{
+			/* Declaration, comment, or DOCTYPE (close is its final '>'). */
+			const char* close = (p + 2 < end && p[1] == '-' && p[2] == '-') ?
+				findText(p + 3, end, "-->") : (const char*) memchr(p, '>', end - p);
+			if(close != nullptr && *close == '-')
+				close += 2;
+			if(close == nullptr)
+				error = "unterminated declaration or comment";
+			else
+				p = close + 1;
+		}
+		else if(p < end && *p == '/')
+		{
+			/* End tag. */
+			const char* close = (const char*) memchr(p, '>', end - p);
+			if(close == nullptr)
+				error = "unterminated end tag";
+			else if(depth == 0)
+				error = "end tag without a start tag";
+			else
+			{
+				/* Read the element's text. */
+				const char* textData = textBegin != nullptr ? textBegin : text.data();
+				size_t      textSize = textBegin != nullptr ? textEnd - textBegin : text.size();
+				depth--;
+				if(textSize > 0 &&
+				   !readText(stack[depth], depth > 0 ? stack[depth - 1] : SystemElement::UNKNOWN,
+				             textData, textData + textSize, system, &body))
+				{
+					error = "expected a number";
+					p     = tag;
+					break;
+				}
+				text.clear();
+				textBegin = nullptr;
+
+				if(stack[depth] == SystemElement::BODY)
+				{
+					/* Size the lists from the first body. */
+					if(system->bodies.empty())
+					{
+						size_t estimate = (end - close) / (close + 1 - bodyStart) + 1;
+						system->bodies.reserve(estimate + 1);
+						system->strings.reserve(system->strings.size() +
+							(system->strings.size() - bodyStrings) * estimate);
+					}
+					system->bodies.push_back(body);
+				}
+				p = close + 1;
+			}
+		}
+		else
+		{
+			/* Start tag (or empty element), attributes ignored. */
+			const char* name = p;
+			while(p < end && !FastParse::isSpace(*p) && *p != '/' && *p != '>')
+				p++;
+			const char* close = findTagEnd(p, end);
+			text.clear();
+			textBegin = nullptr;
+			if(close == nullptr)
+				error = "unterminated start tag";
+			else if(close[-1] != '/')
+			{
+				if(depth == SYSTEM_FILE_MAX_DEPTH)
+					error = "elements nested too deeply";
+				else
+				{
+					stack[depth] = findElement(name, p - name);
+					if(stack[depth] == SystemElement::BODY)
+					{
+						body        = BodyDescription();
+						bodyStart   = tag;
+						bodyStrings = system->strings.size();
+					}
+					depth++;
+				}
+			}
+			if(error == nullptr)
+				p = close + 1;
+		}
+	}
+	if(error == nullptr && depth != 0)
+		error = "unexpected end of file";
+
+	if(error != nullptr)
+	{
+		GLuint line = 1;
+		for(const char* c = begin; c < p && c < end; c++)
+			line += *c == '\n';
+		std::cerr << "SystemFile: " << path << ":" << line << ": " << error << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             SystemFile::parseCsv                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           CSV catalogue to be read.                                         *
+*  @param system                                                              *
+*           Description the bodies are added to.                              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file could be read. If not, the reason and the line it was     *
+*  found on are printed to stderr.                                            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Blank lines and lines starting with '#' are skipped. Bodies without a      *
+*  name are named after their line; bodies without assets get                 *
+*  CSV_DEFAULT_MESH_FILE and CSV_DEFAULT_TEXTURE_FILE.                        *
+*                                                                             *
+*******************************************************************************/
+bool SystemFile::parseCsv(const char* path, SystemDescription* system)
+{
+	MappedFile file;
+	if(!file.open(path))
+	{
+		std::cerr << "SystemFile: could not open " << path << std::endl;
+		return false;
+	}
+	if(system->strings.empty())
+		system->strings.assign(1, '\0');
+
+	const char* p     = (const char*) file.getData();
+	const char* end   = p + file.getSize();
+	const char* error = nullptr;
+	GLuint      line  = 0;
+
+	/* Shared defaults. */
+	const char* defaultMesh    = CSV_DEFAULT_MESH_FILE;
+	const char* defaultTexture = CSV_DEFAULT_TEXTURE_FILE;
+	GLuint      meshFile       = addString(system->strings, defaultMesh, defaultMesh + strlen(defaultMesh));
+	GLuint      textureFile    = addString(system->strings, defaultTexture, defaultTexture + strlen(defaultTexture));
+
+	CsvField    fields[CSV_MAX_COLUMNS];
+	GLuint      numColumns = 0;
+	while(p < end && error == nullptr)
+	{
+		/* Next line, without its line break. */
+		const char* newline = (const char*) memchr(p, '\n', end - p);
+		const char* lineEnd = newline != nullptr ? newline : end;
+		const char* next    = newline != nullptr ? newline + 1 : end;
+		line++;
+		if(lineEnd > p && lineEnd[-1] == '\r')
+			lineEnd--;
+		const char* q = FastParse::skipSpace(p, lineEnd);
+		p = next;
+		if(q == lineEnd || *q == '#')
+			continue;
+
+		/* The first line names the columns. */
+		if(numColumns == 0)
+		{
+			while(q < lineEnd)
+			{
+				const char* begin;
+				const char* fieldEnd;
+				nextCsvField(q, lineEnd, &begin, &fieldEnd);
+				while(fieldEnd > begin && FastParse::isSpace(fieldEnd[-1]))
+					fieldEnd--;
+				if(numColumns == CSV_MAX_COLUMNS)
+				{
+					error = "too many columns";
+					break;
+				}
+				fields[numColumns] = CsvField::IGNORED;
+				for(size_t i = 0; i < sizeof(CSV_FIELD_NAMES) / sizeof(CSV_FIELD_NAMES[0]); i++)
+					if(strlen(CSV_FIELD_NAMES[i].name) == (size_t) (fieldEnd - begin) &&
+					   memcmp(CSV_FIELD_NAMES[i].name, begin, fieldEnd - begin) == 0)
+						fields[numColumns] = CSV_FIELD_NAMES[i].field;
+				numColumns++;
+			}
+			continue;
+		}
+
+		/* A body per line. */
+		BodyDescription body = BodyDescription();
+		body.name        = 0;
+		body.meshFile    = meshFile;
+		body.textureFile = textureFile;
+		for(GLuint c = 0; c < numColumns && q < lineEnd && error == nullptr; c++)
+		{
+			const char* begin;
+			const char* fieldEnd;
+			nextCsvField(q, lineEnd, &begin, &fieldEnd);
+
+			GLfloat* value = nullptr;
+			switch(fields[c])
+			{
+			case CsvField::NAME:
+				body.name        = addString(system->strings, begin, fieldEnd);
+				break;
+			case CsvField::MESH_FILE:
+				body.meshFile    = addString(system->strings, begin, fieldEnd);
+				break;
+			case CsvField::TEXTURE_FILE:
+				body.textureFile = addString(system->strings, begin, fieldEnd);
+				break;
+			case CsvField::MASS:             value = &body.mass;            break;
+			case CsvField::RADIUS:           value = &body.radius;          break;
+			case CsvField::X:                value = &body.position.x;      break;
+			case CsvField::Y:                value = &body.position.y;      break;
+			case CsvField::Z:                value = &body.position.z;      break;
+			case CsvField::VX:               value = &body.velocity.x;      break;
+			case CsvField::VY:               value = &body.velocity.y;      break;
+			case CsvField::VZ:               value = &body.velocity.z;      break;
+			case CsvField::TILT:             value = &body.tilt;            break;
+			case CsvField::ROTATIONAL_SPEED: value = &body.rotationalSpeed; break;
+			default:                                                        break;
+			}
+			if(value != nullptr && FastParse::skipSpace(begin, fieldEnd) != fieldEnd &&
+			   !readFloat(begin, fieldEnd, value))
+				error = "expected a number";
+		}
+		if(system->strings[body.name] == '\0')
+		{
+			char name[32];
+			sprintf(name, "Body%u", line);
+			body.name = addString(system->strings, name, name + strlen(name));
+		}
+		system->bodies.push_back(body);
+	}
+
+	if(error != nullptr)
+	{
+		std::cerr << "SystemFile: " << path << ":" << line << ": " << error << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             SystemFile::generate                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           File to be written.                                               *
+*  @param numBodies                                                           *
+*           Number of bodies orbiting the central star.                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file was written.                                              *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes a star and numBodies bodies on circular orbits around it, laid out  *
+*  like res/data/system.xml. The orbits come from a fixed seed, so the same   *
+*  numBodies always gives the same file.                                      *
+*                                                                             *
+*******************************************************************************/
+bool SystemFile::generate(const char* path, GLuint numBodies)
+{
+	FILE* out = fopen(path, "wb");
+	if(out == nullptr)
+		return false;
+	setvbuf(out, nullptr, _IOFBF, GENERATE_BUFFER_SIZE);
+
+	fprintf(out,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<system>\n"
+		"\t<g>%.6e</g>\n"
+		"\t<scale>1.000e5</scale>\n"
+		"\t<background>\n"
+		"\t\t<meshFile>sphere:4</meshFile>\n"
+		"\t\t<textureFile>res/textures/milkyway.jpg</textureFile>\n"
+		"\t\t<radius>1.000e5</radius>\n"
+		"\t\t<tilt>60.0</tilt>\n"
+		"\t</background>\n"
+		"\t<bodies>\n", GENERATE_G);
+
+	GLuint64 seed = 0x9e3779b97f4a7c15ull;
+	for(GLuint i = 0; i <= numBodies; i++)
+	{
+		/* Body 0 is the star; the others orbit it in the x-z plane. */
+		GLdouble mass = GENERATE_STAR_MASS, radius = 6.96e8, orbit = 0, angle = 0, speed = 0;
+		if(i > 0)
+		{
+			seed  = seed * 6364136223846793005ull + 1442695040888963407ull;
+			orbit = GENERATE_MIN_ORBIT + (GENERATE_MAX_ORBIT - GENERATE_MIN_ORBIT) *
+			        ((seed >> 11) * (1.0 / 9007199254740992.0));
+			seed  = seed * 6364136223846793005ull + 1442695040888963407ull;
+			angle = 2.0 * M_PI * ((seed >> 11) * (1.0 / 9007199254740992.0));
+			speed = sqrt(GENERATE_G * GENERATE_STAR_MASS / orbit);
+			mass  = 1.0e20 + 1.0e4 * (GLdouble) (seed >> 40);
+			radius = 1.0e6;
+		}
+
+		fprintf(out,
+			"\t\t<body>\n"
+			"\t\t\t<name>%s%u</name>\n"
+			"\t\t\t<mass>%.6e</mass>\n"
+			"\t\t\t<radius>%.6e</radius>\n"
+			"\t\t\t<meshFile>sphere:5</meshFile>\n"
+			"\t\t\t<textureFile>res/textures/%s.jpg</textureFile>\n"
+			"\t\t\t<position>\n"
+			"\t\t\t\t<x>%.6e</x>\n"
+			"\t\t\t\t<y>0.0</y>\n"
+			"\t\t\t\t<z>%.6e</z>\n"
+			"\t\t\t</position>\n"
+			"\t\t\t<velocity>\n"
+			"\t\t\t\t<x>%.6e</x>\n"
+			"\t\t\t\t<y>0.0</y>\n"
+			"\t\t\t\t<z>%.6e</z>\n"
+			"\t\t\t</velocity>\n"
+			"\t\t\t<tilt>0.0</tilt>\n"
+			"\t\t\t<rotationalSpeed>1.0e-4</rotationalSpeed>\n"
+			"\t\t</body>\n",
+			i == 0 ? "Star" : "Body", i, mass, radius,
+			i == 0 ? "sun" : "mars",
+			orbit * cos(angle), orbit * sin(angle),
+			-speed * sin(angle), speed * cos(angle));
+	}
+
+	fprintf(out, "\t</bodies>\n</system>\n");
+	return fclose(out) == 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                            SystemFile::benchmark                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param numBodies                                                           *
+*           Number of bodies in the generated file.                           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Writes a generated system to SYSTEM_FILE_BENCH_PATH and parses it, then    *
+*  converts it to a scene at SCENE_FILE_BENCH_PATH and opens that, reading    *
+*  every column once (what building the system from it has to do at least).  *
+*  Prints both rates in bodies and megabytes per second, and removes the      *
+*  files.                                                                     *
+*                                                                             *
+*******************************************************************************/
+void SystemFile::benchmark(GLuint numBodies)
+{
+	if(!generate(SYSTEM_FILE_BENCH_PATH, numBodies))
+	{
+		std::cerr << "SystemFile: could not write " << SYSTEM_FILE_BENCH_PATH << std::endl;
+		return;
+	}
+
+	/* System file. */
+	SystemDescription system;
+	GLuint64 start = SDL_GetPerformanceCounter();
+	bool     ok    = parse(SYSTEM_FILE_BENCH_PATH, &system);
+	GLdouble secs  = (GLdouble) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+	MappedFile file;
+	GLdouble   mb = file.open(SYSTEM_FILE_BENCH_PATH) ? file.getSize() / (1024.0 * 1024.0) : 0;
+	file.close();
+	remove(SYSTEM_FILE_BENCH_PATH);
+	if(!ok)
+		return;
+	fprintf(stdout, "Parsed %u bodies (%.1f MB) in %.1f ms: %.0f bodies/s, %.1f MB/s\n",
+		(GLuint) system.bodies.size(), mb, 1000.0 * secs,
+		system.bodies.size() / secs, mb / secs);
+
+	/* Scene. */
+	if(!SceneFile::write(SCENE_FILE_BENCH_PATH, system))
+		return;
+	volatile GLdouble sum = 0;
+	SceneFile scene;
+	start = SDL_GetPerformanceCounter();
+	if(scene.open(SCENE_FILE_BENCH_PATH))
+	{
+		const GLuint     n          = scene.getNumBodies();
+		const GLfloat*   masses     = scene.getMasses();
+		const GLfloat*   radii      = scene.getRadii();
+		const glm::vec3* positions  = scene.getPositions();
+		const glm::vec3* velocities = scene.getVelocities();
+		const GLfloat*   tilts      = scene.getTilts();
+		const GLfloat*   speeds     = scene.getRotationalSpeeds();
+		const GLuint*    names      = scene.getNames();
+		for(GLuint i = 0; i < n; i++)
+			sum += masses[i] + radii[i] + positions[i].x + velocities[i].x +
+			       tilts[i] + speeds[i] + names[i];
+		secs = (GLdouble) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+		mb   = scene.getHeader()->fileBytes / (1024.0 * 1024.0);
+		fprintf(stdout, "Loaded %u bodies (%.1f MB scene) in %.1f ms: %.0f bodies/s, %.1f MB/s\n",
+			n, mb, 1000.0 * secs, n / secs, mb / secs);
+	}
+	scene.close();
+	remove(SCENE_FILE_BENCH_PATH);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Deepest element nesting the system file parser follows. */
+#define  SYSTEM_FILE_MAX_DEPTH                                             16
+/* Files written and read by SystemFile::benchmark. */
+#define  SYSTEM_FILE_BENCH_PATH                             "bench_system.xml"
+#define  SCENE_FILE_BENCH_PATH                              "bench_system.gss"
+/* Columns a CSV catalogue may have, and the assets of bodies without any. */
+#define  CSV_MAX_COLUMNS                                                   64
+#define  CSV_DEFAULT_MESH_FILE                                   "sphere:5"
+#define  CSV_DEFAULT_TEXTURE_FILE                     "res/textures/moon.jpg"
+
+/******************************************************************************
+*                                                                             *
+*                  BodyDescription / SystemDescription   (structs)            *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Contents of a system file, in the file's own units. Strings are stored     *
+*  once each, NUL-terminated, in one table; name, meshFile, and textureFile   *
+*  are offsets into it, so a body costs no allocations of its own.            *
+*                                                                             *
+*******************************************************************************/
+struct BodyDescription
+{
+	GLuint                   name;
+	GLuint                   meshFile;
+	GLuint                   textureFile;
+	GLfloat                  mass;
+	GLfloat                  radius;
+	glm::vec3                position;
+	glm::vec3                velocity;
+	GLfloat                  tilt;
+	GLfloat                  rotationalSpeed;
+};
+struct SystemDescription
+{
+	GLfloat                  g;
+	GLfloat                  scale;
+	GLuint                   starsMeshFile;
+	GLuint                   starsTextureFile;
+	GLfloat                  starsRadius;
+	GLfloat                  starsTilt;
+	std::vector<BodyDescription> bodies;
+	std::vector<char>        strings;
+
+	/* String stored at an offset. */
+	const char*    getString(GLuint offset) const  {  return &strings[offset]; }
+};
+
+/******************************************************************************
+*                                                                             *
+*                              SystemFile   (class)                           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Reads system files (see res/data/orbitalSystem.xsd) without building a     *
+*  document tree. The file is mapped into memory and scanned once, front to   *
+*  back; each element only updates a small stack of open elements, and the    *
+*  text of a field is parsed straight into the body being read.               *
+*  The body list is reserved once the first body has been read, from its      *
+*  size in the file, so it is not regrown for every body after that.          *
+*  Comments, processing instructions, and attributes are skipped, and        *
+*  unknown elements are ignored. The predefined entities and character       *
+*  references are replaced, and CDATA sections taken as written; a field is  *
+*  only copied out of the file if it has either.                              *
+*                                                                             *
+*  Catalogues can also be read from CSV files whose first line names the      *
+*  columns: name, mass, radius, meshFile, textureFile, x, y, z, vx, vy, vz,   *
+*  tilt, and rotationalSpeed, in any order, in the units of a system file.    *
+*  Other columns are ignored, and the bodies are added to the description,    *
+*  whose system parameters are left as they are.                              *
+*                                                                             *
+*******************************************************************************/
+class SystemFile
+{
+public:
+	/* Read a system file (false, with a message, if it is malformed). */
+	static bool    parse(const char* path, SystemDescription* system);
+	/* Add the bodies of a CSV catalogue to a system. */
+	static bool    parseCsv(const char* path, SystemDescription* system);
+	/* Write a system file of numBodies bodies in random orbits. */
+	static bool    generate(const char* path, GLuint numBodies);
+	/* Generate and load a system of numBodies bodies as a system file and *
+	 * as a scene, printing the rates.                                     */
+	static void    benchmark(GLuint numBodies);
+};
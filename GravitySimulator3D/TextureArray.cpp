@@ -0,0 +1,315 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "TextureArray.h"
+#include "AssetPack.h"
+#include <algorithm>
+
+std::vector<TextureArray::Array> TextureArray::arrays;
+std::vector<TextureArray::Layer> TextureArray::layers;
+std::vector<GLuint>              TextureArray::freeHandles;
+GLuint64                         TextureArray::numBytes = 0;
+
+/******************************************************************************
+*                                                                             *
+*                        TextureArray::add / reserve                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry                                                               *
+*           Format, size and number of mip levels of the texture.             *
+*  @param levels                                                              *
+*           Its mip levels, largest first, each on a PACK_ALIGNMENT boundary. *
+*  @param bytes                                                               *
+*           Set to the size of the layer on the graphics hardware.            *
+*  @param maxLayers                                                           *
+*           Most layers of a new array, if one must be made (reserve only).   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Handle of the texture, or 0 if there is none.                              *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  add() uploads every level at once. reserve() only takes the layer, with    *
+*  none of its levels resident, for TextureStream to fill in over the next    *
+*  frames. A maxLayers of 1 gives a texture an array of its own unless one   *
+*  of its size has a layer free, so it takes no more memory than its layer.  *
+*                                                                             *
+*******************************************************************************/
+GLuint TextureArray::add(const PackEntry* entry, const unsigned char* levels,
+                         GLuint64* bytes)
+{
+	GLuint handle = reserve(entry, bytes);
+	if(handle == 0)
+		return 0;
+
+	GLuint height = entry->height;
+	for(GLuint i = 0; i < entry->numLevels; i++)
+	{
+		uploadRows(handle, i, 0, height, levels);
+		levels += AssetPack::alignPack(
+			AssetPack::levelBytes(entry->format, getLevelWidth(handle, i), height));
+		height  = AssetPack::nextLevel(height);
+	}
+	layers[handle - 1].minLevel = 0;
+	return handle;
+}
+GLuint TextureArray::reserve(const PackEntry* entry, GLuint64* bytes,
+                             GLuint maxLayers)
+{
+	if(entry == nullptr || entry->numLevels == 0)
+		return 0;
+
+	/* Take a free layer of an array of this size. */
+	const GLuint a     = findArray(entry, std::max(maxLayers, 1u));
+	Array&       array = arrays[a];
+	const GLuint layer = array.freeLayers.back();
+	array.freeLayers.pop_back();
+
+	/* Hand out a handle for the layer. */
+	Layer  named  = { a, layer, entry->numLevels };
+	GLuint handle;
+	if(!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		layers[handle - 1] = named;
+	}
+	else
+	{
+		layers.push_back(named);
+		handle = layers.size();
+	}
+
+	if(bytes != NULL)
+		*bytes = array.layerBytes;
+	return handle;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TextureArray::uploadRows                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle / level                                                      *
+*           Texture, and the mip level of it to be written.                   *
+*  @param y / rows                                                            *
+*           First row, and the number of rows, to be written (multiples of   *
+*           four for BC1, unless they reach the bottom of the level).         *
+*  @param data                                                                *
+*           The rows, in client memory or, if a buffer is bound to            *
+*           GL_PIXEL_UNPACK_BUFFER, as an offset into it.                     *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void TextureArray::uploadRows(GLuint handle, GLuint level, GLuint y,
+                              GLuint rows, const GLvoid* data)
+{
+	const Layer& named = layers[handle - 1];
+	const Array& array = arrays[named.array];
+	const GLuint width = getLevelWidth(handle, level);
+
+	/* Rows of RGB texels are not padded. */
+	glBindTexture(GL_TEXTURE_2D_ARRAY, array.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if(array.format == GL_RGB)
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, named.layer, width, rows, 1,
+			GL_RGB, GL_UNSIGNED_BYTE, data);
+	else
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, named.layer,
+			width, rows, 1, array.format,
+			(GLsizei) AssetPack::levelBytes(array.format, width, rows), data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/******************************************************************************
+*                                                                             *
+*                  TextureArray::getLevelWidth / getLevelHeight               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle / level                                                      *
+*           Texture, and one of its mip levels.                               *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Size of the level in texels.                                               *
+*                                                                             *
+*******************************************************************************/
+GLuint TextureArray::getLevelWidth(GLuint handle, GLuint level)
+{
+	GLuint width = arrays[layers[handle - 1].array].width;
+	for(GLuint i = 0; i < level; i++)
+		width = AssetPack::nextLevel(width);
+	return width;
+}
+GLuint TextureArray::getLevelHeight(GLuint handle, GLuint level)
+{
+	GLuint height = arrays[layers[handle - 1].array].height;
+	for(GLuint i = 0; i < level; i++)
+		height = AssetPack::nextLevel(height);
+	return height;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             TextureArray::findArray                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry                                                               *
+*           Format, size and number of mip levels of the texture to be added. *
+*  @param maxLayers                                                           *
+*           Most layers of a new array.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Index of an array with a free layer for it.                                *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A new array has storage for all of its layers and levels from the start,   *
+*  so adding a layer never moves the ones already there.                      *
+*                                                                             *
+*******************************************************************************/
+GLuint TextureArray::findArray(const PackEntry* entry, GLuint maxLayers)
+{
+	GLuint numSameSize = 0;
+	GLuint emptySlot   = arrays.size();
+	for(GLuint a = 0; a < arrays.size(); a++)
+	{
+		const Array& array = arrays[a];
+		if(array.textureID == 0)
+		{
+			emptySlot = a;
+			continue;
+		}
+		if(array.format != entry->format || array.width != entry->width ||
+		   array.height != entry->height || array.numLevels != entry->numLevels)
+			continue;
+		if(!array.freeLayers.empty())
+			return a;
+		numSameSize++;
+	}
+
+	Array array;
+	array.format     = entry->format;
+	array.width      = entry->width;
+	array.height     = entry->height;
+	array.numLevels  = entry->numLevels;
+	array.numLayers  = TEXTURE_ARRAY_MIN_LAYERS;
+	array.layerBytes = 0;
+	for(GLuint i = 0; i < numSameSize && array.numLayers < TEXTURE_ARRAY_MAX_LAYERS; i++)
+		array.numLayers *= 2;
+	array.numLayers  = std::min(array.numLayers, (GLuint) TEXTURE_ARRAY_MAX_LAYERS);
+	array.numLayers  = std::min(array.numLayers, maxLayers);
+	for(GLuint l = array.numLayers; l > 0; l--)
+		array.freeLayers.push_back(l - 1);
+
+	/* Storage for every level of every layer. */
+	glGenTextures(1, &array.textureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, array.textureID);
+	GLuint width  = array.width;
+	GLuint height = array.height;
+	for(GLuint i = 0; i < array.numLevels; i++)
+	{
+		GLuint64 n = AssetPack::levelBytes(array.format, width, height);
+		if(array.format == GL_RGB)
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, i, GL_RGB8, width, height,
+				array.numLayers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		else
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, array.format, width,
+				height, array.numLayers, 0, (GLsizei) (n * array.numLayers), NULL);
+		array.layerBytes += n;
+		width  = AssetPack::nextLevel(width);
+		height = AssetPack::nextLevel(height);
+	}
+	numBytes += array.layerBytes * array.numLayers;
+
+	/* Trilinear, wrapping in longitude (the faces of an icosphere across  *
+	 * its seam run past u = 1) and clamped at the poles.                  */
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array.numLevels - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	if(emptySlot == arrays.size())
+		arrays.push_back(array);
+	else
+		arrays[emptySlot] = array;
+	return emptySlot;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             TextureArray::remove                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle                                                              *
+*           Texture returned by add().                                        *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void TextureArray::remove(GLuint handle)
+{
+	if(handle == 0 || handle > layers.size())
+		return;
+
+	const Layer& named = layers[handle - 1];
+	Array&       array = arrays[named.array];
+	array.freeLayers.push_back(named.layer);
+	freeHandles.push_back(handle);
+
+	/* Delete the array with its last layer. */
+	if(array.freeLayers.size() == array.numLayers)
+	{
+		glDeleteTextures(1, &array.textureID);
+		numBytes -= array.layerBytes * array.numLayers;
+		array.textureID = 0;
+		array.freeLayers.clear();
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                        TextureArray::cleanUp / getNumArrays                 *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void / the number of arrays currently made.                                *
+*                                                                             *
+*******************************************************************************/
+void TextureArray::cleanUp()
+{
+	for(Array& array : arrays)
+		if(array.textureID != 0)
+			glDeleteTextures(1, &array.textureID);
+	arrays.clear();
+	layers.clear();
+	freeHandles.clear();
+	numBytes = 0;
+}
+GLuint TextureArray::getNumArrays()
+{
+	GLuint n = 0;
+	for(const Array& array : arrays)
+		if(array.textureID != 0)
+			n++;
+	return n;
+}
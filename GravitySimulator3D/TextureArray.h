@@ -0,0 +1,140 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <utility>
+#include <vector>
+
+struct PackEntry;
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Layers of the first array made for a size of texture, and the most any   *
+ * array gets (each further array of that size has twice the last).        */
+#define  TEXTURE_ARRAY_MIN_LAYERS                                           4
+#define  TEXTURE_ARRAY_MAX_LAYERS                                          64
+
+/******************************************************************************
+*                                                                             *
+*                             TextureArray   (class)                          *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  arrays                                                                     *
+*          Every GL_TEXTURE_2D_ARRAY made, with the format, size and mip      *
+*          levels all its layers share, and its free layers (an array whose   *
+*          last layer is removed is deleted, leaving its slot free).          *
+*  layers                                                                     *
+*          Array, layer and finest resident level of every handle, less one   *
+*          (0 is no texture).                                                 *
+*  freeHandles                                                                *
+*          Handles of removed textures, given out again first.                *
+*  numBytes                                                                   *
+*          Size of the arrays on the graphics hardware, free layers and all.  *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Holds the textures of the bodies as layers of texture arrays, one array    *
+*  for each format, size and number of mip levels, so the bodies textured     *
+*  from images of the same size share one texture object. A texture is a     *
+*  handle naming its array and layer; Display binds the array once for every  *
+*  body in it and gives each instance its layer.                              *
+*                                                                             *
+*  Textures are added as their whole mip chains, laid out as in an asset      *
+*  pack (see AssetPack::encodeTexture): RGB rows or BC1 blocks. They are      *
+*  sampled trilinearly, wrapping in longitude and clamped at the poles. A     *
+*  texture may also be reserved and filled in a few rows at a time (see       *
+*  TextureStream); until its finest level is in, the shader clamps the level  *
+*  it samples to the finest one resident, as the layers of an array share     *
+*  its base level.                                                            *
+*                                                                             *
+*  All calls must be made on the thread owning the GL context.                *
+*                                                                             *
+*******************************************************************************/
+class TextureArray
+{
+public:
+	/* Upload a texture's levels into a free layer, returning its handle   *
+	 * (0 if it has none), and the size of the layer in bytes.             */
+	static GLuint  add(const PackEntry* entry, const unsigned char* levels,
+	                   GLuint64* bytes = NULL);
+	/* Take a free layer for a texture without uploading any of it, making *
+	 * an array of at most maxLayers layers if there is none.              */
+	static GLuint  reserve(const PackEntry* entry, GLuint64* bytes = NULL,
+	                       GLuint maxLayers = TEXTURE_ARRAY_MAX_LAYERS);
+	/* Upload rows of one level of a texture. */
+	static void    uploadRows(GLuint handle, GLuint level, GLuint y,
+	                          GLuint rows, const GLvoid* data);
+	/* Free a texture's layer. */
+	static void    remove(GLuint handle);
+	/* Trade the layers two handles name, so a texture can be moved to     *
+	 * another array without its handle changing.                          */
+	static void    swap(GLuint a, GLuint b)
+	{
+		std::swap(layers[a - 1], layers[b - 1]);
+	}
+	/* Delete every array (while the context is alive). */
+	static void    cleanUp();
+
+	/* Texture object a texture lives in, and its layer. */
+	static GLuint  getArrayID(GLuint handle)
+	{
+		return handle != 0 ? arrays[layers[handle - 1].array].textureID : 0;
+	}
+	static GLfloat getLayer(GLuint handle)
+	{
+		return handle != 0 ? (GLfloat) layers[handle - 1].layer : 0.0f;
+	}
+	/* Finest level of a texture uploaded so far (all of those coarser are *
+	 * too), which it is not sampled finer than.                           */
+	static GLfloat getMinLevel(GLuint handle)
+	{
+		return handle != 0 ? (GLfloat) layers[handle - 1].minLevel : 0.0f;
+	}
+	static void    setMinLevel(GLuint handle, GLuint level)
+	{
+		layers[handle - 1].minLevel = level;
+	}
+	/* Size of a level of a texture. */
+	static GLuint  getLevelWidth(GLuint handle, GLuint level);
+	static GLuint  getLevelHeight(GLuint handle, GLuint level);
+
+	/* Getters. */
+	static GLuint  getNumArrays();
+	static GLuint  getNumLayers()                {  return layers.size() - freeHandles.size(); }
+	static GLuint64 getNumBytes()                {  return numBytes;       }
+
+private:
+	struct Array
+	{
+		GLuint              textureID;
+		GLenum              format;
+		GLuint              width;
+		GLuint              height;
+		GLuint              numLevels;
+		GLuint              numLayers;
+		GLuint64            layerBytes;
+		std::vector<GLuint> freeLayers;
+	};
+	struct Layer
+	{
+		GLuint              array;
+		GLuint              layer;
+		GLuint              minLevel;
+	};
+
+	/* Array with a free layer for a texture, made if there is none. */
+	static GLuint  findArray(const PackEntry* entry, GLuint maxLayers);
+
+	static std::vector<Array>  arrays;
+	static std::vector<Layer>  layers;
+	static std::vector<GLuint> freeHandles;
+	static GLuint64            numBytes;
+};
@@ -0,0 +1,388 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "TextureResidency.h"
+#include "TextureArray.h"
+#include "TextureStream.h"
+#include <algorithm>
+
+std::unordered_map<GLuint, TextureResidency::Texture> TextureResidency::textures;
+std::vector<GLuint> TextureResidency::candidates;
+GLuint64            TextureResidency::budget        = TEXTURE_RESIDENCY_BUDGET;
+GLuint64            TextureResidency::residentBytes = 0;
+GLuint64            TextureResidency::frame         = 0;
+GLuint              TextureResidency::numMisses     = 0;
+GLuint64            TextureResidency::totalMisses   = 0;
+GLuint              TextureResidency::numPromotions = 0;
+GLuint              TextureResidency::numEvictions  = 0;
+
+/* Bytes of a layer holding the given levels (as TextureArray sizes it). */
+static GLuint64 layerBytes(const PackEntry& entry)
+{
+	GLuint64 bytes  = 0;
+	GLuint   width  = entry.width;
+	GLuint   height = entry.height;
+	for(GLuint i = 0; i < entry.numLevels; i++)
+	{
+		bytes += AssetPack::levelBytes(entry.format, width, height);
+		width  = AssetPack::nextLevel(width);
+		height = AssetPack::nextLevel(height);
+	}
+	return bytes;
+}
+
+/******************************************************************************
+*                                                                             *
+*                       TextureResidency::add / remove                        *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry                                                               *
+*           Format, size and number of mip levels of the texture.             *
+*  @param levels                                                              *
+*           Its mip levels, laid out as in an asset pack, if they outlive the *
+*           texture (nullptr to take texels instead).                         *
+*  @param texels                                                              *
+*           Its mip levels otherwise, swapped out of the caller's vector.     *
+*  @param bytes                                                               *
+*           Set to the size of the starting layer on the graphics hardware.   *
+*  @param handle                                                              *
+*           Texture returned by add() (others are ignored).                   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Handle of the texture, or 0 if there is none / void.                       *
+*                                                                             *
+*******************************************************************************/
+GLuint TextureResidency::add(const PackEntry* entry, const unsigned char* levels,
+                             std::vector<unsigned char>* texels, GLuint64* bytes)
+{
+	std::vector<unsigned char> kept;
+	if(levels == nullptr && texels != NULL)
+	{
+		kept.swap(*texels);
+		levels = kept.data();
+	}
+	if(entry == nullptr || levels == nullptr)
+		return 0;
+
+	/* Stream in the levels up to the starting width. */
+	const GLuint         base = startLevel(*entry);
+	const unsigned char* start;
+	PackEntry            sub   = fromLevel(*entry, levels, base, &start);
+	GLuint64             layer = 0;
+	GLuint handle = TextureStream::queue(&sub, start, NULL, &layer);
+	if(handle == 0)
+		return 0;
+
+	Texture& texture     = textures[handle];
+	texture.entry        = *entry;
+	texture.levels       = levels;
+	texture.texels.swap(kept);
+	texture.base         = base;
+	texture.bytes        = layer;
+	texture.pending      = 0;
+	texture.pendingBase  = 0;
+	texture.pendingBytes = 0;
+	texture.wanted       = entry->numLevels;
+	texture.lastUsed     = frame;
+	residentBytes       += layer;
+
+	if(bytes != NULL)
+		*bytes = layer;
+	return handle;
+}
+void TextureResidency::remove(GLuint handle)
+{
+	std::unordered_map<GLuint, Texture>::iterator it = textures.find(handle);
+	if(it == textures.end())
+		return;
+	dropPending(it->second);
+	TextureStream::cancel(handle);
+	residentBytes -= it->second.bytes;
+	textures.erase(it);
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TextureResidency::request                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle                                                              *
+*           Texture of a body in sight (others are ignored).                  *
+*  @param pixels                                                              *
+*           Pixels its width would cover on screen, at the body's distance.   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  The level asked for is the coarsest still at least a texel per pixel;     *
+*  the finest asked for by any body using the texture is kept.                *
+*                                                                             *
+*******************************************************************************/
+void TextureResidency::request(GLuint handle, GLfloat pixels)
+{
+	if(handle == 0)
+		return;
+	std::unordered_map<GLuint, Texture>::iterator it = textures.find(handle);
+	if(it == textures.end())
+		return;
+
+	Texture& texture = it->second;
+	GLuint   level   = 0;
+	GLuint   width   = texture.entry.width;
+	while(level + 1 < texture.entry.numLevels && AssetPack::nextLevel(width) >= pixels)
+	{
+		width = AssetPack::nextLevel(width);
+		level++;
+	}
+	texture.wanted   = std::min(texture.wanted, level);
+	texture.lastUsed = frame;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TextureResidency::update                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Called once per frame, after the requests of the frame drawn and before   *
+*  TextureStream::update(). Swaps in the layers done streaming, counts the    *
+*  misses, and starts streaming a finer layer for each, evicting the least    *
+*  recently drawn textures while the new layer does not fit the budget. A     *
+*  texture is kept at its level until the budget needs the room back.         *
+*                                                                             *
+*  The budget is held against TextureArray::getNumBytes(), the arrays as     *
+*  made, free layers and all. A finer layer gets an array of its own (or a   *
+*  free layer of one), so promoting a texture adds no more than its layer;   *
+*  the starting layers share arrays, which cost little at their width.       *
+*                                                                             *
+*******************************************************************************/
+void TextureResidency::update()
+{
+	/* Swap in the layers done streaming, freeing the ones they replace. */
+	for(std::pair<const GLuint, Texture>& named : textures)
+	{
+		Texture& texture = named.second;
+		if(texture.pending == 0 || TextureArray::getMinLevel(texture.pending) != 0.0f)
+			continue;
+		TextureStream::cancel(named.first);
+		TextureArray::swap(named.first, texture.pending);
+		TextureArray::remove(texture.pending);
+		residentBytes       -= texture.bytes;
+		texture.base         = texture.pendingBase;
+		texture.bytes        = texture.pendingBytes;
+		texture.pending      = 0;
+		texture.pendingBytes = 0;
+	}
+
+	/* Count the textures drawn coarser than asked for. */
+	candidates.clear();
+	numMisses = 0;
+	for(std::pair<const GLuint, Texture>& named : textures)
+	{
+		const Texture& texture = named.second;
+		if(texture.lastUsed != frame || texture.wanted >= texture.base)
+			continue;
+		numMisses++;
+		if(texture.pending == 0 || texture.pendingBase > texture.wanted)
+			candidates.push_back(named.first);
+	}
+	totalMisses += numMisses;
+
+	/* Stream in a finer layer for each, while there is room for it. */
+	for(GLuint handle : candidates)
+	{
+		Texture& texture = textures[handle];
+		dropPending(texture);
+
+		const unsigned char* start;
+		PackEntry sub  = fromLevel(texture.entry, texture.levels, texture.wanted, &start);
+		GLuint64  cost = layerBytes(sub);
+		bool      fits = true;
+		while(fits && TextureArray::getNumBytes() + cost > budget)
+		{
+			/* Least recently drawn texture with room to give back: one out *
+			 * of sight above its starting level or with a layer streaming, *
+			 * or one in sight above the level it was asked for.            */
+			GLuint   victim = 0;
+			Texture* oldest = nullptr;
+			for(std::pair<const GLuint, Texture>& named : textures)
+			{
+				Texture& other = named.second;
+				if(named.first == handle ||
+				   (oldest != nullptr && other.lastUsed >= oldest->lastUsed))
+					continue;
+				GLuint target = other.lastUsed == frame ? other.wanted : startLevel(other.entry);
+				if(target > other.base || (other.pending != 0 && other.lastUsed != frame))
+				{
+					victim = named.first;
+					oldest = &other;
+				}
+			}
+			if(oldest == nullptr)
+			{
+				fits = false;
+				continue;
+			}
+			GLuint target = oldest->lastUsed == frame ? oldest->wanted : startLevel(oldest->entry);
+			if(target <= oldest->base)
+				dropPending(*oldest);
+			else if(!evict(victim, *oldest, target))
+				fits = false;
+		}
+		if(!fits)
+			break;
+
+		GLuint64 layer       = 0;
+		texture.pending      = TextureArray::reserve(&sub, &layer, 1);
+		if(texture.pending == 0)
+			break;
+		TextureStream::stream(texture.pending, &sub, start);
+		texture.pendingBase  = texture.wanted;
+		texture.pendingBytes = layer;
+		residentBytes       += layer;
+		numPromotions++;
+	}
+
+	/* Start the next frame's requests. */
+	frame++;
+	for(std::pair<const GLuint, Texture>& named : textures)
+		named.second.wanted = named.second.entry.numLevels;
+}
+
+/******************************************************************************
+*                                                                             *
+*                    TextureResidency::evict / dropPending                    *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle / texture                                                    *
+*           Texture to move, and its record.                                  *
+*  @param base                                                                *
+*           Coarser level to move it down to.                                 *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the texture was evicted / void.                                    *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Evicting frees the texture's layer at once and streams the coarser one in  *
+*  its place, coarsest level first, so it is drawn again from the next frame. *
+*                                                                             *
+*******************************************************************************/
+bool TextureResidency::evict(GLuint handle, Texture& texture, GLuint base)
+{
+	dropPending(texture);
+
+	const unsigned char* start;
+	PackEntry sub   = fromLevel(texture.entry, texture.levels, base, &start);
+	GLuint64  layer = 0;
+	GLuint    fresh = TextureArray::reserve(&sub, &layer,
+		base < startLevel(texture.entry) ? 1 : TEXTURE_ARRAY_MAX_LAYERS);
+	if(fresh == 0)
+		return false;
+
+	/* Give the handle the new layer and free the old one. */
+	TextureStream::cancel(handle);
+	TextureArray::swap(handle, fresh);
+	TextureArray::remove(fresh);
+	TextureStream::stream(handle, &sub, start);
+	residentBytes  = residentBytes - texture.bytes + layer;
+	texture.base   = base;
+	texture.bytes  = layer;
+	numEvictions++;
+	return true;
+}
+void TextureResidency::dropPending(Texture& texture)
+{
+	if(texture.pending == 0)
+		return;
+	TextureStream::cancel(texture.pending);
+	TextureArray::remove(texture.pending);
+	residentBytes       -= texture.pendingBytes;
+	texture.pending      = 0;
+	texture.pendingBytes = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*                   TextureResidency::fromLevel / startLevel                  *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param entry / levels                                                      *
+*           Format, size and number of mip levels of a texture, and them.     *
+*  @param base                                                                *
+*           Level to start from.                                              *
+*  @param start                                                               *
+*           Set to where that level is.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  The texture from level base down, as if it were a whole texture / the     *
+*  first level no wider than TEXTURE_RESIDENCY_MIN_WIDTH (or the last).       *
+*                                                                             *
+*******************************************************************************/
+PackEntry TextureResidency::fromLevel(const PackEntry& entry,
+                                      const unsigned char* levels, GLuint base,
+                                      const unsigned char** start)
+{
+	PackEntry sub = entry;
+	for(GLuint i = 0; i < base; i++)
+	{
+		levels    += AssetPack::alignPack(
+			AssetPack::levelBytes(sub.format, sub.width, sub.height));
+		sub.width  = AssetPack::nextLevel(sub.width);
+		sub.height = AssetPack::nextLevel(sub.height);
+	}
+	sub.numLevels = entry.numLevels - base;
+	*start        = levels;
+	return sub;
+}
+GLuint TextureResidency::startLevel(const PackEntry& entry)
+{
+	GLuint level = 0;
+	GLuint width = entry.width;
+	while(level + 1 < entry.numLevels && width > TEXTURE_RESIDENCY_MIN_WIDTH)
+	{
+		width = AssetPack::nextLevel(width);
+		level++;
+	}
+	return level;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TextureResidency::cleanUp                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void TextureResidency::cleanUp()
+{
+	textures.clear();
+	std::vector<GLuint>().swap(candidates);
+	residentBytes = 0;
+}
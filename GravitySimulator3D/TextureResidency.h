@@ -0,0 +1,137 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Bytes of texture arrays the bodies may keep on the graphics hardware,   *
+ * free layers included (changed with --texture-budget).                    */
+#define  TEXTURE_RESIDENCY_BUDGET                                   268435456
+/* Widest level a texture is loaded at, and evicted down to once out of     *
+ * sight (the whole texture if it is no wider).                             */
+#define  TEXTURE_RESIDENCY_MIN_WIDTH                                      256
+
+/******************************************************************************
+*                                                                             *
+*                          TextureResidency   (class)                         *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  textures                                                                   *
+*          Every managed texture by handle: its levels (in an asset pack, or  *
+*          kept here), the finest level resident, the layer being streamed    *
+*          to replace it (if any), the finest level asked for this frame,     *
+*          and the last frame it was asked for.                               *
+*  candidates                                                                 *
+*          Textures missed this frame which are to be promoted.               *
+*  budget / residentBytes                                                     *
+*          Bytes the texture arrays may take, and those the layers of the     *
+*          managed textures take now (including those still being streamed). *
+*  frame                                                                      *
+*          Frames updated.                                                    *
+*  numMisses / totalMisses                                                    *
+*          Textures drawn coarser than asked for, last frame and in all.      *
+*  numPromotions / numEvictions                                               *
+*          Textures moved to a finer level, and to a coarser one to free      *
+*          room.                                                              *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Keeps each body texture at the level its body needs on screen, within a   *
+*  budget of graphics memory, instead of every texture at full size.         *
+*                                                                             *
+*  A texture starts with the levels no wider than TEXTURE_RESIDENCY_MIN_WIDTH *
+*  resident. Each frame Display asks for the level matching the body's size   *
+*  on screen; asking for a finer level than the resident one is a miss, and   *
+*  update() streams the finer levels into a new layer (see TextureStream),    *
+*  swapping it in once complete. If that would go over budget, the least      *
+*  recently drawn textures are first moved down to a coarser layer: the one   *
+*  they were last asked for if still in sight, or the starting one if not.    *
+*                                                                             *
+*  The layers of a texture array all hold the same levels, so a texture is    *
+*  moved between arrays (keeping its handle) rather than its finer levels     *
+*  freed in place. Layers finer than the starting one get arrays of their    *
+*  own, so the arrays the budget is held against hold little but the layers  *
+*  in use. The levels of a texture loaded from an image stay in memory to be *
+*  streamed again; those in an asset pack are read from it.                   *
+*                                                                             *
+*  All calls must be made on the thread owning the GL context.                *
+*                                                                             *
+*******************************************************************************/
+class TextureResidency
+{
+public:
+	/* Reserve the starting layer of a texture and queue its levels, which  *
+	 * are read from memory outliving the texture (an asset pack) or else  *
+	 * taken from texels. Returns its handle (0 if it has none) and the     *
+	 * size of the layer.                                                   */
+	static GLuint  add(const PackEntry* entry, const unsigned char* levels,
+	                   std::vector<unsigned char>* texels = NULL,
+	                   GLuint64* bytes = NULL);
+	/* Stop managing a texture (before its layer is removed). */
+	static void    remove(GLuint handle);
+	/* Ask for a texture to cover pixels across its width this frame. */
+	static void    request(GLuint handle, GLfloat pixels);
+	/* Promote and evict for the frame just drawn. */
+	static void    update();
+	/* Forget every texture (their layers go with TextureArray). */
+	static void    cleanUp();
+
+	/* Setters. */
+	static void    setBudget(GLuint64 bytes)     {  budget = bytes;        }
+
+	/* Getters. */
+	static GLuint64 getBudget()                  {  return budget;         }
+	static GLuint64 getResidentBytes()           {  return residentBytes;  }
+	static GLuint64 getNumFrames()               {  return frame;          }
+	static GLuint  getNumMisses()                {  return numMisses;      }
+	static GLuint64 getTotalMisses()             {  return totalMisses;    }
+	static GLuint  getNumPromotions()            {  return numPromotions;  }
+	static GLuint  getNumEvictions()             {  return numEvictions;   }
+
+private:
+	struct Texture
+	{
+		PackEntry                  entry;
+		const unsigned char*       levels;
+		std::vector<unsigned char> texels;
+		GLuint                     base;
+		GLuint64                   bytes;
+		GLuint                     pending;
+		GLuint                     pendingBase;
+		GLuint64                   pendingBytes;
+		GLuint                     wanted;
+		GLuint64                   lastUsed;
+	};
+
+	/* Format, size and levels of a texture from level base down. */
+	static PackEntry fromLevel(const PackEntry& entry, const unsigned char* levels,
+	                           GLuint base, const unsigned char** start);
+	/* Level a texture starts at and is evicted down to. */
+	static GLuint  startLevel(const PackEntry& entry);
+	/* Move a texture to a coarser layer at once (false if it could not). */
+	static bool    evict(GLuint handle, Texture& texture, GLuint base);
+	/* Drop a texture's pending layer. */
+	static void    dropPending(Texture& texture);
+
+	static std::unordered_map<GLuint, Texture> textures;
+	static std::vector<GLuint> candidates;
+	static GLuint64            budget;
+	static GLuint64            residentBytes;
+	static GLuint64            frame;
+	static GLuint              numMisses;
+	static GLuint64            totalMisses;
+	static GLuint              numPromotions;
+	static GLuint              numEvictions;
+};
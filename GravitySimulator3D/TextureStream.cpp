@@ -0,0 +1,238 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "TextureStream.h"
+#include "TextureArray.h"
+#include <algorithm>
+#include <cstring>
+
+std::list<TextureStream::Job>     TextureStream::jobs;
+std::vector<TextureStream::Band>  TextureStream::bands;
+StreamBuffer                      TextureStream::pbo(GL_PIXEL_UNPACK_BUFFER);
+GLuint64                          TextureStream::numBytes    = 0;
+GLuint64                          TextureStream::numBands    = 0;
+GLuint                            TextureStream::numFinished = 0;
+
+/******************************************************************************
+*                                                                             *
+*                         TextureStream::queue / stream                       *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle                                                              *
+*           Texture reserved with TextureArray::reserve (stream only).        *
+*  @param entry                                                               *
+*           Format, size and number of mip levels of the texture.             *
+*  @param levels                                                              *
+*           Its mip levels, laid out as in an asset pack, if they stay put    *
+*           until uploaded (nullptr to take texels instead).                  *
+*  @param texels                                                              *
+*           Its mip levels otherwise, swapped out of the caller's vector.     *
+*  @param bytes                                                               *
+*           Set to the size of the layer on the graphics hardware.            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Handle of the texture, or 0 if there is none / void.                       *
+*                                                                             *
+*******************************************************************************/
+GLuint TextureStream::queue(const PackEntry* entry, const unsigned char* levels,
+                            std::vector<unsigned char>* texels, GLuint64* bytes)
+{
+	GLuint handle = TextureArray::reserve(entry, bytes);
+	if(handle != 0)
+		stream(handle, entry, levels, texels);
+	return handle;
+}
+void TextureStream::stream(GLuint handle, const PackEntry* entry,
+                           const unsigned char* levels,
+                           std::vector<unsigned char>* texels)
+{
+	jobs.push_back(Job());
+	Job& job       = jobs.back();
+	job.handle     = handle;
+	job.entry      = *entry;
+	job.levels     = levels;
+	job.numPending = entry->numLevels;
+	job.row        = 0;
+	if(levels == nullptr && texels != NULL)
+	{
+		job.texels.swap(*texels);
+		job.levels = job.texels.data();
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                         TextureStream::cancel / cleanUp                     *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param handle                                                              *
+*           Texture returned by queue() (which may have finished).            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void TextureStream::cancel(GLuint handle)
+{
+	for(std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+		if(it->handle == handle)
+		{
+			jobs.erase(it);
+			return;
+		}
+}
+void TextureStream::cleanUp()
+{
+	jobs.clear();
+	std::vector<Band>().swap(bands);
+	pbo.cleanUp();
+}
+
+/******************************************************************************
+*                                                                             *
+*                              TextureStream::plan                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param job                                                                 *
+*           Texture with levels left to upload, moved on past the band.       *
+*  @param budget / first                                                      *
+*           Bytes the band may take, and whether it is the frame's first      *
+*           (which gets one row of texels or blocks, even over the budget).   *
+*  @param band                                                                *
+*           Set to the rows to upload, and where they are.                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether a band fitted within the budget.                                   *
+*                                                                             *
+*******************************************************************************/
+bool TextureStream::plan(Job& job, GLuint64 budget, bool first, Band* band)
+{
+	const GLenum format = job.entry.format;
+	const GLuint level  = job.numPending - 1;
+	const GLuint width  = TextureArray::getLevelWidth(job.handle, level);
+	const GLuint height = TextureArray::getLevelHeight(job.handle, level);
+
+	/* Whole rows of texels, or of 4x4 blocks. */
+	const GLuint   unit      = format == GL_RGB ? 1 : 4;
+	const GLuint64 unitBytes = AssetPack::levelBytes(format, width, unit);
+	GLuint64 fit = budget / unitBytes * unit;
+	if(fit == 0 && !first)
+		return false;
+	fit = std::max<GLuint64>(fit, unit);
+
+	/* Find the level among the ones before it, largest first. */
+	const unsigned char* source = job.levels;
+	GLuint w = job.entry.width, h = job.entry.height;
+	for(GLuint i = 0; i < level; i++)
+	{
+		source += AssetPack::alignPack(AssetPack::levelBytes(format, w, h));
+		w       = AssetPack::nextLevel(w);
+		h       = AssetPack::nextLevel(h);
+	}
+
+	band->handle = job.handle;
+	band->level  = level;
+	band->y      = job.row;
+	band->rows   = (GLuint) std::min<GLuint64>(height - job.row, fit);
+	band->source = source + AssetPack::levelBytes(format, width, job.row);
+	band->bytes  = AssetPack::levelBytes(format, width, band->rows);
+
+	/* Move on to the next level down once this one is done. */
+	job.row += band->rows;
+	band->last = job.row >= height;
+	if(band->last)
+	{
+		job.numPending--;
+		job.row = 0;
+	}
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                             TextureStream::update                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Plans bands of rows up to the frame's budget, always from the texture      *
+*  with the coarsest level left, copies them into the next region of the     *
+*  buffer and uploads each from there. The uploads read the buffer on the     *
+*  card's time, after this returns; the fence put after them keeps the        *
+*  region from being written until they are done. A level is sampled from     *
+*  the frame its last band is uploaded in, which GL orders before the draws.  *
+*                                                                             *
+*******************************************************************************/
+void TextureStream::update()
+{
+	if(jobs.empty())
+		return;
+
+	/* Plan the frame's bands, coarsest levels first. */
+	bands.clear();
+	GLuint64 budget = TEXTURE_STREAM_BYTES;
+	GLuint64 total  = 0;
+	for(;;)
+	{
+		Job* next = nullptr;
+		for(Job& job : jobs)
+			if(job.numPending > 0 && (next == nullptr || job.numPending > next->numPending))
+				next = &job;
+		Band band;
+		if(next == nullptr || !plan(*next, budget, bands.empty(), &band))
+			break;
+		band.offset = total;
+		total      += AssetPack::alignPack(band.bytes);
+		budget     -= std::min(budget, band.bytes);
+		bands.push_back(band);
+		if(budget == 0)
+			break;
+	}
+
+	/* Copy them into this frame's region of the buffer. */
+	GLubyte* mapped = (GLubyte*) pbo.begin((GLsizeiptr) total);
+	for(const Band& band : bands)
+		memcpy(mapped + band.offset, band.source, (size_t) band.bytes);
+	const GLintptr base = pbo.end();
+
+	/* Upload them from it, then release the unpack binding so the other   *
+	 * uploads read client memory again.                                    */
+	for(const Band& band : bands)
+	{
+		TextureArray::uploadRows(band.handle, band.level, band.y, band.rows,
+			(const GLvoid*) (base + band.offset));
+		if(band.last)
+			TextureArray::setMinLevel(band.handle, band.level);
+		numBytes += band.bytes;
+	}
+	pbo.fence();
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	numBands += bands.size();
+
+	/* Drop the finished textures (and their texels). */
+	for(std::list<Job>::iterator it = jobs.begin(); it != jobs.end(); )
+	{
+		if(it->numPending == 0)
+		{
+			it = jobs.erase(it);
+			numFinished++;
+		}
+		else
+			++it;
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <list>
+#include <vector>
+#include "AssetPack.h"
+#include "StreamBuffer.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Texels uploaded per frame, in bytes (at least one band of rows is).      */
+#define  TEXTURE_STREAM_BYTES                                         4194304
+
+/******************************************************************************
+*                                                                             *
+*                            TextureStream   (class)                          *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  jobs                                                                       *
+*          Textures still being uploaded: the layer reserved for each, its    *
+*          levels (in an asset pack, or owned by the job), and the next       *
+*          level and row of it to be uploaded.                                *
+*  bands                                                                      *
+*          Rows planned for upload this frame (kept to reuse its storage).    *
+*  pbo                                                                        *
+*          Ring of pixel unpack buffers the rows are copied into.             *
+*  numBytes / numBands / numFinished                                          *
+*          Bytes and bands of rows uploaded, and textures completed.          *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Uploads textures a little at a time, so a large one loaded after the      *
+*  first frame does not hold the frame up while the driver copies it. A       *
+*  queued texture has its layer reserved at once (see TextureArray), and      *
+*  update() then copies up to TEXTURE_STREAM_BYTES of it each frame into the  *
+*  pixel unpack buffer, uploading them from there with glTexSubImage3D. The   *
+*  buffer is a StreamBuffer, so a region is only written again once the       *
+*  fence after the uploads reading it has passed.                             *
+*                                                                             *
+*  Levels go coarsest first, across every texture queued, so bodies appear    *
+*  blurred at once and sharpen as the finer levels arrive; until a texture    *
+*  is complete, the shader samples no finer than its finest level uploaded.   *
+*                                                                             *
+*  All calls must be made on the thread owning the GL context.                *
+*                                                                             *
+*******************************************************************************/
+class TextureStream
+{
+public:
+	/* Reserve a layer for a texture and queue its levels for upload,       *
+	 * returning its handle (0 if it has none) and the size of the layer.   *
+	 * The levels are read from memory which outlives the upload (an asset  *
+	 * pack), or else taken from texels.                                    */
+	static GLuint  queue(const PackEntry* entry, const unsigned char* levels,
+	                     std::vector<unsigned char>* texels = NULL,
+	                     GLuint64* bytes = NULL);
+	/* Queue the levels of a texture whose layer is already reserved. */
+	static void    stream(GLuint handle, const PackEntry* entry,
+	                      const unsigned char* levels,
+	                      std::vector<unsigned char>* texels = NULL);
+	/* Stop uploading a texture (before its layer is removed). */
+	static void    cancel(GLuint handle);
+	/* Upload this frame's share of the queued textures. */
+	static void    update();
+	/* Drop the queue and free the buffer (while the context is alive). */
+	static void    cleanUp();
+
+	/* Getters. */
+	static GLuint  getNumQueued()                {  return jobs.size();    }
+	static GLuint64 getNumBytes()                {  return numBytes;       }
+	static GLuint64 getNumBands()                {  return numBands;       }
+	static GLuint  getNumFinished()              {  return numFinished;    }
+	static const StreamBuffer& getBuffer()       {  return pbo;            }
+
+private:
+	struct Job
+	{
+		GLuint                     handle;
+		PackEntry                  entry;
+		const unsigned char*       levels;
+		std::vector<unsigned char> texels;
+		GLuint                     numPending;
+		GLuint                     row;
+	};
+	struct Band
+	{
+		GLuint                     handle;
+		GLuint                     level;
+		GLuint                     y;
+		GLuint                     rows;
+		bool                       last;
+		const unsigned char*       source;
+		GLuint64                   bytes;
+		GLuint64                   offset;
+	};
+
+	/* Plan the next band of rows of a job, within budget bytes. */
+	static bool    plan(Job& job, GLuint64 budget, bool first, Band* band);
+
+	static std::list<Job>      jobs;
+	static std::vector<Band>   bands;
+	static StreamBuffer        pbo;
+	static GLuint64            numBytes;
+	static GLuint64            numBands;
+	static GLuint              numFinished;
+};
@@ -0,0 +1,249 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Trail.h"
+
+/******************************************************************************
+*                                                                             *
+*                            Trail::Trail (Constructor)                       *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param capacity                                                            *
+*           Number of points the trail remembers.                             *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Creates an empty trail. The GL objects are created on the first upload,    *
+*  so trails can be made before there is a context.                           *
+*                                                                             *
+*******************************************************************************/
+Trail::Trail(GLuint capacity) :
+	points(capacity + 1),
+	capacity(capacity), newest(0), count(0), direction(0),
+	dirtyFirst(0), numDirty(0), bufferID(0), vertexArrayID(0)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 Trail::write                                *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param slot                                                                *
+*           Slot of the ring to be written (0 - capacity).                    *
+*  @param p                                                                   *
+*           Position to be stored.                                            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Stores the point (and its mirror, for slot 0) and grows the dirty range.   *
+*  Only the newest slot or the one after it is ever written, so the range     *
+*  stays contiguous.                                                          *
+*                                                                             *
+*******************************************************************************/
+void Trail::write(GLuint slot, const glm::vec3& p)
+{
+	points[slot] = p;
+	if(slot == 0)
+		points[capacity] = p;
+
+	if(numDirty == 0)
+	{
+		dirtyFirst = slot;
+		numDirty   = 1;
+	}
+	else if(slot == (dirtyFirst + numDirty) % capacity && numDirty < capacity)
+	{
+		numDirty++;
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                                 Trail::sample                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param p                                                                   *
+*           Current position of the body.                                     *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Adds the point to the trail. If the body is still heading (within          *
+*  TRAIL_STRAIGHT_COS) the way it was when the newest point was committed,    *
+*  the newest point is moved to p instead, so straight stretches cost two     *
+*  points however long they are and curves get points where they bend.       *
+*                                                                             *
+*******************************************************************************/
+void Trail::sample(const glm::vec3& p)
+{
+	/* First point. */
+	if(count == 0)
+	{
+		newest = 0;
+		count  = 1;
+		write(newest, p);
+		return;
+	}
+
+	/* The body has not moved. */
+	if(p == points[newest])
+		return;
+
+	/* Still on the same line: slide the newest point forward. */
+	if(count >= 2)
+	{
+		const glm::vec3& previous = points[(newest + capacity - 1) % capacity];
+		if(glm::dot(glm::normalize(p - previous), direction) >= TRAIL_STRAIGHT_COS)
+		{
+			write(newest, p);
+			return;
+		}
+	}
+
+	/* Commit a new point, overwriting the oldest once the ring is full. */
+	direction = glm::normalize(p - points[newest]);
+	newest    = (newest + 1) % capacity;
+	if(count < capacity)
+		count++;
+	write(newest, p);
+}
+
+/******************************************************************************
+*                                                                             *
+*                          Trail::upload / uploadRange                        *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param first, n                                                            *
+*           Slots to be sent (uploadRange only).                              *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Creates the vertex buffer (capacity + 1 points, never resized) and vertex  *
+*  array on the first call, then sends only the dirty range of the ring,      *
+*  split in two where it wraps, plus the mirror slot when slot 0 changed.     *
+*                                                                             *
+*******************************************************************************/
+void Trail::upload()
+{
+	if(vertexArrayID == 0)
+	{
+		glGenVertexArrays(1, &vertexArrayID);
+		glBindVertexArray(vertexArrayID);
+		glGenBuffers(1, &bufferID);
+		glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+		glBufferData(GL_ARRAY_BUFFER, (capacity + 1) * sizeof(glm::vec3),
+			NULL, GL_DYNAMIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+	}
+
+	if(numDirty == 0)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+	if(dirtyFirst + numDirty <= capacity)
+	{
+		uploadRange(dirtyFirst, numDirty);
+	}
+	else
+	{
+		uploadRange(dirtyFirst, capacity - dirtyFirst);
+		uploadRange(0, dirtyFirst + numDirty - capacity);
+	}
+	numDirty = 0;
+}
+void Trail::uploadRange(GLuint first, GLuint n)
+{
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3),
+		n * sizeof(glm::vec3), &points[first]);
+	if(first == 0)
+		glBufferSubData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3),
+			sizeof(glm::vec3), &points[capacity]);
+}
+
+/******************************************************************************
+*                                                                             *
+*                                  Trail::draw                                *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Draws the trail from the oldest to the newest point, as one line strip if  *
+*  the points are contiguous in the buffer and as two if they wrap.           *
+*                                                                             *
+*******************************************************************************/
+void Trail::draw() const
+{
+	if(count < 2 || vertexArrayID == 0)
+		return;
+
+	GLuint oldest = (newest + capacity + 1 - count) % capacity;
+	glBindVertexArray(vertexArrayID);
+	if(oldest + count <= capacity)
+	{
+		glDrawArrays(GL_LINE_STRIP, oldest, count);
+	}
+	else
+	{
+		/* Oldest to the mirror of slot 0, then slot 0 to the newest. */
+		glDrawArrays(GL_LINE_STRIP, oldest, capacity - oldest + 1);
+		glDrawArrays(GL_LINE_STRIP, 0, newest + 1);
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                                Trail::cleanUp                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+void Trail::cleanUp()
+{
+	if(vertexArrayID != 0)
+	{
+		glDeleteBuffers(1, &bufferID);
+		glDeleteVertexArrays(1, &vertexArrayID);
+	}
+	std::vector<glm::vec3>().swap(points);
+
+	bufferID      = 0;
+	vertexArrayID = 0;
+	count         = numDirty = 0;
+}
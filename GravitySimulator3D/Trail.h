@@ -0,0 +1,97 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <vector>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Number of past positions each trail remembers. */
+#define  TRAIL_CAPACITY                                                  2048
+/* Cosine of the largest bend still treated as a straight line (~0.5 deg). */
+#define  TRAIL_STRAIGHT_COS                                          0.99996f
+/* Default vertex and fragment shader source files for trails. */
+#define  TRAIL_VERTEX_SHADER                         "res/shaders/trail.vs"
+#define  TRAIL_FRAGMENT_SHADER                       "res/shaders/trail.fs"
+
+/******************************************************************************
+*                                                                             *
+*                                Trail   (class)                              *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  points                                                                     *
+*          Ring of capacity world-space positions, plus one mirror slot at    *
+*          the end which always holds a copy of slot 0. Owned by the trail,   *
+*          so it goes back to the heap with it.                               *
+*  newest / count                                                             *
+*          Slot of the most recent point and the number of points held.       *
+*  direction                                                                  *
+*          Direction from the previous point to the newest one when the       *
+*          newest was committed. Later samples within TRAIL_STRAIGHT_COS of   *
+*          it slide the newest point forward instead of adding a new one.     *
+*  dirtyFirst / numDirty                                                      *
+*          Range of slots written since the last upload (it may wrap).        *
+*  bufferID / vertexArrayID                                                   *
+*          GL objects holding the ring on the graphics card (created on the   *
+*          first upload).                                                     *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Fixed-size history of the positions of a body, drawn as a line strip.     *
+*  The vertex buffer is a copy of the ring, so each frame only the slots      *
+*  written since the previous frame are sent with glBufferSubData. Once the   *
+*  ring has wrapped, the strip is drawn in two pieces: oldest point to the    *
+*  mirror slot, then slot 0 to the newest point, which meet at slot 0.        *
+*                                                                             *
+*******************************************************************************/
+class Trail
+{
+public:
+	/* Constructor. */
+	               Trail(GLuint capacity = TRAIL_CAPACITY);
+
+	/* Record the current position of the body. */
+	void           sample(const glm::vec3& p);
+	/* Send the points written since the last call to the graphics card. */
+	void           upload();
+	/* Draw the trail with the currently bound program. */
+	void           draw()                const;
+	/* Free the points and the GL objects. */
+	void           cleanUp();
+
+	/* Forget every point (the body jumped). */
+	void           clear()                       {  count = numDirty = 0;  }
+
+	/* Getters. */
+	GLuint         getNumPoints()        const   {  return count;          }
+	GLuint         getCapacity()         const   {  return capacity;       }
+
+private:
+	/* Not copyable (owns its buffers). */
+	               Trail(const Trail& rhs);
+	Trail&         operator=(const Trail& rhs);
+
+	/* Write a point into a slot and remember that it must be uploaded. */
+	void           write(GLuint slot, const glm::vec3& p);
+	/* Send slots [first, first + n) of the ring (no wrap). */
+	void           uploadRange(GLuint first, GLuint n);
+
+	std::vector<glm::vec3> points;
+	GLuint         capacity;
+	GLuint         newest;
+	GLuint         count;
+	glm::vec3      direction;
+	GLuint         dirtyFirst;
+	GLuint         numDirty;
+	GLuint         bufferID;
+	GLuint         vertexArrayID;
+};
@@ -0,0 +1,666 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "Trajectory.h"
+#include <SDL\SDL.h>
+#include <cstring>
+#include <iostream>
+#include <chrono>
+#ifdef GS_USE_ZLIB
+#include <zlib.h>
+#endif
+
+/******************************************************************************
+*                                                                             *
+*                                      Macros                                 *
+*                                                                             *
+******************************************************************************/
+/* Columns holding the ids, the generations, the positions and the        *
+ * velocities.                                                              */
+#define  ID_COLUMN                                                          0
+#define  GENERATION_COLUMN                                                  1
+#define  POSITION_COLUMN                                                    2
+#define  VELOCITY_COLUMN                                                    5
+
+/******************************************************************************
+*                                                                             *
+*                     TrajectoryRecorder::TrajectoryRecorder                  *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************/
+TrajectoryRecorder::TrajectoryRecorder() :
+	flags(0), running(false), numFrames(0), numDropped(0), recordSeconds(0),
+	beginCounter(0)
+{
+	/* Empty. */
+}
+
+/******************************************************************************
+*                                                                             *
+*                          TrajectoryRecorder::open                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           File to be created (overwritten if it exists).                    *
+*  @param flags                                                               *
+*           TRAJECTORY_DELTA and/or TRAJECTORY_ZLIB. Compression is only      *
+*           available in builds with GS_USE_ZLIB defined.                     *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file could be created.                                         *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryRecorder::open(const char* path, GLuint flags)
+{
+	close();
+
+#ifndef GS_USE_ZLIB
+	if(flags & TRAJECTORY_ZLIB)
+		std::cerr << "Trajectory: built without zlib, recording uncompressed."
+		          << std::endl;
+	flags &= ~TRAJECTORY_ZLIB;
+#endif
+
+	file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!file)
+	{
+		std::cerr << "Trajectory: could not create " << path << std::endl;
+		return false;
+	}
+
+	TrajectoryHeader header = { TRAJECTORY_MAGIC, TRAJECTORY_VERSION, flags, 0 };
+	file.write((const char*) &header, sizeof(header));
+
+	/* Every frame buffer starts out free. */
+	TrajectoryFrame* f;
+	while(freeFrames.pop(&f));
+	while(fullFrames.pop(&f));
+	for(GLuint i = 0; i < RECORD_QUEUE_FRAMES; i++)
+		freeFrames.push(&frames[i]);
+
+	this->flags   = flags;
+	numFrames     = 0;
+	numDropped    = 0;
+	recordSeconds = 0;
+	index.clear();
+
+	running = true;
+	writer  = std::thread(&TrajectoryRecorder::writerLoop, this);
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                  TrajectoryRecorder::beginFrame / commitFrame               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param time                                                                *
+*           Simulation time of the frame (beginFrame only).                   *
+*  @param n                                                                   *
+*           Number of bodies in the frame (beginFrame only).                  *
+*  @param frame                                                               *
+*           Frame returned by beginFrame, filled in (commitFrame only).       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  A frame sized for n bodies, or nullptr if the writer has not given any     *
+*  back yet, in which case the frame is counted as dropped (beginFrame only). *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Called on the simulation thread. Neither call locks or waits; the frame    *
+*  vectors keep their capacity, so they only allocate when the system grows.  *
+*                                                                             *
+*******************************************************************************/
+TrajectoryFrame* TrajectoryRecorder::beginFrame(GLdouble time, GLuint n)
+{
+	TrajectoryFrame* frame;
+	if(!running || !freeFrames.pop(&frame))
+	{
+		numDropped++;
+		return nullptr;
+	}
+
+	beginCounter      = SDL_GetPerformanceCounter();
+	frame->time       = time;
+	frame->numBodies  = n;
+	frame->ids.resize(n);
+	frame->generations.resize(n);
+	frame->positions.resize(n);
+	frame->velocities.resize(n);
+	return frame;
+}
+void TrajectoryRecorder::commitFrame(TrajectoryFrame* frame)
+{
+	/* There are as many frames as queue slots, so this always fits. */
+	fullFrames.push(frame);
+	numFrames++;
+	recordSeconds += (GLdouble) (SDL_GetPerformanceCounter() - beginCounter) /
+	                 SDL_GetPerformanceFrequency();
+}
+
+/******************************************************************************
+*                                                                             *
+*                        TrajectoryRecorder::writerLoop                       *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Moves frames from the queue into the current chunk, writing the chunk out  *
+*  whenever it is full, until the recorder is closed and the queue is empty.  *
+*  Sleeps briefly when there is nothing to do, so that the simulation never   *
+*  has to signal it.                                                          *
+*                                                                             *
+*******************************************************************************/
+void TrajectoryRecorder::writerLoop()
+{
+	TrajectoryFrame* frame;
+	for(;;)
+	{
+		if(fullFrames.pop(&frame))
+		{
+			addFrame(frame);
+			freeFrames.push(frame);
+			if(times.size() == RECORD_FRAMES_PER_CHUNK)
+				flushChunk();
+		}
+		else if(running)
+		{
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(RECORD_IDLE_MILLIS));
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryRecorder::addFrame                        *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param frame                                                               *
+*           Frame to be appended to the current chunk.                        *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Splits the frame into its columns, XOR-ing each value with the same entry  *
+*  of the previous frame when delta coding applies (see Trajectory.h).        *
+*                                                                             *
+*******************************************************************************/
+void TrajectoryRecorder::addFrame(const TrajectoryFrame* frame)
+{
+	const GLuint n     = frame->numBodies;
+	const bool   delta = (flags & TRAJECTORY_DELTA) && !counts.empty() &&
+	                     counts.back() == n;
+
+	times.push_back(frame->time);
+	counts.push_back(n);
+
+	for(GLuint k = 0; k < TRAJECTORY_COLUMNS; k++)
+	{
+		std::vector<GLuint>& column = columns[k];
+		std::vector<GLuint>& last   = previous[k];
+		GLuint               base   = column.size();
+		column.resize(base + n);
+		last.resize(n);
+
+		for(GLuint i = 0; i < n; i++)
+		{
+			GLuint bits;
+			if(k == ID_COLUMN)
+				bits = frame->ids[i];
+			else if(k == GENERATION_COLUMN)
+				bits = frame->generations[i];
+			else if(k < VELOCITY_COLUMN)
+				memcpy(&bits, &frame->positions[i][k - POSITION_COLUMN], sizeof(bits));
+			else
+				memcpy(&bits, &frame->velocities[i][k - VELOCITY_COLUMN], sizeof(bits));
+
+			column[base + i] = delta ? (bits ^ last[i]) : bits;
+			last[i]          = bits;
+		}
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                        TrajectoryRecorder::flushChunk                       *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Lays the columns of the current chunk out one after the other, compresses  *
+*  them if asked to, writes the chunk, and records it in the index.           *
+*                                                                             *
+*******************************************************************************/
+void TrajectoryRecorder::flushChunk()
+{
+	if(times.empty())
+		return;
+
+	/* Columns, back to back. */
+	size_t bytes = times.size() * sizeof(GLdouble) + counts.size() * sizeof(GLuint);
+	for(GLuint k = 0; k < TRAJECTORY_COLUMNS; k++)
+		bytes += columns[k].size() * sizeof(GLuint);
+	payload.resize(bytes);
+
+	unsigned char* p = payload.data();
+	memcpy(p, times.data(), times.size() * sizeof(GLdouble));
+	p += times.size() * sizeof(GLdouble);
+	memcpy(p, counts.data(), counts.size() * sizeof(GLuint));
+	p += counts.size() * sizeof(GLuint);
+	for(GLuint k = 0; k < TRAJECTORY_COLUMNS; k++)
+	{
+		if(!columns[k].empty())
+			memcpy(p, columns[k].data(), columns[k].size() * sizeof(GLuint));
+		p += columns[k].size() * sizeof(GLuint);
+	}
+
+	TrajectoryChunkHeader header;
+	header.magic     = TRAJECTORY_CHUNK_MAGIC;
+	header.numFrames = times.size();
+	header.firstTime = times.front();
+	header.lastTime  = times.back();
+	header.flags     = flags;
+	header.rawBytes  = bytes;
+	header.reserved  = 0;
+
+	const unsigned char* stored = payload.data();
+	header.storedBytes          = bytes;
+#ifdef GS_USE_ZLIB
+	if(flags & TRAJECTORY_ZLIB)
+	{
+		uLongf packedBytes = compressBound(bytes);
+		packed.resize(packedBytes);
+		if(compress2(packed.data(), &packedBytes, payload.data(), bytes, 1) == Z_OK)
+		{
+			stored             = packed.data();
+			header.storedBytes = packedBytes;
+		}
+		else
+		{
+			header.flags &= ~TRAJECTORY_ZLIB;
+		}
+	}
+#endif
+
+	TrajectoryIndexEntry entry = { header.firstTime, header.lastTime,
+	                               (GLuint64) file.tellp() };
+	index.push_back(entry);
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) stored, header.storedBytes);
+
+	/* Start the next chunk (the vectors keep their capacity). */
+	times.clear();
+	counts.clear();
+	for(GLuint k = 0; k < TRAJECTORY_COLUMNS; k++)
+		columns[k].clear();
+}
+
+/******************************************************************************
+*                                                                             *
+*                          TrajectoryRecorder::close                          *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Lets the writer drain the queue, then writes the last (partial) chunk,     *
+*  the chunk index, and the trailer pointing at the index.                    *
+*                                                                             *
+*******************************************************************************/
+void TrajectoryRecorder::close()
+{
+	if(!running)
+		return;
+
+	running = false;
+	writer.join();
+	flushChunk();
+
+	TrajectoryTrailer trailer;
+	trailer.indexOffset = (GLuint64) file.tellp();
+	trailer.numChunks   = index.size();
+	trailer.magic       = TRAJECTORY_INDEX_MAGIC;
+	if(!index.empty())
+		file.write((const char*) index.data(),
+			index.size() * sizeof(TrajectoryIndexEntry));
+	file.write((const char*) &trailer, sizeof(trailer));
+	file.close();
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TrajectoryReader::open                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param path                                                                *
+*           Trajectory file to be read.                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the file is a readable trajectory.                                 *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryReader::open(const char* path)
+{
+	file.close();
+	file.clear();
+	file.open(path, std::ios::in | std::ios::binary);
+	if(!file)
+		return false;
+
+	TrajectoryHeader header;
+	file.read((char*) &header, sizeof(header));
+	if(!file || header.magic != TRAJECTORY_MAGIC ||
+	   header.version != TRAJECTORY_VERSION)
+	{
+		std::cerr << "Trajectory: " << path << " is not a trajectory file"
+		          << std::endl;
+		return false;
+	}
+
+	if(!loadIndex())
+		return false;
+
+	chunk     = 0;
+	frame     = 0;
+	numFrames = 0;
+	return index.empty() || loadChunk(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryReader::loadIndex                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether an index could be read or rebuilt.                                 *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryReader::loadIndex()
+{
+	index.clear();
+
+	file.seekg(0, std::ios::end);
+	GLuint64 size = (GLuint64) file.tellg();
+
+	/* The trailer, if the recording was closed properly. */
+	TrajectoryTrailer trailer;
+	if(size >= sizeof(TrajectoryHeader) + sizeof(trailer))
+	{
+		file.seekg(size - sizeof(trailer));
+		file.read((char*) &trailer, sizeof(trailer));
+		if(file && trailer.magic == TRAJECTORY_INDEX_MAGIC &&
+		   trailer.indexOffset + (GLuint64) trailer.numChunks *
+		   sizeof(TrajectoryIndexEntry) + sizeof(trailer) == size)
+		{
+			index.resize(trailer.numChunks);
+			file.seekg(trailer.indexOffset);
+			if(!index.empty())
+				file.read((char*) index.data(),
+					index.size() * sizeof(TrajectoryIndexEntry));
+			if(file)
+				return true;
+			index.clear();
+		}
+	}
+
+	/* Otherwise walk the chunks, keeping every complete one. */
+	file.clear();
+	GLuint64 offset = sizeof(TrajectoryHeader);
+	while(offset + sizeof(TrajectoryChunkHeader) <= size)
+	{
+		TrajectoryChunkHeader header;
+		file.seekg(offset);
+		file.read((char*) &header, sizeof(header));
+		if(!file || header.magic != TRAJECTORY_CHUNK_MAGIC ||
+		   offset + sizeof(header) + header.storedBytes > size)
+			break;
+
+		TrajectoryIndexEntry entry = { header.firstTime, header.lastTime, offset };
+		index.push_back(entry);
+		offset += sizeof(header) + header.storedBytes;
+	}
+	file.clear();
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryReader::loadChunk                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param c                                                                   *
+*           Index of the chunk to be decoded.                                 *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether the chunk could be read.                                           *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryReader::loadChunk(GLuint c)
+{
+	TrajectoryChunkHeader header;
+	file.seekg(index[c].offset);
+	file.read((char*) &header, sizeof(header));
+	if(!file || header.magic != TRAJECTORY_CHUNK_MAGIC)
+		return false;
+
+	packed.resize(header.storedBytes);
+	if(header.storedBytes > 0)
+		file.read((char*) packed.data(), header.storedBytes);
+	if(!file)
+		return false;
+
+	if(header.flags & TRAJECTORY_ZLIB)
+	{
+#ifdef GS_USE_ZLIB
+		uLongf rawBytes = header.rawBytes;
+		payload.resize(rawBytes);
+		if(uncompress(payload.data(), &rawBytes, packed.data(),
+		              header.storedBytes) != Z_OK || rawBytes != header.rawBytes)
+			return false;
+#else
+		std::cerr << "Trajectory: file is compressed, but this build has no zlib"
+		          << std::endl;
+		return false;
+#endif
+	}
+	else
+	{
+		payload.swap(packed);
+	}
+
+	/* Times and counts, once they are known to fit in the payload. */
+	const GLuint   f          = header.numFrames;
+	const GLuint64 frameBytes = (GLuint64) f * (sizeof(GLdouble) + sizeof(GLuint));
+	if(payload.size() != header.rawBytes || frameBytes > payload.size())
+		return false;
+	unsigned char* p = payload.data();
+	times.resize(f);
+	counts.resize(f);
+	starts.resize(f + 1);
+	memcpy(times.data(), p, f * sizeof(GLdouble));
+	p += f * sizeof(GLdouble);
+	memcpy(counts.data(), p, f * sizeof(GLuint));
+	p += f * sizeof(GLuint);
+
+	/* The columns must take up exactly the rest of it. */
+	GLuint64 total = 0;
+	for(GLuint i = 0; i < f; i++)
+		total += counts[i];
+	if(frameBytes + total * TRAJECTORY_COLUMNS * sizeof(GLuint) != payload.size())
+		return false;
+	starts[0] = 0;
+	for(GLuint i = 0; i < f; i++)
+		starts[i + 1] = starts[i] + counts[i];
+	const GLuint n = starts[f];
+
+	/* Columns, undoing the delta coding frame by frame. */
+	for(GLuint k = 0; k < TRAJECTORY_COLUMNS; k++)
+	{
+		std::vector<GLuint>& column = columns[k];
+		column.resize(n);
+		if(n > 0)
+			memcpy(column.data(), p, n * sizeof(GLuint));
+		p += n * sizeof(GLuint);
+
+		if(!(header.flags & TRAJECTORY_DELTA))
+			continue;
+		for(GLuint i = 1; i < f; i++)
+			if(counts[i] == counts[i - 1])
+				for(GLuint j = 0; j < counts[i]; j++)
+					column[starts[i] + j] ^= column[starts[i - 1] + j];
+	}
+
+	chunk     = c;
+	frame     = 0;
+	numFrames = f;
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                           TrajectoryReader::seek                            *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param t                                                                   *
+*           Simulation time to go to.                                         *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether there is a frame at or after t.                                    *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryReader::seek(GLdouble t)
+{
+	/* First chunk which ends at or after t. */
+	GLuint lo = 0, hi = index.size();
+	while(lo < hi)
+	{
+		GLuint mid = (lo + hi) / 2;
+		if(index[mid].lastTime < t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if(lo == index.size() || !loadChunk(lo))
+	{
+		frame = numFrames;
+		return false;
+	}
+
+	while(frame < numFrames && times[frame] < t)
+		frame++;
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryReader::readFrame                         *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param out                                                                 *
+*           Frame to be filled in.                                            *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Whether a frame was read (false at the end of the file).                   *
+*                                                                             *
+*******************************************************************************/
+bool TrajectoryReader::readFrame(TrajectoryFrame* out)
+{
+	while(frame >= numFrames)
+	{
+		if(chunk + 1 >= index.size() || !loadChunk(chunk + 1))
+			return false;
+	}
+
+	const GLuint n     = counts[frame];
+	const GLuint start = starts[frame];
+	out->time      = times[frame];
+	out->numBodies = n;
+	out->ids.resize(n);
+	out->generations.resize(n);
+	out->positions.resize(n);
+	out->velocities.resize(n);
+	for(GLuint i = 0; i < n; i++)
+	{
+		out->ids[i]         = columns[ID_COLUMN][start + i];
+		out->generations[i] = columns[GENERATION_COLUMN][start + i];
+		for(GLuint d = 0; d < 3; d++)
+		{
+			memcpy(&out->positions[i][d],  &columns[POSITION_COLUMN + d][start + i], sizeof(GLfloat));
+			memcpy(&out->velocities[i][d], &columns[VELOCITY_COLUMN + d][start + i], sizeof(GLfloat));
+		}
+	}
+	frame++;
+	return true;
+}
+
+/******************************************************************************
+*                                                                             *
+*                 TrajectoryReader::getStartTime / getEndTime                 *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  Time of the first / last frame in the file (0 if it is empty).             *
+*                                                                             *
+*******************************************************************************/
+GLdouble TrajectoryReader::getStartTime() const
+{
+	return index.empty() ? 0 : index.front().firstTime;
+}
+GLdouble TrajectoryReader::getEndTime() const
+{
+	return index.empty() ? 0 : index.back().lastTime;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "SpscQueue.h"
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+/* Magic numbers of the file, of each chunk, and of the trailing index. */
+#define  TRAJECTORY_MAGIC                                          0x4a545347
+#define  TRAJECTORY_CHUNK_MAGIC                                    0x4b4e4843
+#define  TRAJECTORY_INDEX_MAGIC                                    0x58444e49
+#define  TRAJECTORY_VERSION                                                 2
+/* Columns of a chunk: ids, generations, and the six float columns. */
+#define  TRAJECTORY_COLUMNS                                                 8
+/* Chunk flags: float columns XOR-delta coded / payload zlib compressed. */
+#define  TRAJECTORY_DELTA                                                 0x1
+#define  TRAJECTORY_ZLIB                                                  0x2
+/* Frames in flight between the simulation and the writer thread. */
+#define  RECORD_QUEUE_FRAMES                                               64
+/* Frames stored in each chunk of the file. */
+#define  RECORD_FRAMES_PER_CHUNK                                           64
+/* How long the writer sleeps when there is nothing to write. */
+#define  RECORD_IDLE_MILLIS                                                 1
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryFrame   (struct)                          *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  State of every body at one instant: the slot and generation of its handle  *
+*  (which together name the body, as a slot is reused once its body is        *
+*  removed), its position, and its velocity.                                  *
+*                                                                             *
+*******************************************************************************/
+struct TrajectoryFrame
+{
+	GLdouble                 time;
+	GLuint                   numBodies;
+	std::vector<GLuint>      ids;
+	std::vector<GLuint>      generations;
+	std::vector<glm::vec3>   positions;
+	std::vector<glm::vec3>   velocities;
+};
+
+/******************************************************************************
+*                                                                             *
+*                     Trajectory file layout   (structs)                      *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  A file is a TrajectoryHeader, a run of chunks, and a trailing index. Each  *
+*  chunk is a TrajectoryChunkHeader followed by its payload, which holds the  *
+*  columns of up to RECORD_FRAMES_PER_CHUNK frames:                           *
+*                                                                             *
+*      times[F] (double), counts[F], ids[N], generations[N],                  *
+*      px[N], py[N], pz[N], vx[N], vy[N], vz[N]                               *
+*                                                                             *
+*  where N is the total of counts. With TRAJECTORY_DELTA, every value of a    *
+*  frame after the first whose count matches the previous frame's is stored  *
+*  as its bits XOR the bits of the same entry in the previous frame; bodies   *
+*  move little between frames, so the high bits cancel out and the payload    *
+*  compresses well. Chunks never refer to each other, so any chunk can be     *
+*  decoded on its own. The index lists the time span and offset of every      *
+*  chunk, followed by a TrajectoryTrailer at the very end of the file.        *
+*                                                                             *
+*******************************************************************************/
+struct TrajectoryHeader
+{
+	GLuint                   magic;
+	GLuint                   version;
+	GLuint                   flags;
+	GLuint                   reserved;
+};
+struct TrajectoryChunkHeader
+{
+	GLuint                   magic;
+	GLuint                   numFrames;
+	GLdouble                 firstTime;
+	GLdouble                 lastTime;
+	GLuint                   flags;
+	GLuint                   rawBytes;
+	GLuint                   storedBytes;
+	GLuint                   reserved;
+};
+struct TrajectoryIndexEntry
+{
+	GLdouble                 firstTime;
+	GLdouble                 lastTime;
+	GLuint64                 offset;
+};
+struct TrajectoryTrailer
+{
+	GLuint64                 indexOffset;
+	GLuint                   numChunks;
+	GLuint                   magic;
+};
+
+/******************************************************************************
+*                                                                             *
+*                         TrajectoryRecorder   (class)                        *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  frames                                                                     *
+*          Frame buffers shared with the writer. The simulation takes one     *
+*          from freeFrames, fills it, and hands it over through fullFrames;   *
+*          the writer gives it back through freeFrames once it is encoded.    *
+*  chunk                                                                      *
+*          Columns of the chunk being built (writer thread only).             *
+*  numDropped                                                                 *
+*          Frames skipped because the writer had fallen behind.               *
+*  recordSeconds                                                              *
+*          Time the simulation thread has spent in beginFrame/commitFrame.    *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Streams frames to a trajectory file from a background thread. Handing a    *
+*  frame over takes no locks and never waits: if the writer is behind, the    *
+*  frame is dropped and counted instead of stalling the simulation.           *
+*                                                                             *
+*******************************************************************************/
+class TrajectoryRecorder
+{
+public:
+	/* Constructor. */
+	               TrajectoryRecorder();
+
+	/* Create the file and start the writer thread. */
+	bool           open(const char* path, GLuint flags = TRAJECTORY_DELTA);
+	/* Flush the last chunk, write the index, and stop the writer. */
+	void           close();
+
+	/* Get a frame for n bodies to fill (nullptr if it must be dropped). */
+	TrajectoryFrame* beginFrame(GLdouble time, GLuint n);
+	/* Hand the frame returned by beginFrame to the writer. */
+	void           commitFrame(TrajectoryFrame* frame);
+
+	/* Getters. */
+	bool           isOpen()              const   {  return running;        }
+	GLuint64       getNumFrames()        const   {  return numFrames;      }
+	GLuint64       getNumDropped()       const   {  return numDropped;     }
+	GLdouble       getRecordSeconds()    const   {  return recordSeconds;  }
+
+	/* Destructor. */
+	              ~TrajectoryRecorder()          {  close();               }
+
+private:
+	/* Not copyable (owns a thread). */
+	               TrajectoryRecorder(const TrajectoryRecorder& rhs);
+	TrajectoryRecorder& operator=(const TrajectoryRecorder& rhs);
+
+	/* Loop executed by the writer thread. */
+	void           writerLoop();
+	/* Append a frame to the current chunk. */
+	void           addFrame(const TrajectoryFrame* frame);
+	/* Encode and write the current chunk. */
+	void           flushChunk();
+
+	std::ofstream            file;
+	GLuint                   flags;
+	std::thread              writer;
+	std::atomic<bool>        running;
+
+	TrajectoryFrame          frames[RECORD_QUEUE_FRAMES];
+	SpscQueue<TrajectoryFrame*, RECORD_QUEUE_FRAMES> freeFrames;
+	SpscQueue<TrajectoryFrame*, RECORD_QUEUE_FRAMES> fullFrames;
+
+	/* Chunk being built. */
+	std::vector<GLdouble>    times;
+	std::vector<GLuint>      counts;
+	std::vector<GLuint>      columns[TRAJECTORY_COLUMNS];
+	std::vector<GLuint>      previous[TRAJECTORY_COLUMNS];
+	std::vector<unsigned char> payload;
+	std::vector<unsigned char> packed;
+	std::vector<TrajectoryIndexEntry> index;
+
+	GLuint64                 numFrames;
+	GLuint64                 numDropped;
+	GLdouble                 recordSeconds;
+	GLuint64                 beginCounter;
+};
+
+/******************************************************************************
+*                                                                             *
+*                          TrajectoryReader   (class)                         *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  index                                                                      *
+*          Time span and offset of every chunk, read from the end of the      *
+*          file, or rebuilt by walking the chunks if the recording was cut    *
+*          short before the index was written.                                *
+*  chunk / frame                                                              *
+*          Chunk currently decoded and the next frame to be read from it.     *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Reads a trajectory file frame by frame. seek() finds the chunk holding a   *
+*  given time with a binary search of the index, so only that chunk has to    *
+*  be read and decoded.                                                       *
+*                                                                             *
+*******************************************************************************/
+class TrajectoryReader
+{
+public:
+	/* Constructor. */
+	               TrajectoryReader()            :  chunk(0), frame(0),
+	                                                numFrames(0)           {}
+
+	/* Open a file and load its index. */
+	bool           open(const char* path);
+	/* Position on the first frame at or after time t. */
+	bool           seek(GLdouble t);
+	/* Read the next frame (false at the end of the file). */
+	bool           readFrame(TrajectoryFrame* out);
+
+	/* Getters. */
+	GLuint         getNumChunks()        const   {  return index.size();   }
+	GLdouble       getStartTime()        const;
+	GLdouble       getEndTime()          const;
+
+private:
+	/* Read the trailing index, or rebuild it from the chunk headers. */
+	bool           loadIndex();
+	/* Read and decode chunk c. */
+	bool           loadChunk(GLuint c);
+
+	std::ifstream            file;
+	std::vector<TrajectoryIndexEntry> index;
+	GLuint                   chunk;
+	GLuint                   frame;
+
+	/* Decoded columns of the current chunk. */
+	GLuint                   numFrames;
+	std::vector<GLdouble>    times;
+	std::vector<GLuint>      counts;
+	std::vector<GLuint>      starts;
+	std::vector<GLuint>      columns[TRAJECTORY_COLUMNS];
+	std::vector<unsigned char> payload;
+	std::vector<unsigned char> packed;
+};
@@ -0,0 +1,195 @@
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include "WorkerPool.h"
+#include "Memory.h"
+
+/******************************************************************************
+*                                                                             *
+*                       WorkerPool::WorkerPool (Constructor)                  *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param numWorkers                                                          *
+*           Total number of threads working on a batch, including the thread  *
+*           which calls run(). Clamped to [1, MAX_WORKERS].                   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Spawns numWorkers - 1 threads which sleep until a batch is submitted.      *
+*                                                                             *
+*******************************************************************************/
+WorkerPool::WorkerPool(GLuint numWorkers) :
+	numWorkers(numWorkers < 1 ? 1 :
+	          (numWorkers > MAX_WORKERS ? MAX_WORKERS : numWorkers)),
+	task(nullptr), context(nullptr), numTasks(0), nextTask(0),
+	busyWorkers(0), batch(0), quit(false), heapAllocations(0)
+{
+	/* The calling thread is worker 0, so spawn the rest. */
+	for(GLuint i = 1; i < this->numWorkers; i++)
+		threads.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+}
+
+/******************************************************************************
+*                                                                             *
+*                               WorkerPool::run                               *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param task                                                                *
+*           Function to be called once for every task index.                  *
+*  @param context                                                             *
+*           Pointer handed unchanged to every call of task.                   *
+*  @param numTasks                                                            *
+*           Number of task indices to run.                                    *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Runs every task of the batch on the pool (the caller helps out) and only   *
+*  returns once all of them have completed. Batches of a single task, or      *
+*  pools of a single worker, run inline without waking any threads.           *
+*                                                                             *
+*******************************************************************************/
+void WorkerPool::run(Task task, void* context, GLuint numTasks)
+{
+	/* Nothing to do. */
+	if(numTasks == 0)
+		return;
+
+	/* Not worth waking anybody up. */
+	if(threads.empty() || numTasks == 1)
+	{
+		for(GLuint i = 0; i < numTasks; i++)
+			task(context, i, 0);
+		return;
+	}
+
+	/* Publish the batch and wake the workers. */
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task     = task;
+		this->context  = context;
+		this->numTasks = numTasks;
+		nextTask       = 0;
+		busyWorkers    = (GLuint) threads.size();
+		batch++;
+	}
+	wake.notify_all();
+
+	/* Work on the batch from this thread as well. */
+	drain(0);
+
+	/* Wait for the stragglers. */
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+/******************************************************************************
+*                                                                             *
+*                              WorkerPool::drain                              *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param worker                                                              *
+*           Index of the worker claiming the tasks.                           *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Claims tasks of the current batch one at a time and runs them until the    *
+*  batch is exhausted.                                                        *
+*                                                                             *
+*******************************************************************************/
+void WorkerPool::drain(GLuint worker)
+{
+	GLuint i;
+	while((i = nextTask++) < numTasks)
+		task(context, i, worker);
+}
+
+/******************************************************************************
+*                                                                             *
+*                            WorkerPool::workerLoop                           *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  @param worker                                                              *
+*           Index of this worker thread (1 - numWorkers-1).                   *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Sleeps until a new batch is published, helps drain it, and reports back    *
+*  once it runs out of tasks. Returns when the pool is destroyed.             *
+*                                                                             *
+*******************************************************************************/
+void WorkerPool::workerLoop(GLuint worker)
+{
+	GLuint seen = 0;
+	for(;;)
+	{
+		/* Wait for a new batch (or for the pool to shut down). */
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, &seen] { return quit || batch != seen; });
+			if(quit)
+				return;
+			seen = batch;
+		}
+
+		/* Help out with the batch, counting what it takes from the heap. */
+		GLuint64 before = Memory::getHeapAllocations();
+		drain(worker);
+		GLuint64 allocations = Memory::getHeapAllocations() - before;
+
+		/* Let run() know this worker is done. */
+		std::lock_guard<std::mutex> lock(mutex);
+		heapAllocations += allocations;
+		if(--busyWorkers == 0)
+			done.notify_one();
+	}
+}
+
+/******************************************************************************
+*                                                                             *
+*                      WorkerPool::~WorkerPool (Destructor)                   *
+*                                                                             *
+*******************************************************************************
+* PARAMETERS                                                                  *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* RETURNS                                                                     *
+*  void                                                                       *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Tells the workers to quit and joins them.                                  *
+*                                                                             *
+*******************************************************************************/
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for(std::thread& t : threads)
+		t.join();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+/******************************************************************************
+*                                                                             *
+*                              Included Header Files                          *
+*                                                                             *
+******************************************************************************/
+#include <GL\glew.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+/******************************************************************************
+*                                                                             *
+*                           Defined Constants / Macros                        *
+*                                                                             *
+******************************************************************************/
+#define  MAX_WORKERS                                                      256
+
+/******************************************************************************
+*                                                                             *
+*                             WorkerPool   (class)                            *
+*                                                                             *
+*******************************************************************************
+* MEMBERS                                                                     *
+*  threads                                                                    *
+*          Persistent worker threads (one less than numWorkers, since the     *
+*          calling thread always takes part in the work).                     *
+*  task / context / numTasks                                                  *
+*          The batch currently being run: a plain function pointer, the data  *
+*          it operates on, and the number of task indices to hand out.        *
+*  nextTask                                                                   *
+*          Index of the next unclaimed task in the current batch.             *
+*  busyWorkers                                                                *
+*          Number of worker threads still inside the current batch.           *
+*  batch                                                                      *
+*          Counter which is bumped for every batch to wake up the workers.    *
+*  heapAllocations                                                            *
+*          Global operator new calls made by the worker threads inside        *
+*          batches (the calling thread counts its own; see Memory).           *
+*                                                                             *
+*******************************************************************************
+* DESCRIPTION                                                                 *
+*  Fixed-size pool of threads which runs batches of independent tasks. Tasks  *
+*  are handed out dynamically, so which worker runs which task depends on     *
+*  scheduling; callers which need reproducible results must make the result   *
+*  of each task independent of the worker index. Tasks are plain function     *
+*  pointers so that dispatching a batch never touches the heap.               *
+*                                                                             *
+*******************************************************************************/
+class WorkerPool
+{
+public:
+	/* Signature of a task: (context, task index, worker index). */
+	typedef void (*Task)(void* context, GLuint task, GLuint worker);
+
+	/* Constructor. */
+	               WorkerPool(GLuint numWorkers);
+
+	/* Run tasks [0, numTasks) and wait for all of them to finish. */
+	void           run(Task task, void* context, GLuint numTasks);
+
+	/* Getters. */
+	GLuint         getNumWorkers()       const   {  return numWorkers;     }
+	/* Read between batches only. */
+	GLuint64       getHeapAllocations()  const   {  return heapAllocations; }
+
+	/* Destructor. */
+	              ~WorkerPool();
+
+private:
+	/* Not copyable (owns threads). */
+	               WorkerPool(const WorkerPool& rhs);
+	WorkerPool&    operator=(const WorkerPool& rhs);
+
+	/* Loop executed by each of the worker threads. */
+	void           workerLoop(GLuint worker);
+	/* Claim and execute tasks of the current batch until none are left. */
+	void           drain(GLuint worker);
+
+	GLuint                   numWorkers;
+	std::vector<std::thread> threads;
+	std::mutex               mutex;
+	std::condition_variable  wake;
+	std::condition_variable  done;
+	Task                     task;
+	void*                    context;
+	GLuint                   numTasks;
+	std::atomic<GLuint>      nextTask;
+	GLuint                   busyWorkers;
+	GLuint                   batch;
+	bool                     quit;
+	GLuint64                 heapAllocations;
+};
@@ -0,0 +1,13 @@
+#version 130
+
+precision highp float;
+
+uniform sampler2DArray textures;
+uniform float textureLayer;
+
+varying vec2 outTexCoord;
+
+void main()
+{
+	gl_FragColor = texture(textures, vec3(outTexCoord, textureLayer));
+}
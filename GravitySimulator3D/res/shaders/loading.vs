@@ -0,0 +1,14 @@
+#version 130
+
+precision highp float;
+
+attribute vec4 modelPosition;
+attribute vec2 modelTexCoord;
+
+varying vec2 outTexCoord;
+
+void main()
+{
+	gl_Position = modelPosition;
+	outTexCoord = modelTexCoord;
+}
@@ -0,0 +1,40 @@
+#version 130
+
+precision highp float;
+
+uniform mat4 viewToProjectionMatrix;
+uniform vec3 lightSource;
+uniform vec4 ambientLight;
+uniform vec4 particleColor;
+uniform float impostorSize;
+
+varying vec3 outCenter;
+varying float outRadius;
+varying float outSize;
+
+void main()
+{
+	vec2 p = gl_PointCoord * 2.0 - 1.0;
+	p.y = -p.y;
+	float r2 = dot(p, p);
+	if (r2 > 1.0)
+		discard;
+
+	/* Too small to resolve: a flat dot. */
+	if (outSize < impostorSize)
+	{
+		gl_FragColor = particleColor;
+		gl_FragDepth = gl_FragCoord.z;
+		return;
+	}
+
+	/* Ray cast the sphere: light and depth of its surface under this point. */
+	vec3 normal = vec3(p, sqrt(1.0 - r2));
+	vec3 surface = outCenter + normal * outRadius;
+	vec4 clip = viewToProjectionMatrix * vec4(surface, 1.0);
+	gl_FragDepth = 0.5 * clip.z / clip.w + 0.5;
+
+	float brightness = clamp(dot(normal, normalize(lightSource - surface)), 0.0, 1.0);
+	vec4 diffuseLight = vec4(brightness, brightness, brightness, 1.0);
+	gl_FragColor = particleColor * (ambientLight + diffuseLight);
+}
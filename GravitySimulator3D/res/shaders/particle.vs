@@ -0,0 +1,28 @@
+#version 130
+
+precision highp float;
+
+uniform mat4 worldToViewMatrix;
+uniform mat4 viewToProjectionMatrix;
+uniform float pixelScale;
+uniform float minPointSize;
+
+/* Position of the body, and its radius in w. */
+attribute vec4 modelPosition;
+
+varying vec3 outCenter;
+varying float outRadius;
+varying float outSize;
+
+void main()
+{
+	vec4 center = worldToViewMatrix * vec4(modelPosition.xyz, 1.0);
+	gl_Position = viewToProjectionMatrix * center;
+
+	/* Diameter on screen, from the radius and the distance. */
+	outSize = 2.0 * modelPosition.w * pixelScale / max(-center.z, 0.001);
+	gl_PointSize = max(outSize, minPointSize);
+
+	outCenter = center.xyz;
+	outRadius = modelPosition.w;
+}
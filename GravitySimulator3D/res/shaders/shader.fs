@@ -2,7 +2,7 @@
 
 precision highp float;
 
-uniform sampler2D texture;
+uniform sampler2DArray textures;
 uniform vec3 lightSource;
 uniform vec4 ambientLight;
 
@@ -10,11 +10,21 @@ varying vec4 outPosition;
 varying vec3 outColor;
 varying vec2 outTexCoord;
 varying vec3 outNormal;
+varying vec2 outLayer;
 
 void main()
 {
 	vec3 worldLight = normalize(lightSource - vec3(outPosition));
 	float brightness = clamp(dot(outNormal, worldLight), 0.0, 1.0);
 	vec4 diffuseLight = vec4(brightness, brightness, brightness, 1.0);
-	gl_FragColor = texture2D (texture, outTexCoord) * (ambientLight + diffuseLight);
+
+	/* Sample no finer than the finest level streamed in so far. */
+	vec2 texels = outTexCoord * vec2(textureSize(textures, 0).xy);
+	vec2 dx = dFdx(texels);
+	vec2 dy = dFdy(texels);
+	float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+	vec4 texel = outLayer.y > 0.0 ?
+		textureLod(textures, vec3(outTexCoord, outLayer.x), max(lod, outLayer.y)) :
+		texture(textures, vec3(outTexCoord, outLayer.x));
+	gl_FragColor = texel * (ambientLight + diffuseLight);
 }
@@ -2,25 +2,28 @@
 
 precision highp float;
 
-uniform mat4 modelToProjectionMatrix;
-uniform mat4 modelToWorldMatrix;
+uniform mat4 worldToProjectionMatrix;
 
 attribute vec4 modelPosition;
 attribute vec3 modelColor;
 attribute vec3 modelNormal;
 attribute vec2 modelTexCoord;
+attribute mat4 modelToWorldMatrix;
+attribute vec2 textureLayer;
 
 varying vec4 outPosition;
 varying vec3 outColor;
 varying vec2 outTexCoord;
 varying vec3 outNormal;
+varying vec2 outLayer;
 
 void main()
 {
-	gl_Position = modelToProjectionMatrix * modelPosition;
 	outPosition = modelToWorldMatrix * modelPosition;
+	gl_Position = worldToProjectionMatrix * outPosition;
 
 	outTexCoord = modelTexCoord;
+	outLayer = textureLayer;
 
 	outColor = modelColor;
 
@@ -0,0 +1,10 @@
+#version 130
+
+precision highp float;
+
+uniform vec4 trailColor;
+
+void main()
+{
+	gl_FragColor = trailColor;
+}
@@ -0,0 +1,12 @@
+#version 130
+
+precision highp float;
+
+uniform mat4 worldToProjectionMatrix;
+
+attribute vec4 modelPosition;
+
+void main()
+{
+	gl_Position = worldToProjectionMatrix * modelPosition;
+}